@@ -43,3 +43,196 @@ kernel void downsample
     write_imagef(albedoDest, (int4)coord, convert_float4(albedoAvg));
     write_imagef(normalDest, (int4)coord, convert_float4(normalAvg));
 }
+
+//octahedral normals (see VoxelFormat.h) can't be averaged as they're stored, every texel is decoded, averaged and
+//encoded back.  These mirror VoxelFormat::decodeNormal() and VoxelFormat::encodeNormal()
+
+static float3 octahedralDecode(float2 e)
+{
+    float3 n = (float3)(e.x, e.y, 1.0f - fabs(e.x) - fabs(e.y));
+    float t = fmax(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+static float2 octahedralEncode(float3 n)
+{
+    n /= fabs(n.x) + fabs(n.y) + fabs(n.z);
+    float2 signs = (float2)(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return n.z < 0.0f ? (1.0f - fabs(n.yx)) * signs : n.xy;
+}
+
+static float4 decodeNormal(float4 texel)
+{
+    if(texel.w <= 0.0f)
+        return (float4)(0.0f);
+    
+    float2 encoded = clamp(texel.xy / texel.w * 2.0f - 1.0f, -1.0f, 1.0f);
+    return (float4)(octahedralDecode(encoded) * texel.z, texel.w);
+}
+
+static float4 encodeNormal(float4 value)
+{
+    float coverage = clamp(value.w, 0.0f, 1.0f);
+    float len = length(value.xyz);
+    if(coverage <= 0.0f || len <= 0.0f)
+        return (float4)(0.5f * coverage, 0.5f * coverage, 0.0f, coverage);
+    
+    float2 direction = (octahedralEncode(value.xyz / len) * 0.5f + 0.5f) * coverage;
+    return (float4)(direction, fmin(len, 1.0f), coverage);
+}
+
+static float4 getOctahedralAverage(read_only image3d_t source, const sampler_t sampler, int4 coord)
+{
+    float4 value = (float4)(0.0f);
+    for(int i = 0; i < 8; ++i)
+    {
+        int4 child = (int4)(coord.x * 2 + (i & 1), coord.y * 2 + ((i >> 1) & 1), coord.z * 2 + (i >> 2), 1);
+        value += decodeNormal(read_imagef(source, sampler, child));
+    }
+    
+    return encodeNormal(value * 0.125f);
+}
+
+kernel void downsampleOctahedral
+(
+    read_only image3d_t albedo,
+    read_only image3d_t normal,
+
+    write_only image3d_t albedoDest,
+    write_only image3d_t normalDest
+
+)
+{
+    int4 coord;
+    coord.x = (int)get_global_id(0);
+    coord.y = (int)get_global_id(1);
+    coord.z = (int)get_global_id(2);
+    coord.w = 1;
+
+    write_imagef(albedoDest, coord, getAverage(albedo, sampler, coord));
+    write_imagef(normalDest, coord, getOctahedralAverage(normal, sampler, coord));
+}
+
+//six directional albedo mips, see AnisotropicMips.h.  A level is six times as wide as it is tall, +x, -x, +y, -y, +z
+//and -z side by side along x.  Every column of a 2x2x2 block is composited front to back along the direction and the
+//four columns averaged, in the same order as AnisotropicMips::filter().  Levels past the first read the same
+//direction of the level above, the first reads the isotropic base
+
+static float4 composite(float4 front, float4 back)
+{
+    return front + (1.0f - front.w) * back;
+}
+
+static float4 getDirectional(read_only image3d_t source, const sampler_t sampler, int4 coord, int direction, int sourceOffset)
+{
+    //positive directions enter a block through its lower half, negative ones through its upper half
+    int axis = direction / 2;
+    int front = direction & 1;
+    
+    float4 sum = (float4)(0.0f);
+    for(int column = 0; column < 4; ++column)
+    {
+        int along[3] = { 0, 0, 0 };
+        along[axis] = front;
+        along[(axis + 1) % 3] = column & 1;
+        along[(axis + 2) % 3] = column >> 1;
+        int4 first = (int4)(coord.x * 2 + along[0] + sourceOffset, coord.y * 2 + along[1], coord.z * 2 + along[2], 1);
+        
+        int4 second = first;
+        if(axis == 0) second.x += front ? -1 : 1;
+        else if(axis == 1) second.y += front ? -1 : 1;
+        else second.z += front ? -1 : 1;
+        
+        sum += composite(read_imagef(source, sampler, first), read_imagef(source, sampler, second));
+    }
+    return sum * 0.25f;
+}
+
+kernel void downsampleAnisotropic
+(
+    read_only image3d_t albedo,
+    read_only image3d_t normal,
+
+    write_only image3d_t albedoDest,
+    write_only image3d_t normalDest,
+
+    int directionalSource,
+    int octahedralNormals
+)
+{
+    int4 coord;
+    coord.x = (int)get_global_id(0);
+    coord.y = (int)get_global_id(1);
+    coord.z = (int)get_global_id(2);
+    coord.w = 1;
+
+    int dimensions = get_image_height(albedoDest);
+    int sourceDimensions = get_image_height(albedo);
+    for(int direction = 0; direction < 6; ++direction)
+    {
+        int4 destination = (int4)(coord.x + direction * dimensions, coord.y, coord.z, 1);
+        int sourceOffset = directionalSource ? direction * sourceDimensions : 0;
+        write_imagef(albedoDest, destination, getDirectional(albedo, sampler, coord, direction, sourceOffset));
+    }
+    
+    write_imagef(normalDest, coord, octahedralNormals ? getOctahedralAverage(normal, sampler, coord) : getAverage(normal, sampler, coord));
+}
+
+//occupancy pyramid, see OccupancyGrid.h.  One dispatch per level over the whole packed texture: the level's cells are
+//rebuilt, from the voxels' alpha for level 1 and from the level below in source past it, and every other texel is
+//copied over, so two textures can take turns being source and destination
+kernel void buildOccupancy
+(
+    read_only image3d_t albedo,
+    read_only image3d_t source,
+
+    write_only image3d_t destination,
+
+    int level
+)
+{
+    int4 coord;
+    coord.x = (int)get_global_id(0);
+    coord.y = (int)get_global_id(1);
+    coord.z = (int)get_global_id(2);
+    coord.w = 1;
+
+    int dimensions = get_image_width(destination);
+    int side = dimensions >> level;
+    int4 cell = (int4)(coord.x - (dimensions - 2 * side), coord.y, coord.z, 1);
+    if(cell.x < 0 || cell.x >= side || cell.y >= side || cell.z >= side)
+    {
+        write_imageui(destination, coord, read_imageui(source, sampler, coord));
+        return;
+    }
+
+    uint value = 0;
+    if(level == 1)
+    {
+        for(int bit = 0; bit < 8; ++bit)
+        {
+            int4 voxel = (int4)(cell.x * 2 + (bit & 1), cell.y * 2 + ((bit >> 1) & 1), cell.z * 2 + (bit >> 2), 1);
+            if(read_imagef(albedo, sampler, voxel).w != 0.0f)
+            {
+                value |= 1u << bit;
+            }
+        }
+    }
+    else
+    {
+        //OCCUPIED if any child holds something, FULL if every child is full
+        int childOffset = dimensions - 4 * side;
+        uint occupied = 0, full = 1;
+        for(int child = 0; child < 8; ++child)
+        {
+            int4 texel = (int4)(childOffset + cell.x * 2 + (child & 1), cell.y * 2 + ((child >> 1) & 1), cell.z * 2 + (child >> 2), 1);
+            uint childValue = read_imageui(source, sampler, texel).x;
+            occupied |= childValue != 0 ? 1u : 0u;
+            full &= (level == 2 ? childValue == 0xFFu : (childValue & 2u) != 0) ? 1u : 0u;
+        }
+        value = occupied | (full << 1);
+    }
+    write_imageui(destination, coord, (uint4)(value, 0, 0, 0));
+}
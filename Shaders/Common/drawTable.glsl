@@ -0,0 +1,27 @@
+
+// The mesh a vertex belongs to, fetched from DrawList's table, see Source/Shape/DrawList.h.  Vertex shaders only,
+// include it after uniformBlocks.glsl and call fetchDraw() before using M, material or drawID.
+
+layout(location = 3) in uint drawIndex;
+
+// Eight RGBA32F texels per mesh, laid out like UniformBlocks::Draw.
+uniform samplerBuffer drawTable;
+
+mat4     M;
+Material material;
+uint     drawID; // Position of the mesh in the scene, what the geometry buffer identifies meshes by.
+
+void fetchDraw()
+{
+    int base = int(drawIndex) * 8;
+    M = mat4(texelFetch(drawTable, base),
+             texelFetch(drawTable, base + 1),
+             texelFetch(drawTable, base + 2),
+             texelFetch(drawTable, base + 3));
+    
+    vec4 diffuse = texelFetch(drawTable, base + 4);
+    vec4 specular = texelFetch(drawTable, base + 5);
+    vec4 properties = texelFetch(drawTable, base + 6);
+    material = Material(diffuse.rgb, diffuse.a, specular.rgb, specular.a, properties.x, properties.y, properties.z, properties.w);
+    drawID = drawIndex;
+}
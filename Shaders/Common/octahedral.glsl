@@ -0,0 +1,19 @@
+
+// Octahedral mapping of unit vectors onto [-1, 1]^2, mirrors VoxelFormat::octahedralEncode() and
+// VoxelFormat::octahedralDecode().  "Compute Shaders/downsize.cl" keeps its own copy for the mip maps.
+
+vec2 octahedralEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 signs = vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return n.z < 0.0f ? (1.0f - abs(n.yx)) * signs : n.xy;
+}
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
@@ -0,0 +1,39 @@
+// std140 blocks shared by every shader that includes this file, see Source/Graphic/Material/UniformBlocks.h for the
+// C++ side and the binding points.  Keep the two in sync.
+
+#define MAX_LIGHTS 1
+#define NUM_SAMPLING_RAYS 5
+#define NUM_MIP_MAPS 7
+
+struct PointLight {
+    vec3 position;
+    vec3 color;
+};
+
+// Basic material, per mesh in drawTable.glsl.
+struct Material {
+    vec3 diffuseColor;
+    float diffuseReflectivity;
+    vec3 specularColor;
+    float specularDiffusion; // "Reflective and refractive" specular diffusion.
+    float specularReflectivity;
+    float emissivity; // Emissive materials uses diffuse color as emissive color.
+    float refractiveIndex;
+    float transparency;
+};
+
+// Uploaded once per pass.
+layout(std140) uniform FrameBlock
+{
+    mat4       V;
+    mat4       P;
+    mat4       voxViewProjection;
+    vec3       cameraPosition; // World campera position.
+    float      voxelDimensionsInWorldSpace;
+    PointLight pointLights[MAX_LIGHTS];
+    vec3       samplingRays[NUM_SAMPLING_RAYS];
+    float      coneVariances[NUM_MIP_MAPS];
+    int        numberOfLights; // Number of lights currently uploaded.
+    uint       numberOfLods;
+    bool       octahedralNormals; //see VoxelFormat.h, the brick pool atlas always holds plain normals
+};
@@ -6,8 +6,10 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 
-uniform mat4 MVP;
-uniform vec3 diffuseColor;
+#include "Common/uniformBlocks.glsl"
+#include "Common/drawTable.glsl"
+
+uniform mat4 VP; // the peeling camera's, the model matrix comes from the draw table
 
 out vec3 diffuseColorFrag;
 out vec3 normalFrag;
@@ -16,10 +18,11 @@ noperspective out vec4 projectedPosition;
 
 void main()
 {
-    gl_Position = MVP * vec4(position, 1);
+    fetchDraw();
+    gl_Position = VP * M * vec4(position, 1);
     
     projectedPosition = gl_Position;
-    diffuseColorFrag = diffuseColor;
+    diffuseColorFrag = material.diffuseColor;
     normalFrag = normal;
 }
 
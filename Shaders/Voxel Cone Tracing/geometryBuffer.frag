@@ -0,0 +1,21 @@
+// What's visible at every pixel, for the passes that shade and trace once per pixel instead of once per fragment.
+// See VoxelConeTracingRT.h
+
+#version 410 core
+
+#include "Common/uniformBlocks.glsl"
+
+in vec3 worldPosition;
+in vec3 normalFrag;
+flat in vec3 diffuseColorFrag;
+flat in uint drawIDFrag;
+
+//world positions are rebuilt from the view depth, which keeps the geometry buffer at two targets
+layout(location = 0) out vec4 normalDepth;  //w: view depth, 0 where nothing was drawn
+layout(location = 1) out vec4 albedo;       //a: draw id + 1, which mesh and VoxProperties the pixel belongs to
+
+void main()
+{
+    normalDepth = vec4(normalFrag, -(V * vec4(worldPosition, 1.0f)).z);
+    albedo = vec4(diffuseColorFrag, float(drawIDFrag + 1u));
+}
@@ -4,26 +4,9 @@
 
 #version 410 core
 
-#define NUM_SAMPLING_RAYS 5
-#define NUM_MIP_MAPS 7
-#define MAX_LIGHTS 1
-
-struct PointLight {
-    vec3 position;
-    vec3 color;
-};
-
-// Basic material.
-struct Material {
-    vec3 diffuseColor;
-    float diffuseReflectivity;
-    vec3 specularColor;
-    float specularDiffusion; // "Reflective and refractive" specular diffusion.
-    float specularReflectivity;
-    float emissivity; // Emissive materials uses diffuse color as emissive color.
-    float refractiveIndex;
-    float transparency;
-};
+// camera, lights, voxel transform and cone table come from here
+#include "Common/uniformBlocks.glsl"
+#include "Common/octahedral.glsl"
 
 //struct Settings {
 //    bool indirectSpecularLight; // Whether indirect specular light should be rendered or not.
@@ -32,24 +15,30 @@ struct Material {
 //    bool shadows; // Whether shadows should be rendered or not.
 //};
 
-uniform PointLight pointLights[MAX_LIGHTS];
-uniform int numberOfLights; // Number of lights currently uploaded.
-uniform vec3 cameraPosition; // World campera position.
-
 uniform vec3    lightPosition;
 
+#ifdef SPARSE_BRICK_POOL
+#define BRICK_SIZE 8.0f
+//see BrickPool.h
+uniform sampler3D pageTable;
+uniform sampler3D albedoAtlas;
+uniform sampler3D normalAtlas;
+uniform vec3      atlasSize;
+uniform vec2      brickLevels[NUM_MIP_MAPS]; //x: first page table column of the level, y: voxels per side
+#elif defined(CLIPMAP_CASCADES)
+#define NUM_CASCADES 4
+//see ClipmapVoxelizeRT.h, textures wrap with GL_REPEAT so world space / window size addresses them directly
+uniform sampler3D albedoCascades[NUM_CASCADES];
+uniform sampler3D normalCascades[NUM_CASCADES];
+uniform vec4      cascadeWindows[NUM_CASCADES]; //xyz: world space min corner, w: world space size
+#else
 uniform sampler3D normalMipMaps[NUM_MIP_MAPS];
 uniform sampler3D albedoMipMaps[NUM_MIP_MAPS];
-uniform vec3      samplingRays[NUM_SAMPLING_RAYS];
+//see AnisotropicMips.h, past the base level every albedo mip is six volumes side by side along x: +x, -x, +y, -y, +z, -z
+uniform bool      anisotropicMipMaps;
+#endif
 
 uniform mat4    toVoxelSpace;
-uniform mat4    voxViewProjection;
-uniform float   voxelDimensionsInWorldSpace;
-
-uniform float   coneVariances[NUM_MIP_MAPS];
-uniform uint   numberOfLods;
-
-uniform Material material;
 
 
 float dimensionInverse = 1.0f/voxelDimensionsInWorldSpace;
@@ -62,12 +51,107 @@ vec4  normalLODColors[NUM_MIP_MAPS];
 float rayWeight = 1.0f/float(NUM_SAMPLING_RAYS);
 
 
+#if defined(INDIRECT_PASS) || defined(DEFERRED_SHADING)
+//see VoxelConeTracingRT.h, main() reads the surface back from the geometry buffer instead of getting it from the
+//vertex shader, once per pixel however many meshes were drawn over it.  Two samplers only, the mip maps take the
+//other fourteen a fragment shader gets
+uniform sampler2D normalDepthTexture;   //xyz: normal, w: view depth, 0 where nothing was drawn
+uniform sampler2D albedoTexture;        //rgb: diffuse color, a: draw id + 1
+
+in vec3 texCoord;
+
+vec3 worldPosition;
+vec3 normalFrag;
+#else
 in vec3 worldPosition;
 in vec3 normalFrag;
-
+flat in vec3 diffuseColorFrag;
+#endif
+
+#ifdef INDIRECT_PASS
+//only the indirect light goes out, packed by packIndirect().  Last frame's buffer is the history, reprojected to
+//where each surface was, the one sampler left next to the geometry buffer's normal and depth
+uniform usampler2D historyTexture;
+uniform mat4       previousV;
+uniform mat4       previousP;
+uniform bool       historyValid;
+uniform uint       interleave;      //1, 2 or 4, a texel with usable history is traced every interleave frames
+uniform uint       frameIndex;
+uniform float      historyLength;   //most traces a texel averages, fewer follows moving lights sooner
+
+layout(location = 0) out uvec4 packedIndirect;
+#else
 out vec4 color;
+#endif
+
+#ifdef UPSAMPLE_INDIRECT
+uniform usampler2D indirectTexture;
+uniform vec2       indirectSize;
+#endif
 
 
+#ifdef SPARSE_BRICK_POOL
+vec4 sampleBrickPool(sampler3D atlas, uint lod, vec3 uvw)
+{
+    //same math as BrickPool::sampleAtlas(), clamping half a texel in is what clamp to edge would do
+    float dimensions = brickLevels[lod].y;
+    vec3 voxel = clamp(uvw * dimensions, vec3(0.5f), vec3(dimensions - 0.5f));
+    vec3 brick = floor((voxel - 0.5f) / BRICK_SIZE);
+    vec4 entry = texelFetch(pageTable, ivec3(brick) + ivec3(int(brickLevels[lod].x), 0, 0), 0);
+    if(entry.w == 0.0f)
+        return vec4(0.0f);
+    
+    return texture(atlas, (entry.xyz + voxel - brick * BRICK_SIZE) / atlasSize);
+}
+#endif
+
+#ifdef CLIPMAP_CASCADES
+uint findCascade(vec3 worldPos, uint lod)
+{
+    //finest cascade at least as coarse as lod that still holds the point, keeping a voxel away from the window's
+    //edge where the wrapped texels of the other side would bleed into the filtering
+    for(uint cascade = lod; cascade < uint(NUM_CASCADES) - 1u; ++cascade)
+    {
+        vec4 window = cascadeWindows[cascade];
+        float margin = window.w / float(textureSize(albedoCascades[0], 0).x);
+        if(all(greaterThan(worldPos, window.xyz + margin)) && all(lessThan(worldPos, window.xyz + window.w - margin)))
+            return cascade;
+    }
+    return uint(NUM_CASCADES) - 1u;
+}
+
+//the cascade changes from fragment to fragment and GLSL 4.10 only indexes sampler arrays with dynamically uniform
+//values, so every cascade is sampled with the loop's index and the one asked for is kept
+void sampleCascade(vec3 worldPos, uint cascade, out vec4 albedo, out vec4 normal)
+{
+    albedo = vec4(0.0f);
+    normal = vec4(0.0f);
+    for(int i = 0; i < NUM_CASCADES; ++i)
+    {
+        vec3 uvw = worldPos / cascadeWindows[i].w;
+        vec4 cascadeAlbedo = texture(albedoCascades[i], uvw);
+        vec4 cascadeNormal = texture(normalCascades[i], uvw);
+        if(uint(i) == cascade)
+        {
+            albedo = cascadeAlbedo;
+            normal = cascadeNormal;
+        }
+    }
+}
+#endif
+
+//mirror VoxelFormat::decodeNormal()
+vec4 decodeNormal(vec4 texel)
+{
+    if(!octahedralNormals)
+        return texel;
+    if(texel.w <= 0.0f)
+        return vec4(0.0f);
+    
+    vec2 encoded = clamp(texel.xy / texel.w * 2.0f - 1.0f, -1.0f, 1.0f);
+    return vec4(octahedralDecode(encoded) * texel.z, texel.w);
+}
+
 bool withinBounds(vec3 pos)
 {
     
@@ -178,7 +262,7 @@ float getVariance(float distance)
 //section 7 and 8.1 of the paper
 vec3 indirectIllumination( vec3 geometryNormal,  float j, vec3 samplingPos)
 {
-    uint minimuLOD = 4u;
+    uint minimuLOD = min(4u, numberOfLods - 1u);
     vec3 avgNormal =  getLODColor(j, normalLODColors, minimuLOD).xyz;
     vec3 sampleFromLOD = getLODColor(j, albedoLODColors, minimuLOD).xyz;
     vec3 result = vec3(0.0f);
@@ -224,6 +308,26 @@ vec3 indirectIllumination( vec3 geometryNormal,  float j, vec3 samplingPos)
     return result;
 }
 
+#if !defined(SPARSE_BRICK_POOL) && !defined(CLIPMAP_CASCADES)
+vec4 sampleAlbedo(uint lod, vec3 uvw, vec3 direction)
+{
+    if(!anisotropicMipMaps || lod == 0)
+    {
+        return texture(albedoMipMaps[ lod ], uvw);
+    }
+    
+    //the three faces a cone running along direction looks into, weighed by how much it runs along each axis
+    float halfVoxel = 0.5f / float(textureSize(albedoMipMaps[ lod ], 0).y);
+    vec3 voxel = clamp(uvw, vec3(halfVoxel), vec3(1.0f - halfVoxel));
+    vec3 weights = direction * direction;
+    vec3 faces = vec3(direction.x >= 0.0f ? 0.0f : 1.0f, direction.y >= 0.0f ? 2.0f : 3.0f, direction.z >= 0.0f ? 4.0f : 5.0f);
+    vec4 result = weights.x * texture(albedoMipMaps[ lod ], vec3((faces.x + voxel.x) / 6.0f, voxel.yz));
+    result += weights.y * texture(albedoMipMaps[ lod ], vec3((faces.y + voxel.x) / 6.0f, voxel.yz));
+    result += weights.z * texture(albedoMipMaps[ lod ], vec3((faces.z + voxel.x) / 6.0f, voxel.yz));
+    return result;
+}
+#endif
+
 void collectLODColors(vec3 direction)
 {
     float j = voxelDimensionsInWorldSpace;
@@ -239,8 +343,19 @@ void collectLODColors(vec3 direction)
             proj += 1.0f;
             proj *= .5f;
             
-            albedoLODColors[ lod ] = texture(albedoMipMaps[ lod ], proj.xyz);
-            normalLODColors[ lod ] = texture(normalMipMaps[ lod ], proj.xyz);
+#ifdef SPARSE_BRICK_POOL
+            albedoLODColors[ lod ] = sampleBrickPool(albedoAtlas, lod, proj.xyz);
+            normalLODColors[ lod ] = sampleBrickPool(normalAtlas, lod, proj.xyz);
+#elif defined(CLIPMAP_CASCADES)
+            vec4 cascadeNormal;
+            sampleCascade(worldPos, findCascade(worldPos, lod), albedoLODColors[ lod ], cascadeNormal);
+            normalLODColors[ lod ] = decodeNormal(cascadeNormal);
+#else
+            albedoLODColors[ lod ] = sampleAlbedo(lod, proj.xyz, direction);
+            //an empty albedo texel is an empty cell, its normal is zero and needs no fetch.  The samplers are all
+            //taken, so the albedo is what stands in for an occupancy pyramid here
+            normalLODColors[ lod ] = albedoLODColors[ lod ].a > 0.0f ? decodeNormal(texture(normalMipMaps[ lod ], proj.xyz)) : vec4(0.0f);
+#endif
         }
         else
             break;
@@ -293,7 +408,124 @@ vec4 voxelConeTracing( mat3 rotation,vec3 incomingNormal )
     return ambient;
 }
 
-vec4 directIllumination(vec4 illumination)
+#if defined(INDIRECT_PASS) || defined(DEFERRED_SHADING)
+bool readGeometryBuffer(vec2 uv)
+{
+    ivec2 size = textureSize(normalDepthTexture, 0);
+    ivec2 pixel = min(ivec2(uv * vec2(size)), size - 1);
+    vec4 surface = texelFetch(normalDepthTexture, pixel, 0);
+    if(surface.w == 0.0f)
+        return false;
+    
+    //the world position comes back from the depth at the pixel's center, P is a symmetric perspective and V only
+    //rotates and translates, so its inverse is the transposed rotation
+    vec2 ndc = (vec2(pixel) + 0.5f) / vec2(size) * 2.0f - 1.0f;
+    vec3 viewPosition = vec3(ndc * surface.w / vec2(P[0][0], P[1][1]), -surface.w);
+    worldPosition = transpose(mat3(V)) * (viewPosition - V[3].xyz);
+    normalFrag = surface.xyz;
+    return true;
+}
+#endif
+
+#if defined(INDIRECT_PASS) || defined(UPSAMPLE_INDIRECT)
+//packHalf2x16() is GLSL 4.20, a 4.10 context has to do it by hand.  Rounds toward zero, clamps to the largest half and
+//flushes what would be a denormal to zero
+uint floatToHalf(float value)
+{
+    uint bits = floatBitsToUint(value);
+    uint sign = (bits >> 16) & 0x8000u;
+    int exponent = int((bits >> 23) & 0xffu) - 112;
+    if(exponent <= 0)
+        return sign;
+    if(exponent >= 31)
+        return sign | 0x7bffu;
+    return sign | (uint(exponent) << 10) | ((bits >> 13) & 0x3ffu);
+}
+
+float halfToFloat(uint bits)
+{
+    uint exponent = (bits >> 10) & 0x1fu;
+    if(exponent == 0u)
+        return 0.0f;
+    return uintBitsToFloat(((bits & 0x8000u) << 16) | ((exponent + 112u) << 23) | ((bits & 0x3ffu) << 13));
+}
+
+uint packHalfs(vec2 value)
+{
+    return floatToHalf(value.x) | (floatToHalf(value.y) << 16);
+}
+
+vec2 unpackHalfs(uint bits)
+{
+    return vec2(halfToFloat(bits & 0xffffu), halfToFloat(bits >> 16));
+}
+
+//an indirect buffer texel is eight halfs: indirect light and ambient occlusion, the normal (octahedral) and view depth
+//it was traced at, and how many traces it averages.  Zero depth where nothing was drawn
+uvec4 packIndirect(vec4 indirect, vec3 normal, float depth, float samples)
+{
+    return uvec4(packHalfs(indirect.xy), packHalfs(indirect.zw), packHalfs(octahedralEncode(normal)),
+                 packHalfs(vec2(depth, samples)));
+}
+
+void unpackIndirect(uvec4 texel, out vec4 indirect, out vec3 normal, out float depth, out float samples)
+{
+    indirect = vec4(unpackHalfs(texel.x), unpackHalfs(texel.y));
+    normal = octahedralDecode(unpackHalfs(texel.z));
+    vec2 depthSamples = unpackHalfs(texel.w);
+    depth = depthSamples.x;
+    samples = depthSamples.y;
+}
+#endif
+
+#ifdef UPSAMPLE_INDIRECT
+vec4 upsampleIndirect(vec2 uv)
+{
+    //joint bilateral upsampling: the four low resolution texels around the pixel, weighted bilinearly and by how well
+    //the surface they were traced at agrees with this one, so light doesn't bleed across edges
+    vec2 texel = uv * indirectSize - 0.5f;
+    ivec2 base = ivec2(floor(texel));
+    vec2 f = texel - vec2(base);
+    
+    vec3 n = normalize(normalFrag);
+    float depth = -(V * vec4(worldPosition, 1.0f)).z;
+    ivec2 last = ivec2(indirectSize) - 1;
+    
+    vec4 result = vec4(0.0f);
+    float total = 0.0f;
+    float closest = 1e20f;
+    vec4 closestSample = vec4(0.0f);
+    for(int i = 0; i < 4; ++i)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 coord = clamp(base + offset, ivec2(0), last);
+        vec4 indirect;
+        vec3 surfaceNormal;
+        float surfaceDepth, samples;
+        unpackIndirect(texelFetch(indirectTexture, coord, 0), indirect, surfaceNormal, surfaceDepth, samples);
+        
+        float bilinear = mix(1.0f - f.x, f.x, float(offset.x)) * mix(1.0f - f.y, f.y, float(offset.y));
+        float normalWeight = pow(max(dot(n, surfaceNormal), 0.0f), 16.0f);
+        float depthDifference = abs(depth - surfaceDepth) / max(depth, 1e-4f);
+        float depthWeight = exp(-depthDifference * 50.0f);
+        float weight = surfaceDepth > 0.0f ? bilinear * normalWeight * depthWeight : 0.0f;
+        
+        result += indirect * weight;
+        total += weight;
+        
+        if(surfaceDepth > 0.0f && depthDifference < closest)
+        {
+            closest = depthDifference;
+            closestSample = indirect;
+        }
+    }
+    
+    //every neighbour is across an edge, the nearest one in depth is still better than nothing
+    return total > 1e-4f ? result / total : closestSample;
+}
+#endif
+
+vec4 directIllumination(vec4 illumination, vec3 diffuseColor)
 {
     vec3 v = cameraPosition - worldPosition;
     v = normalize(v);
@@ -311,7 +543,7 @@ vec4 directIllumination(vec4 illumination)
         
         float ndotl = clamp( dot(n, l), 0.0f, 1.0f);
         
-        final += (material.diffuseColor * illumination.a + spec * material.diffuseColor) * ndotl * pointLights[0].color;
+        final += (diffuseColor * illumination.a + spec * diffuseColor) * ndotl * pointLights[0].color;
     }
     
     final.xyz += (illumination.xyz);
@@ -320,14 +552,92 @@ vec4 directIllumination(vec4 illumination)
 
 
 
+#ifdef INDIRECT_PASS
+float reprojectHistory(vec3 normal, out vec4 history)
+{
+    //where the surface was last frame, whatever history holds there counts only if it was this surface: the depth it
+    //was traced at has to match this point's depth from last frame's camera, and the normals have to agree
+    history = vec4(0.0f);
+    if(!historyValid)
+        return 0.0f;
+    
+    vec4 previousView = previousV * vec4(worldPosition, 1.0f);
+    vec4 clip = previousP * previousView;
+    vec2 uv = clip.xy / clip.w * 0.5f + 0.5f;
+    if(clip.w <= 0.0f || any(lessThan(uv, vec2(0.0f))) || any(greaterThanEqual(uv, vec2(1.0f))))
+        return 0.0f;
+    
+    vec3 historyNormal;
+    float historyDepth, samples;
+    ivec2 size = textureSize(historyTexture, 0);
+    unpackIndirect(texelFetch(historyTexture, ivec2(uv * vec2(size)), 0), history, historyNormal, historyDepth, samples);
+    
+    float expectedDepth = -previousView.z;
+    bool sameSurface = historyDepth > 0.0f && abs(historyDepth - expectedDepth) < 0.05f * expectedDepth &&
+                       dot(historyNormal, normal) > 0.9f;
+    return sameSurface ? samples : 0.0f;
+}
+
+void main()
+{
+    if(!readGeometryBuffer(texCoord.st))
+    {
+        //nothing was drawn here, zero depth keeps the upsampling and the next frame from using this texel
+        packedIndirect = uvec4(0u);
+        return;
+    }
+    
+    vec3 incomingNormal = normalize(normalFrag);
+    vec4 history;
+    float samples = reprojectHistory(incomingNormal, history);
+    
+    //texels take turns in 8x8 tiles rather than one by one, so whole warps skip the cones together instead of every
+    //warp waiting on the one texel of each 2x2 that traces.  Texels without history trace whatever their turn
+    ivec2 tile = ivec2(gl_FragCoord.xy) >> 3;
+    uint turn = interleave == 4u ? uint((tile.x & 1) + 2 * (tile.y & 1)) : interleave == 2u ? uint((tile.x + tile.y) & 1) : 0u;
+    if(samples == 0.0f || turn == frameIndex % interleave)
+    {
+        mat3 rotation;
+        branchlessONB(normalFrag, rotation);
+        samples = min(samples + 1.0f, historyLength);
+        history = mix(history, voxelConeTracing(rotation, incomingNormal), 1.0f / samples);
+    }
+    
+    packedIndirect = packIndirect(history, incomingNormal, -(V * vec4(worldPosition, 1.0f)).z, samples);
+}
+#elif defined(DEFERRED_SHADING)
 void main()
 {
+    if(!readGeometryBuffer(texCoord.st))
+    {
+        color = vec4(0.0f);
+        return;
+    }
+    
+#ifdef UPSAMPLE_INDIRECT
+    vec4 illumination = upsampleIndirect(texCoord.st);
+#else
     mat3 rotation;
     branchlessONB(normalFrag, rotation);
     vec3 incomingNormal = normalize(normalFrag);
-    color = voxelConeTracing(rotation, incomingNormal);
     vec4 illumination = voxelConeTracing(rotation, incomingNormal);
+#endif
     
-    color = directIllumination(illumination);
+    color = directIllumination(illumination, texture(albedoTexture, texCoord.st).rgb);
+}
+#else
+void main()
+{
+#ifdef UPSAMPLE_INDIRECT
+    vec4 clip = P * V * vec4(worldPosition, 1.0f);
+    vec4 illumination = upsampleIndirect(clip.xy / clip.w * 0.5f + 0.5f);
+#else
+    mat3 rotation;
+    branchlessONB(normalFrag, rotation);
+    vec3 incomingNormal = normalize(normalFrag);
+    vec4 illumination = voxelConeTracing(rotation, incomingNormal);
+#endif
     
+    color = directIllumination(illumination, diffuseColorFrag);
 }
+#endif
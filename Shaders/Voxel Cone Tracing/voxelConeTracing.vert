@@ -7,16 +7,19 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 
-uniform mat4 M;
-uniform mat4 V;
-uniform mat4 P;
-
-
+#include "Common/uniformBlocks.glsl"
+#include "Common/drawTable.glsl"
 
 out vec3 worldPosition;
 out vec3 normalFrag;
+flat out vec3 diffuseColorFrag;
+flat out uint drawIDFrag;
 
 void main(){
+    fetchDraw();
+    diffuseColorFrag = material.diffuseColor;
+    drawIDFrag = drawID;
+    
     worldPosition = (  M * vec4(position, 1)).xyz;
     
     normalFrag = normalize(mat3(transpose(inverse(M))) * normal);
@@ -12,7 +12,21 @@
 
 uniform float   focalLength;
 uniform vec3    camPosition;
+#ifdef SPARSE_BRICK_POOL
+#define BRICK_SIZE 8.0f
+//see BrickPool.h, only the base level is visualized
+uniform sampler3D pageTable;
+uniform sampler3D albedoAtlas;
+uniform vec3      atlasSize;
+uniform float     voxelDimensions;
+#else
 uniform sampler3D texture3D;
+#ifdef EMPTY_SPACE_SKIPPING
+//see OccupancyGrid.h, level L of the pyramid starts at column voxelDimensions - 2 * (voxelDimensions >> L)
+uniform usampler3D occupancy;
+uniform float      voxelDimensions;
+#endif
+#endif
 
 uniform float   stepSize = 0.01f;
 uniform float   maxSamples = 80;
@@ -31,6 +45,53 @@ struct AABB {
     vec3 Max;
 };
 
+#ifdef SPARSE_BRICK_POOL
+vec4 sampleBrickPool(vec3 uvw)
+{
+    vec3 voxel = clamp(uvw * voxelDimensions, vec3(0.5f), vec3(voxelDimensions - 0.5f));
+    vec3 brick = floor((voxel - 0.5f) / BRICK_SIZE);
+    vec4 entry = texelFetch(pageTable, ivec3(brick), 0);
+    if(entry.w == 0.0f)
+        return vec4(0.0f);
+    
+    return texture(albedoAtlas, (entry.xyz + voxel - brick * BRICK_SIZE) / atlasSize);
+}
+#endif
+
+#ifdef EMPTY_SPACE_SKIPPING
+//mirrors OccupancyGrid::skip(): whole steps the ray can take before it may reach an occupied voxel, 0 when it's in one
+int skipEmptySpace(vec3 position, vec3 direction, float stepLength)
+{
+    int dimensions = int(voxelDimensions);
+    ivec3 voxel = clamp(ivec3(floor(position)), ivec3(0), ivec3(dimensions - 1));
+    uint bits = texelFetch(occupancy, voxel >> 1, 0).r;
+    ivec3 bit = voxel & 1;
+    if((bits & (1u << uint(bit.x + 2 * bit.y + 4 * bit.z))) != 0u)
+        return 0;
+    
+    //climb while the coarser cell is empty too
+    int level = 0;
+    if(bits == 0u)
+    {
+        level = 1;
+        while((dimensions >> (level + 1)) > 0 &&
+              texelFetch(occupancy, (voxel >> (level + 1)) + ivec3(dimensions - 2 * (dimensions >> (level + 1)), 0, 0), 0).r == 0u)
+        {
+            ++level;
+        }
+    }
+    
+    float size = float(1 << level);
+    vec3 low = vec3(voxel >> level) * size;
+    vec3 exit = mix(low, low + size, greaterThan(direction, vec3(0.0f)));
+    vec3 t = mix(vec3(1e6f), (exit - position) / direction, notEqual(direction, vec3(0.0f)));
+    float distance = min(t.x, min(t.y, t.z));
+    
+    //a hair short of the exit, so rounding never steps over the first sample past it
+    return max(1, int(ceil(min(distance / stepLength, 1e6f) - 1e-3f)));
+}
+#endif
+
 bool IntersectBox(Ray r, AABB aabb, out float t0, out float t1)
 {
     vec3 invR = 1.0 / r.Dir;
@@ -75,10 +136,32 @@ void main()
         vec3 step = normalize(rayStop-rayStart) * stepSize;
         float travel = distance(rayStop, rayStart);
 
+#ifdef EMPTY_SPACE_SKIPPING
+        // Same samples as below, without the ones in empty cells.  Positions are taken from rayStart so a ray lands
+        // where the fixed steps would have whatever it skipped
+        vec3 direction = normalize(rayStop-rayStart);
+        for (int i=0; i < maxSamples && travel > 0.0; )
+        {
+            int steps = skipEmptySpace(pos * voxelDimensions, direction, stepSize * voxelDimensions);
+            if(steps == 0)
+            {
+                fragColor += texture(texture3D, pos);
+                steps = 1;
+            }
+            i += steps;
+            pos = rayStart + step * float(i);
+            travel -= stepSize * float(steps);
+        }
+#else
         for (int i=0; i < maxSamples && travel > 0.0; ++i, pos += step, travel -= stepSize)
         {
             vec3 samplePoint = pos;
+#ifdef SPARSE_BRICK_POOL
+            fragColor += sampleBrickPool(samplePoint);
+#else
             fragColor += texture(texture3D, samplePoint);
+#endif
         }
+#endif
     }
 }
@@ -0,0 +1,23 @@
+// Scene pass of the geometry shader voxelization, one texel of a slab per fragment.
+#version 410 core
+
+uniform bool conservative;
+
+in vec3 normalFrag;
+in vec3 albedoFrag;
+flat in vec4 boundsFrag;
+
+layout(location = 0) out vec4 albedo;
+layout(location = 1) out vec4 normal;
+
+void main()
+{
+    //the expanded triangle's corners reach past the voxels the triangle touches
+    if(conservative && (any(lessThan(gl_FragCoord.xy, boundsFrag.xy)) || any(greaterThan(gl_FragCoord.xy, boundsFrag.zw))))
+    {
+        discard;
+    }
+    
+    albedo = vec4(albedoFrag, 1.0f);
+    normal = vec4(normalFrag, 1.0f);
+}
@@ -0,0 +1,25 @@
+// Scene pass of the geometry shader voxelization, see geometryVoxelization.geom and VoxelizeRT.h.
+#version 410 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+#include "Common/uniformBlocks.glsl"
+#include "Common/drawTable.glsl"
+
+// World to voxel grid space, [0, cubeDimensions] on every axis, see VoxelGrid::gridFromWorld().
+uniform mat4 gridFromWorld;
+
+out vec3 gridPositionGeom;
+out vec3 normalGeom;
+out vec3 albedoGeom;
+
+void main()
+{
+    fetchDraw();
+    gridPositionGeom = (gridFromWorld * M * vec4(position, 1)).xyz;
+    
+    //same as the depth peeling, so both strategies can be compared voxel for voxel
+    normalGeom = normal;
+    albedoGeom = material.diffuseColor;
+}
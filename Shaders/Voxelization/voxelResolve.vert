@@ -0,0 +1,63 @@
+// One instance per voxel: gathers what geometryVoxelization.geom rasterized for the voxel along each axis and hands
+// it to voxelization.geom and voxelization.frag like voxelization.vert does for a texel of a peeled layer.
+#version 410 core
+
+layout(location = 0) in vec3 position;
+
+//cube dimensions is assumed to be a power of 2
+uniform uint cubeDimensions;
+
+// cubeDimensions x cubeDimensions x 3 cubeDimensions, the x, y and z slabs one after the other.
+uniform sampler3D albedoSlabs;
+uniform sampler3D normalSlabs;
+
+// Voxel grid to world space, the inverse of VoxelGrid::gridFromWorld().
+uniform mat4 worldFromGrid;
+
+//part of the volume being revoxelized, in voxels.  Everything outside of it is left as it was.
+uniform vec3 regionBegin;
+uniform vec3 regionEnd;
+
+out float totalSlicesGeom;
+out vec3 normalGeom;
+out vec3 albedoGeom;
+out vec3 worldPositionGeom;
+
+void main()
+{
+    int dimensions = int(cubeDimensions);
+    ivec3 voxel = ivec3(gl_InstanceID & (dimensions - 1), (gl_InstanceID / dimensions) & (dimensions - 1), gl_InstanceID / (dimensions * dimensions));
+    totalSlicesGeom = float(cubeDimensions);
+    
+    //if nothing below hits, we are effectively throwing this vertex away
+    gl_Position.x = 10000.0f;
+    if(any(lessThan(vec3(voxel), regionBegin)) || any(greaterThanEqual(vec3(voxel), regionEnd)))
+    {
+        return;
+    }
+    
+    ivec3 texels[3] = ivec3[3](ivec3(voxel.y, voxel.z, voxel.x),
+                               ivec3(voxel.x, voxel.z, dimensions + voxel.y),
+                               ivec3(voxel.x, voxel.y, 2 * dimensions + voxel.z));
+    vec4 albedo = vec4(0.0f);
+    vec3 normal = vec3(0.0f);
+    for(int i = 0; i < 3; ++i)
+    {
+        vec4 texel = texelFetch(albedoSlabs, texels[i], 0);
+        if(texel.a > 0.0f)
+        {
+            albedo += texel;
+            normal += texelFetch(normalSlabs, texels[i], 0).xyz;
+        }
+    }
+    
+    if(albedo.a > 0.0f)
+    {
+        albedoGeom = albedo.rgb / albedo.a;
+        normalGeom = normal / albedo.a;
+        
+        vec3 center = vec3(voxel) + 0.5f;
+        worldPositionGeom = (worldFromGrid * vec4(center, 1.0f)).xyz;
+        gl_Position = vec4(center / float(cubeDimensions) * 2.0f - 1.0f, 1.0f);
+    }
+}
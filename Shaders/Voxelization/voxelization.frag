@@ -12,6 +12,8 @@
 #define CONSTANT 1
 #define LINEAR 0
 #define QUADRATIC 1
+
+#include "Common/octahedral.glsl"
 
 
 
@@ -23,6 +25,7 @@ struct PointLight {
 uniform PointLight pointLights[MAX_LIGHTS];
 
 uniform uint numberOfLights;
+uniform bool octahedralNormals; // See VoxelFormat.h, the normal texture is RGBA16 when set.
 
 
 in vec3 worldPositionFrag;
@@ -46,11 +49,21 @@ vec3 calculatePointLight( PointLight light)
     return d * POINT_LIGHT_INTENSITY * attenuation * light.color;
 }
 
+// Mirror VoxelFormat::encodeNormal().
+vec4 encodeNormal(vec4 value)
+{
+    float coverage = clamp(value.w, 0.0f, 1.0f);
+    float len = length(value.xyz);
+    if(coverage <= 0.0f || len <= 0.0f)
+        return vec4(0.5f * coverage, 0.5f * coverage, 0.0f, coverage);
+    
+    return vec4((octahedralEncode(value.xyz / len) * 0.5f + 0.5f) * coverage, min(len, 1.0f), coverage);
+}
 
 void main()
 {
     vec3 albedo = colorFrag;
-    normal = vec4(normalFrag,1.f);
+    normal = octahedralNormals ? encodeNormal(vec4(normalFrag, 1.f)) : vec4(normalFrag,1.f);
     
     // Calculate diffuse lighting fragment contribution.
     uint maxLights = min(numberOfLights, MAX_LIGHTS);
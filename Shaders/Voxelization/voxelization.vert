@@ -18,6 +18,10 @@ uniform mat4 toWorldSpace;
 
 uniform float voxelSizeInWorldSpace;
 
+//part of the volume being revoxelized, in voxels.  Everything outside of it is left as it was.
+uniform vec3 regionBegin;
+uniform vec3 regionEnd;
+
 
 out float totalSlicesGeom;
 out vec3 normalGeom;
@@ -63,5 +67,11 @@ void main(){
         gl_Position =  zPlaneProjection * worldSpacePos;
         
         worldPositionGeom = worldSpacePos.xyz;
+        
+        vec3 voxel = (gl_Position.xyz * 0.5f + 0.5f) * float(cubeDimensions);
+        if(any(lessThan(voxel, regionBegin)) || any(greaterThanEqual(voxel, regionEnd)))
+        {
+            gl_Position.x = 10000.0f;
+        }
     }
 }
@@ -3,26 +3,98 @@
 // Standard library.
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
 #include <time.h>
 
 // External.
 #include "OpenGL_Includes.h"
+#include "glm/gtc/constants.hpp"
 
 // Internal.
 #include "Scene/Scene.h"
 #include "Scene/ScenePack.h"
 #include "Graphic/Graphics.h"
 #include "Graphic/Material/MaterialStore.h"
+#include "Graphic/GLState.h"
+#include "Graphic/FBO/FBO_2D.h"
 #include "Time/FrameRate.h"
+#include "Time/Profiler.h"
+#include "Time/Benchmark.h"
 #include "Shape/TextQuad.h"
+#include "Graphic/Voxelization/MipChainBuilder.h"
+#include "Graphic/Voxelization/BrickPool.h"
+#include "Graphic/Voxelization/VoxelFormat.h"
+#include "Graphic/Voxelization/AnisotropicMips.h"
+#include "Graphic/Voxelization/VoxelRayMarcher.h"
+#include "Utility/ObjParser.h"
 
 #define __LOG_INTERVAL 1 /* How often we should log frame rate info to the console. = 0 means don't log. */
 #if __LOG_INTERVAL > 0
 constexpr float __LOG_INTERVAL_TIME_GUARD = 1.0f;
 #endif
+
+#define __BENCHMARK_MIP_CHAIN 0 /* Times the CPU voxel mip chain builder at 64^3, 128^3 and 256^3 before initializing. */
+#define __REPORT_BRICK_POOL_MEMORY 0 /* Prints bytes per occupied voxel of the dense textures vs the sparse brick pool. */
+#define __REPORT_VOXEL_FORMATS 0 /* Prints memory, bandwidth and accuracy of the compact voxel formats vs RGBA32F. */
+#define __REPORT_ANISOTROPIC_MIPS 0 /* Prints memory and per level opacity error of the six direction albedo mips vs the isotropic ones. */
+#define __BENCHMARK_SHADER_PARAMETERS 0 /* Times the flat shader parameter group against an unordered_map at 10, 50 and 200 parameters. */
+#define __BENCHMARK_OBJ_PARSER 0 /* Prints the MB/s of the parallel OBJ parser and tinyobjloader on every model in Assets/Models. */
+#define __BENCHMARK_EMPTY_SPACE_SKIPPING 0 /* Prints samples per ray and time of the voxel ray marches with and without the occupancy pyramid at 64^3 and 128^3. */
+#define __SHOW_UNIFORM_LOOKUPS 0 /* Shows how many glGetUniformLocation calls the cached locations saved last frame. */
+#define __SHOW_GL_STATE_CALLS 0 /* Shows how many binds and state changes GLState issued and skipped last frame. */
+#define __SHOW_PROFILER 0 /* Shows the rolling CPU/GPU time of every profiled pass. T starts and stops writing trace.json. */
+#ifndef __HEADLESS_EGL
+#define __HEADLESS_EGL 0 /* Headless runs try a surfaceless EGL context first (Mesa llvmpipe, no display needed). Links against EGL, GLEW must be built with GLEW_EGL. CMake sets it with VCT_HEADLESS_EGL. */
+#endif
+
 
 using __DEFAULT_LEVEL = GlassScene; // The scene that will be loaded on startup.
 // (see ScenePack.h for more scenes)
+
+#if __HEADLESS_EGL && !defined(__APPLE__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace {
+	// Mesa's surfaceless platform needs neither a display server nor a GPU, there is no default framebuffer
+	// so everything draws to the offscreen FBO instead.
+	bool createSurfacelessContext() {
+		auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay == nullptr) return false;
+
+		EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		EGLint major, minor;
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) return false;
+
+		const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 4,
+			EGL_CONTEXT_MINOR_VERSION, 5,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		EGLConfig config;
+		EGLint configCount = 0;
+		if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+			eglTerminate(display);
+			return false;
+		}
+
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+		if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+			eglTerminate(display);
+			return false;
+		}
+		return true;
+	}
+}
+#endif
 
 Application & Application::getInstance() {
 	static Application application;
@@ -31,12 +103,36 @@ Application & Application::getInstance() {
 
 void Application::init() {
 	std::cout << "Initialization started." << std::endl;
+
+#if __BENCHMARK_MIP_CHAIN
+    MipChainBuilder::benchmark();
+#endif
+#if __BENCHMARK_SHADER_PARAMETERS
+    ShaderParameterGroup::benchmark();
+#endif
+#if __BENCHMARK_OBJ_PARSER
+    ObjParser::benchmark();
+#endif
+#if __BENCHMARK_EMPTY_SPACE_SKIPPING
+    VoxelRayMarcher::benchmark();
+#endif
+#if __REPORT_BRICK_POOL_MEMORY
+    BrickPool::reportMemory();
+#endif
+#if __REPORT_VOXEL_FORMATS
+    VoxelFormat::report();
+#endif
+#if __REPORT_ANISOTROPIC_MIPS
+    AnisotropicMips::report();
+#endif
 
 	// -------------------------------------
 	// Initialize GLFW.
 	// -------------------------------------
 	if (!glfwInit()) {
 		std::cerr << "GLFW failed to initialize." << std::endl;
+		exitCode = 1;
+		return;
 	}
 	double timeElapsed = glfwGetTime();
 
@@ -56,12 +152,24 @@ void Application::init() {
 	glfwWindowHint(GLFW_SAMPLES, MSAA_SAMPLES);
 
 	// Create a new window and set window mode accordingly (including title, size and mode).
+	if (headless.enabled) {
+		if (!createHeadlessContext()) {
+			exitCode = 1;
+			return;
+		}
+	}
+	else {
 #if DEFAULT_FULLSCREEN == 2 
-	// Borderless fullscreen.
-	SetBorderlessFullscreenMode();
+		// Borderless fullscreen.
+		SetBorderlessFullscreenMode();
 #else
-	SetWindowMode(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT, DEFAULT_FULLSCREEN == 1);
+		SetWindowMode(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT, DEFAULT_FULLSCREEN == 1);
 #endif
+		if (currentWindow == nullptr) {
+			exitCode = 1;
+			return;
+		}
+	}
 	std::cout << "[0] : GLFW initialized." << std::endl;
 
 #ifndef __APPLE__
@@ -74,8 +182,11 @@ void Application::init() {
 	}
 	else {
 		std::cerr << "GLEW failed to initialize (glewExperimental might not be supported)." << std::endl;
-		std::cerr << "Press any key to exit ... " << std::endl;
-		getchar();
+		if (!headless.enabled) {
+			std::cerr << "Press any key to exit ... " << std::endl;
+			getchar();
+		}
+		exitCode = 1;
 		return;
 	}
 
@@ -88,28 +199,37 @@ void Application::init() {
 	for (const auto & ext : requiredGLEWExtensions) {
 		if (!ext.first) {
 			std::cerr << "ERROR: " << ext.second << " not supported! Expect unexpected behaviour." << std::endl;
-			std::cerr << "Press any key to continue ... " << std::endl;
-			getchar();
+			if (!headless.enabled) {
+				std::cerr << "Press any key to continue ... " << std::endl;
+				getchar();
+			}
 		}
 	}
 #endif
 	// -------------------------------------
 	// Initialize graphics.
 	// -------------------------------------
-	int w, h;
-	glfwGetWindowSize(currentWindow, &w, &h);
+	int w = headless.width, h = headless.height;
+	if (headless.enabled) {
+		createOffscreenTarget();
+	}
+	else {
+		glfwGetWindowSize(currentWindow, &w, &h);
+	}
 	MaterialStore::getInstance(); // Initialize material store.
 
     graphics.init(w, h);
 
-	glfwSetWindowSizeCallback(currentWindow, Application::OnWindowResize);
-	glfwSwapInterval(DEFAULT_VSYNC); // vSync.
+	if (!headless.enabled) {
+		glfwSetWindowSizeCallback(currentWindow, Application::OnWindowResize);
+		glfwSwapInterval(DEFAULT_VSYNC); // vSync.
+	}
 	std::cout << "[2] : Graphics initialized." << std::endl;
 
 	// -------------------------------------
 	// Initialize scene.
 	// -------------------------------------
-    scene = new __DEFAULT_LEVEL();
+    scene = headless.enabled ? createScene(headless.scene) : new __DEFAULT_LEVEL();
 	scene->init(w, h);
 	std::cout << "[3] : Scene initialized." << std::endl;
 
@@ -117,11 +237,13 @@ void Application::init() {
 	// -------------------------------------
 	// Initialize input.
 	// -------------------------------------
-	glfwSetInputMode(currentWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glfwSetMouseButtonCallback(currentWindow, GLFWMouseButtonCallback);
-	glfwSetCursorPosCallback(currentWindow, GLFWMousePositionCallback);
-	glfwSetKeyCallback(currentWindow, GLFWKeyCallback);
-	std::cout << "[5] : Input initialized." << std::endl;
+	if (!headless.enabled) {
+		glfwSetInputMode(currentWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetMouseButtonCallback(currentWindow, GLFWMouseButtonCallback);
+		glfwSetCursorPosCallback(currentWindow, GLFWMousePositionCallback);
+		glfwSetKeyCallback(currentWindow, GLFWKeyCallback);
+		std::cout << "[5] : Input initialized." << std::endl;
+	}
 
 	// -------------------------------------
 	// Finalize initialization.
@@ -136,6 +258,8 @@ void Application::init() {
 
 	std::cout << "Using OpenGL version " << glGetString(GL_VERSION) << std::endl;
     
+    if (headless.enabled) return;
+    
     glm::vec2 dimensions( w, h);
     text = new TextQuad(dimensions);
 }
@@ -144,8 +268,23 @@ void Application::init() {
 
 void Application::run()
 {
+	// init() already reported why and set exitCode.
+	if (!initialized) {
+		return;
+	}
+	if (headless.benchmark) {
+		runBenchmark();
+		return;
+	}
+	if (headless.enabled) {
+		runHeadless();
+		return;
+	}
+
 	std::cout << "Application is now running.\n" << std::endl;
 	std::cout << " :: Use R to switch between rendering modes.\n";
+	std::cout << " :: Use V to switch between voxelization strategies.\n";
+	std::cout << " :: Use B to toggle conservative voxelization.\n";
 	// std::cout << " :: Use T to switch between interaction modes." << std::endl;
 
 	double smoothedDeltaTimeAccumulator = 0;
@@ -160,6 +299,8 @@ void Application::run()
 	// Start the update loop.
 	while (!glfwWindowShouldClose(currentWindow) && !exitQueued)
 	{
+		Profiler::beginFrame();
+
 		// --------------------------------------------------
 		// Update input and timers.
 		// --------------------------------------------------
@@ -179,7 +320,13 @@ void Application::run()
 			timestampCost = glfwGetTime();
 		}
 #endif
-		if (!paused) scene->update();
+		if (!paused) {
+			Profiler::Scope profile("update");
+			scene->update();
+		}
+		if (recordingPath) {
+			recordedPath.record(float(FrameRate::time - recordingStart), *scene->renderingCamera);
+		}
 #if __LOG_INTERVAL > 0 
 		{
 			updateCost += glfwGetTime() - timestampCost;
@@ -225,6 +372,13 @@ void Application::run()
         glError();
         
         char buf[100];
+#if __SHOW_UNIFORM_LOOKUPS
+        //taken before the text goes up, so the overlay doesn't count itself
+        Material::UniformLookups lookups = Material::getUniformLookups();
+#endif
+#if __SHOW_GL_STATE_CALLS
+        GLState::Statistics stateCalls = GLState::getStatistics();
+#endif
         float f = floorf(FrameRate::framesPerSecond * 100.0f)/100.0f;
         static std::string frameRate;
         
@@ -234,6 +388,36 @@ void Application::run()
         glm::vec2 pos(50.0f, 50.0f);
         text->setScale(.5f);
         text->print(frameRate, pos);
+        
+#if __SHOW_UNIFORM_LOOKUPS
+        static std::string uniformLookups;
+        std::sprintf(buf, "Uniform lookups removed: %u, %u left", lookups.cachedByName, lookups.uncached);
+        uniformLookups = buf;
+        glm::vec2 lookupsPos(50.0f, 80.0f);
+        text->print(uniformLookups, lookupsPos);
+        Material::resetUniformLookups();
+#endif
+        
+#if __SHOW_GL_STATE_CALLS
+        static std::string glStateCalls;
+        std::sprintf(buf, "GL state calls: %u issued, %u elided", stateCalls.issued, stateCalls.elided);
+        glStateCalls = buf;
+        glm::vec2 stateCallsPos(50.0f, 110.0f);
+        text->print(glStateCalls, stateCallsPos);
+        GLState::resetStatistics();
+#endif
+        
+#if __SHOW_PROFILER
+        static std::vector<std::string> profilerLines;
+        Profiler::getSummary(profilerLines);
+        glm::vec2 profilerPos(50.0f, 140.0f);
+        for (std::string& line : profilerLines) {
+            text->print(line, profilerPos);
+            profilerPos.y += 30.0f;
+        }
+#endif
+        
+        Profiler::endFrame();
         
 		// Swap front and back buffers.
 		if (!paused)
@@ -298,6 +482,230 @@ void Application::SetWindowMode(int quadWidth, int quadHeight, bool fullscreen =
 	}
 }
 
+void Application::parseArguments(int argc, const char * argv[]) {
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		std::string value = argument.substr(argument.find('=') + 1);
+
+		if (argument == "--headless") {
+			headless.enabled = true;
+		}
+		else if (argument.compare(0, 8, "--scene=") == 0) {
+			headless.scene = value;
+		}
+		else if (argument.compare(0, 9, "--frames=") == 0) {
+			headless.frames = std::max(1, atoi(value.c_str()));
+		}
+		else if (argument.compare(0, 7, "--size=") == 0) {
+			unsigned int width = 0, height = 0;
+			if (sscanf(value.c_str(), "%ux%u", &width, &height) == 2 && width > 0 && height > 0) {
+				headless.width = width;
+				headless.height = height;
+			}
+			else {
+				std::cerr << "Ignoring " << argument << ", expected --size=WIDTHxHEIGHT." << std::endl;
+			}
+		}
+		else if (argument.compare(0, 9, "--output=") == 0) {
+			headless.output = value;
+		}
+		else if (argument.compare(0, 8, "--trace=") == 0) {
+			headless.trace = value;
+		}
+		else if (argument.compare(0, 9, "--camera=") == 0) {
+			headless.cameraPath = value;
+		}
+		else if (argument == "--benchmark") {
+			headless.enabled = true;
+			headless.benchmark = true;
+		}
+		else if (argument.compare(0, 9, "--warmup=") == 0) {
+			headless.warmupFrames = std::max(0, atoi(value.c_str()));
+		}
+		else if (argument.compare(0, 9, "--report=") == 0) {
+			headless.report = value;
+		}
+		else if (argument.compare(0, 11, "--baseline=") == 0) {
+			headless.baseline = value;
+		}
+		else if (argument.compare(0, 12, "--threshold=") == 0) {
+			headless.threshold = std::max(0.0, atof(value.c_str()));
+		}
+		else {
+			std::cerr << "Ignoring unknown argument " << argument << std::endl;
+		}
+	}
+}
+
+Scene * Application::createScene(const std::string& name) {
+	if (name == "cornell") return new CornellScene();
+	if (name == "dragon") return new DragonScene();
+	if (name == "multiple") return new MultipleObjectsScene();
+	if (name == "glass") return new GlassScene();
+
+	if (!name.empty()) {
+		std::cerr << "Unknown scene '" << name << "', loading the default one (cornell, dragon, multiple or glass)." << std::endl;
+	}
+	return new __DEFAULT_LEVEL();
+}
+
+bool Application::createHeadlessContext() {
+	currentWindow = nullptr;
+#if __HEADLESS_EGL && !defined(__APPLE__)
+	if (createSurfacelessContext()) {
+		std::cout << "Headless: surfaceless EGL context created." << std::endl;
+		return true;
+	}
+	std::cerr << "Headless: no surfaceless EGL context, falling back to a hidden window." << std::endl;
+#endif
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	SetWindowMode(headless.width, headless.height, false);
+	if (currentWindow == nullptr) {
+		std::cerr << "Headless: no OpenGL context, a hidden window needs a display (or build with __HEADLESS_EGL)." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void Application::createOffscreenTarget() {
+	// Reading back a hidden window isn't guaranteed to work and a surfaceless context has no window at all,
+	// so headless runs draw everything meant for the screen into this FBO.
+	Texture::Dimensions dimensions;
+	dimensions.width = headless.width;
+	dimensions.height = headless.height;
+
+	Texture::Properties properties;
+	properties.minFilter = GL_LINEAR;
+	properties.dataFormat = GL_UNSIGNED_BYTE;
+
+	offscreenFBO = std::make_shared<FBO_2D>(dimensions, properties);
+	{
+		FBO_2D::Commands commands(offscreenFBO.get());
+		commands.allocateOnGPU(dimensions);
+	}
+	FBO_2D::setDefault(offscreenFBO);
+}
+
+void Application::updateScriptedCamera(unsigned int frame) {
+	// Plays --camera= if there is one, otherwise sways around the y axis, 20 degrees each way, and lands back where
+	// the scene put the camera on the last frame.
+	Camera * camera = scene->renderingCamera;
+	if (frame == 0) {
+		if (headless.cameraPath.empty() || !scriptedPath.load(headless.cameraPath)) {
+			float duration = float(std::max(headless.frames, 2u) - 1) * float(headless.deltaTime);
+			scriptedPath = CameraPath::sway(camera->position, camera->forward, duration, glm::radians(20.0f));
+		}
+	}
+	scriptedPath.apply(float(frame * headless.deltaTime), *camera);
+}
+
+void Application::captureFrame(const std::string& path) {
+	unsigned int width = headless.width, height = headless.height;
+	std::vector<unsigned char> pixels(width * height * 3);
+	{
+		FBO::Commands commands(FBO_2D::getDefault().get());
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+		glError();
+	}
+
+	// Binary PPM, top row first where GL reads bottom row first.
+	std::ofstream file(path, std::ios::binary);
+	file << "P6\n" << width << " " << height << "\n255\n";
+	for (unsigned int row = height; row-- > 0;) {
+		file.write(reinterpret_cast<const char *>(&pixels[row * width * 3]), width * 3);
+	}
+
+	if (file) {
+		std::cout << "Headless: wrote " << path << std::endl;
+	}
+	else {
+		std::cerr << "Headless: could not write " << path << std::endl;
+	}
+}
+
+void Application::runHeadless() {
+	std::cout << "Headless: rendering " << headless.frames << " frames at " << headless.width << "x" << headless.height << "." << std::endl;
+
+	if (!headless.trace.empty()) {
+		Profiler::startTrace();
+	}
+
+	double renderCost = 0;
+	for (unsigned int frame = 0; frame < headless.frames; ++frame) {
+		Profiler::beginFrame();
+		FrameRate::deltaTime = headless.deltaTime;
+		FrameRate::time = frame * headless.deltaTime;
+		FrameRate::framesPerSecond = 1.0 / headless.deltaTime;
+
+		{
+			Profiler::Scope profile("update");
+			scene->update();
+			updateScriptedCamera(frame);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		graphics.render(*scene, headless.width, headless.height, currentRenderingMode);
+		glFinish();
+		renderCost += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		FrameRate::frameCount++;
+		glError();
+		Profiler::endFrame();
+	}
+
+	std::cout << "Headless: " << std::fixed << std::setprecision(3) << 1000.0 * renderCost / headless.frames << " ms per frame." << std::endl;
+	Profiler::flush();
+	std::vector<std::string> profilerLines;
+	Profiler::getSummary(profilerLines);
+	for (const std::string& line : profilerLines) {
+		std::cout << "Headless: " << line << std::endl;
+	}
+	if (!headless.trace.empty()) {
+		Profiler::stopTrace();
+		Profiler::writeTrace(headless.trace);
+	}
+	captureFrame(headless.output);
+	shutdownHeadless();
+}
+
+void Application::runBenchmark() {
+	Benchmark::Settings settings;
+	settings.scene = headless.scene;
+	settings.warmupFrames = headless.warmupFrames;
+	settings.frames = headless.frames;
+	settings.width = headless.width;
+	settings.height = headless.height;
+	settings.deltaTime = headless.deltaTime;
+	settings.report = headless.report;
+	settings.baseline = headless.baseline;
+	settings.threshold = headless.threshold;
+
+	if (!headless.trace.empty()) {
+		Profiler::startTrace();
+	}
+
+	Benchmark benchmark(settings);
+	exitCode = benchmark.run(*this) != 0 ? 1 : 0;
+
+	if (!headless.trace.empty()) {
+		Profiler::stopTrace();
+		Profiler::writeTrace(headless.trace);
+	}
+	shutdownHeadless();
+}
+
+void Application::shutdownHeadless() {
+	// The context is left up for the process exit, graphics and the material store are static and release their
+	// GL objects from their destructors after this returns.
+	delete scene;
+	scene = nullptr;
+	FBO_2D::setDefault(nullptr);
+	offscreenFBO.reset();
+	std::cout << "Application has now terminated." << std::endl;
+}
+
 Application::~Application() {
 	delete scene;
     delete text;
@@ -354,9 +762,53 @@ void Application::GLFWKeyCallback(GLFWwindow * window, int key, int scanmode, in
 			glfwSetCursorPos(window, xwidth / 2, yheight / 2); // Reset mouse position for next update iteration.
 		}
 
+		// Switch voxelization strategy and compare what the two of them voxelize.
+		if (key == GLFW_KEY_V) {
+			bool geometryShader = app.graphics.toggleVoxelizationStrategy();
+			std::cout << "Voxelization: " << (geometryShader ? "geometry shader" : "depth peeling") << std::endl;
+			app.graphics.compareVoxelization(*app.scene);
+		}
+
+		// Toggle conservative voxelization and check it against the CPU voxelizer.
+		if (key == GLFW_KEY_B) {
+			if (!app.graphics.usesGeometryShaderVoxelization()) {
+				std::cout << "Conservative voxelization only applies to the geometry shader voxelization (V)." << std::endl;
+			}
+			else {
+				bool conservative = app.graphics.toggleConservativeVoxelization(*app.scene);
+				std::cout << "Conservative voxelization: " << (conservative ? "on" : "off") << std::endl;
+			}
+		}
+
 		// Pause / unpause.
 		if (key == GLFW_KEY_P) {
 			app.paused = !app.paused;
 		}
+
+		// Start / stop recording a trace of the profiled passes.
+		if (key == GLFW_KEY_T) {
+			if (Profiler::isTracing()) {
+				Profiler::stopTrace();
+				Profiler::writeTrace("trace.json");
+			}
+			else {
+				Profiler::startTrace();
+			}
+		}
+
+		// Start / stop recording the camera into camera.path, for the benchmark's camera paths.
+		if (key == GLFW_KEY_C) {
+			if (app.recordingPath) {
+				app.recordingPath = false;
+				if (app.recordedPath.save("camera.path")) {
+					std::cout << "Camera path written to camera.path" << std::endl;
+				}
+			}
+			else {
+				app.recordedPath.clear();
+				app.recordingStart = FrameRate::time;
+				app.recordingPath = true;
+			}
+		}
 	}
 }
@@ -3,9 +3,13 @@
 #pragma once
 
 #include "Graphic/Graphics.h"
+#include "Graphic/Camera/CameraPath.h"
+#include "glm/glm.hpp"
 #include <string>
+#include <memory>
 
 class TextQuad;
+class FBO_2D;
 class Scene;
 class PointLight;
 class MeshRenderer;
@@ -35,7 +39,7 @@ public:
     bool exitQueued = false;
     
     /// <summary> The currently opened window. </summary>
-    GLFWwindow * currentWindow;
+    GLFWwindow * currentWindow = nullptr;
     
     /// <summary> The scene to update and render. </summary>
     Scene * scene;
@@ -52,6 +56,41 @@ public:
     /// <summary> Runs the application. </summary>
     void run();
     
+    /// <summary> A run without a window: renders a fixed number of frames of a scene from a scripted camera with a
+    /// fixed time step, into an offscreen FBO that stands in for the default one, then writes the last frame to disk.
+    /// Meant for build machines without a GPU or a display. </summary>
+    struct HeadlessSettings
+    {
+        bool enabled = false;
+        std::string scene = ""; // cornell, dragon, multiple or glass, empty is the default level.
+        unsigned int frames = 120;
+        unsigned int width = 1024;
+        unsigned int height = 768;
+        std::string output = "frame.ppm";
+        std::string trace = ""; // Chrome trace of every frame, empty writes none.
+        std::string cameraPath = ""; // Camera path played instead of the sway, relative to the resource root.
+        double deltaTime = 1.0 / 60.0; // Fixed time step, so every run animates the same way.
+
+        // Benchmark runs (see Benchmark.h) render every scene and mode instead of one scene.
+        bool benchmark = false;
+        unsigned int warmupFrames = 30;
+        std::string report = "benchmark";
+        std::string baseline = ""; // report CSV of an earlier run, empty skips the regression check.
+        double threshold = 0.1;
+    };
+    HeadlessSettings headless;
+    
+    /// <summary> Reads --headless, --scene=, --frames=, --size=WxH, --output=, --trace= and --camera=, and for benchmark
+    /// runs --benchmark, --warmup=, --report=, --baseline= and --threshold=, into headless. Call before init(). </summary>
+    void parseArguments(int argc, const char * argv[]);
+
+    /// <summary> What main() returns, 1 when init() couldn't get an OpenGL context or a benchmark regressed against
+    /// its baseline. </summary>
+    int exitCode = 0;
+
+    /// <summary> A new ScenePack scene: cornell, dragon, multiple or glass, anything else is the default level. </summary>
+    static Scene * createScene(const std::string& name);
+    
     /// <summary> Sets the window mode to be borderless fullscreen. </summary>
     void SetBorderlessFullscreenMode();
     
@@ -88,4 +127,21 @@ private:
     static void OnWindowResize(GLFWwindow * window, int quadWidth, int quadHeight);
     
     TextQuad* text = nullptr;
+    
+    // --- Headless ---
+    bool createHeadlessContext();
+    void createOffscreenTarget();
+    void runHeadless();
+    void runBenchmark();
+    void shutdownHeadless();
+    void updateScriptedCamera(unsigned int frame);
+    void captureFrame(const std::string& path);
+    
+    std::shared_ptr<FBO_2D> offscreenFBO;
+    CameraPath scriptedPath;
+    
+    // --- Camera path recording (C) ---
+    CameraPath recordedPath;
+    bool recordingPath = false;
+    double recordingStart = 0.0;
 };
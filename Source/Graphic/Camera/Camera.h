@@ -1,7 +1,7 @@
 #pragma once
 
 #include "glm/gtc/matrix_transform.hpp"
-#include "OpenGl_Includes.h"
+#include "OpenGL_Includes.h"
 
 /// <summary> A camera base class. </summary>
 class Camera {
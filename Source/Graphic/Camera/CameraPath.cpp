@@ -0,0 +1,105 @@
+//
+//  CameraPath.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "CameraPath.h"
+#include "Camera.h"
+#include "glm/gtc/constants.hpp"
+#include "glm/gtx/rotate_vector.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <assert.h>
+
+bool CameraPath::load(const std::string& path)
+{
+    std::string assetPath = AssetStore::resourceRoot + path;
+    std::ifstream file(assetPath);
+    if(!file)
+    {
+        return false;
+    }
+
+    keyframes.clear();
+    std::string line;
+    while(std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream stream(line);
+        Keyframe keyframe;
+        if(stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+                  >> keyframe.forward.x >> keyframe.forward.y >> keyframe.forward.z)
+        {
+            if(!keyframes.empty() && keyframe.time <= keyframes.back().time)
+            {
+                std::cerr << "CameraPath: " << assetPath << " skips keyframe at " << keyframe.time << ", times have to go up." << std::endl;
+                continue;
+            }
+            keyframes.push_back(keyframe);
+        }
+    }
+    return !keyframes.empty();
+}
+
+bool CameraPath::save(const std::string& path) const
+{
+    std::ofstream file(path);
+    file << "# time px py pz fx fy fz" << std::endl;
+    file << std::fixed << std::setprecision(5);
+    for(const Keyframe& keyframe : keyframes)
+    {
+        file << keyframe.time << " " << keyframe.position.x << " " << keyframe.position.y << " " << keyframe.position.z << " "
+             << keyframe.forward.x << " " << keyframe.forward.y << " " << keyframe.forward.z << std::endl;
+    }
+    return bool(file);
+}
+
+void CameraPath::record(float time, const Camera& camera)
+{
+    if(!keyframes.empty() && time <= keyframes.back().time) return;
+
+    keyframes.push_back({ time, camera.position, camera.forward });
+}
+
+void CameraPath::apply(float time, Camera& camera) const
+{
+    assert(!keyframes.empty());
+
+    auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+                                 [](float value, const Keyframe& keyframe){ return value < keyframe.time; });
+    if(next == keyframes.begin())
+    {
+        camera.position = next->position;
+        camera.forward = next->forward;
+    }
+    else if(next == keyframes.end())
+    {
+        camera.position = keyframes.back().position;
+        camera.forward = keyframes.back().forward;
+    }
+    else
+    {
+        const Keyframe& previous = *(next - 1);
+        float t = (time - previous.time) / (next->time - previous.time);
+        camera.position = glm::mix(previous.position, next->position, t);
+        camera.forward = glm::normalize(glm::mix(previous.forward, next->forward, t));
+    }
+    camera.updateViewMatrix();
+}
+
+CameraPath CameraPath::sway(const glm::vec3& position, const glm::vec3& forward, float duration, float swayAngle)
+{
+    static const int KEYFRAMES = 32;
+
+    CameraPath path;
+    for(int i = 0; i <= KEYFRAMES; ++i)
+    {
+        float t = float(i) / float(KEYFRAMES);
+        float angle = swayAngle * sinf(t * glm::two_pi<float>());
+        path.keyframes.push_back({ t * duration, glm::rotateY(position, angle), glm::rotateY(forward, angle) });
+    }
+    return path;
+}
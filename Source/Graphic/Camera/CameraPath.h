@@ -0,0 +1,50 @@
+//
+//  CameraPath.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "Utility/AssetStore.h"
+
+class Camera;
+
+/// <summary> Camera positions and directions over time, played back by interpolating between keyframes.  Path files
+/// are text, one "time px py pz fx fy fz" keyframe per line with times in seconds going up; '#' starts a comment.
+/// </summary>
+class CameraPath : public AssetStore
+{
+public:
+    struct Keyframe
+    {
+        float time;
+        glm::vec3 position;
+        glm::vec3 forward;
+    };
+
+    /// <summary> path is relative to the resource root, like models are. </summary>
+    bool load(const std::string& path);
+
+    /// <summary> path is a plain file system path. </summary>
+    bool save(const std::string& path) const;
+
+    /// <summary> Adds where camera is at time, times have to go up. </summary>
+    void record(float time, const Camera& camera);
+
+    /// <summary> Puts camera where the path is at time, clamped to the ends of the path. </summary>
+    void apply(float time, Camera& camera) const;
+
+    inline float getDuration() const { return keyframes.empty() ? 0.0f : keyframes.back().time; }
+    inline bool empty() const { return keyframes.empty(); }
+    inline void clear() { keyframes.clear(); }
+
+    /// <summary> Turns around the y axis, swayAngle radians each way, and ends back at position looking down forward.
+    /// What scenes without a recorded path play. </summary>
+    static CameraPath sway(const glm::vec3& position, const glm::vec3& forward, float duration, float swayAngle);
+
+private:
+    std::vector<Keyframe> keyframes;
+};
@@ -16,6 +16,12 @@ void FirstPersonController::update() {
     double xpos, ypos;
     double xmid, ymid;
     GLFWwindow * window = Application::getInstance().currentWindow;
+    
+    //surfaceless headless runs have no window to read input from, the camera is scripted there
+    if (window == nullptr) {
+        renderingCamera->updateViewMatrix();
+        return;
+    }
 
     glfwGetCursorPos(window, &xpos, &ypos);
     
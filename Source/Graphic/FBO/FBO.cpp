@@ -3,6 +3,7 @@
 #include "FBO.h"
 #include "Texture.h"
 #include "OpenGL_Includes.h"
+#include "Graphic/GLState.h"
 
 
 int FBO::setupRenderTarget(Texture* target)
@@ -54,7 +55,7 @@ void FBO::Commands::init(FBO* _fbo)
 {
     assert(fbo == nullptr && "You must call FBO::Commands::end() to indicate end of frame rendering before starting a new frame commands");
     fbo = _fbo;
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo->frameBuffer);
+    GLState::bindFramebuffer(fbo->frameBuffer);
 
     unsigned int colorAttachment[50];
 
@@ -77,14 +78,13 @@ void FBO::Commands::init(FBO* _fbo)
 }
 void FBO::Commands::setViewport(int width, int height)
 {
-     glViewport(0, 0, width, height);
+    GLState::viewport(0, 0, width, height);
     
 }
 
 void FBO::Commands::getPreviousViewportSize()
 {
-    int dims[4];
-    glGetIntegerv(GL_VIEWPORT, dims);
+    glm::ivec4 dims = GLState::getViewport();
     previousViewportWidth = dims[2];
     previousViewportHeight = dims[3];
 }
@@ -103,47 +103,59 @@ void FBO::Commands::depthMask(bool _value)
 
 void FBO::Commands::activateCulling(bool value)
 {
-    value ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+    GLState::enable(GL_CULL_FACE, value);
 }
 
 void FBO::Commands::enableDepthTest(bool value)
 {
-    value ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+    GLState::enable(GL_DEPTH_TEST, value);
 }
 
 void FBO::Commands::enableBlend(bool value)
 {
-    value ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+    GLState::enable(GL_BLEND, value);
+}
+
+void FBO::Commands::scissor(int x, int y, int width, int height)
+{
+    GLState::enable(GL_SCISSOR_TEST, true);
+    glScissor(x, y, width, height);
+}
+
+void FBO::Commands::disableScissor()
+{
+    GLState::enable(GL_SCISSOR_TEST, false);
 }
 
 void FBO::Commands::enableAdditiveBlending()
 {
     enableBlend(true);
-    glBlendFunc(GL_ONE, GL_ONE);
+    GLState::blendFunc(GL_ONE, GL_ONE);
 }
 
 void FBO::Commands::backFaceCulling(bool _value)
 {
     if(_value)
     {
-        glEnable(GL_CULL_FACE); glCullFace(GL_BACK);
+        GLState::enable(GL_CULL_FACE, true); GLState::cullFace(GL_BACK);
     }
     else
     {
-        glDisable(GL_CULL_FACE);
+        GLState::enable(GL_CULL_FACE, false);
     }
 }
 
 void FBO::Commands::end()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+    GLState::bindFramebuffer(previousFBO);
     setViewport(previousViewportWidth, previousViewportHeight);
     fbo = nullptr;
 }
 
 void FBO::Commands::clearRenderTarget()
 {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_ACCUM_BUFFER_BIT);
+    //there is no accumulation buffer in a core profile, asking to clear it is a GL_INVALID_VALUE
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void FBO::Commands::setClearColor(glm::vec4 color)
@@ -159,7 +171,7 @@ void FBO::Commands::setDetphClearValue(float depth)
 void FBO::Commands::blendSrcAlphaOneMinusSrcAlpha()
 {
     enableBlend(true);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void FBO::Commands::setupTargetsForRendering(bool threeDimensions)
@@ -176,12 +188,12 @@ void FBO::Commands::setupTargetsForRendering(bool threeDimensions)
             colorAttachment[i] = GL_COLOR_ATTACHMENT0 + i;
             if(!threeDimensions)
             {
-                glBindTexture(GL_TEXTURE_2D, fbo->renderTextures[i]->GetTextureID());
+                GLState::bindTexture(GL_TEXTURE_2D, fbo->renderTextures[i]->GetTextureID());
                 glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)(i), GL_TEXTURE_2D, fbo->renderTextures[i]->GetTextureID(), 0);
             }
             else
             {
-                glBindTexture(GL_TEXTURE_3D, fbo->renderTextures[i]->GetTextureID());
+                GLState::bindTexture(GL_TEXTURE_3D, fbo->renderTextures[i]->GetTextureID());
                 glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)i, fbo->renderTextures[i]->GetTextureID(), 0);
             }
         }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Opengl_Includes.h"
+#include "OpenGL_Includes.h"
 #include "Graphic/Material/Texture/Texture.h"
 #include "glm/glm.hpp"
 #include <vector>
@@ -26,6 +26,8 @@ public:
         void depthMask( bool value);
         void activateCulling(bool value);
         void enableBlend(bool value);
+        void scissor(int x, int y, int width, int height);
+        void disableScissor();
         void enableAdditiveBlending();
         void blendSrcAlphaOneMinusSrcAlpha();
         void setClearColor(glm::vec4 color = glm::vec4(0.0f));
@@ -9,8 +9,9 @@ FBO_2D::FBO_2D(Texture::Dimensions &dimensions, Texture::Properties &textureProp
 : FBO(dimensions, textureProperties)
 {
     assert(dimensions.width != 0 && dimensions.height != 0);
+    //addRenderTarget checks completeness while this FBO is bound, afterwards the previous one is bound again and a
+    //surfaceless context doesn't have a default framebuffer to check
     addRenderTarget();
-    assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
 }
 
 
@@ -45,6 +46,16 @@ Texture* FBO_2D::addRenderTarget()
 
 }
 
+Texture* FBO_2D::addRenderTarget(const Texture::Properties& properties)
+{
+    Texture::Properties previous = textureProperties;
+    textureProperties = properties;
+    Texture* target = addRenderTarget();
+    textureProperties = previous;
+    
+    return target;
+}
+
 void FBO_2D::ClearRenderTextures()
 {
     for(Texture* texture : renderTextures)
@@ -65,8 +76,14 @@ std::shared_ptr<FBO_2D>& FBO_2D::getDefault()
     return defaultFBO;
 }
 
+void FBO_2D::setDefault(std::shared_ptr<FBO_2D> fbo)
+{
+    defaultFBO = fbo;
+}
+
 FBO_2D::~FBO_2D()
 {
+    GLState::deletedFramebuffer(frameBuffer);
     glDeleteFramebuffers(1, &frameBuffer);
 }
 
@@ -85,7 +102,7 @@ FBO::Commands()
     
     init(_fbo2D);
     
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo2d->frameBuffer);
+    GLState::bindFramebuffer(fbo2d->frameBuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, fbo2d->rbo);
 }
 
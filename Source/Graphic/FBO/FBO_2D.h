@@ -12,6 +12,7 @@
 #include "OpenGL_Includes.h"
 #include <array>
 #include <vector>
+#include <memory>
 
 #include "FBO.h"
 #include "Graphic/Material/Texture/Texture2D.h"
@@ -40,6 +41,9 @@ public:
     
     static std::shared_ptr<FBO_2D>& getDefault();
     
+    ///<summary> Everything that draws to the default FBO draws to fbo from now on, nullptr goes back to the window's. </summary>
+    static void setDefault(std::shared_ptr<FBO_2D> fbo);
+    
     FBO_2D():FBO(),depthTexture(nullptr)
         {};
     
@@ -47,6 +51,9 @@ public:
     ~FBO_2D() override;
     
     virtual Texture* addRenderTarget() override;
+    
+    //a target in a format other than the one the FBO was created with, e.g. a narrower one next to float targets
+    Texture* addRenderTarget(const Texture::Properties& properties);
     virtual Texture* addDepthTarget();
     inline Texture* getDepthTexture(){ return static_cast<Texture*>(depthTexture); }
     void ClearRenderTextures() override;
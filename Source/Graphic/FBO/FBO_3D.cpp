@@ -18,20 +18,25 @@ FBO_3D::FBO_3D(Texture::Dimensions &_dimensions, Texture::Properties &_propertie
 
 
 Texture* FBO_3D::addRenderTarget()
+{
+    return addRenderTarget(textureProperties);
+}
+
+Texture* FBO_3D::addRenderTarget(const Texture::Properties& properties)
 {
     assert(renderTextures.size() < MAX_RENDER_TARGETS);
     FBO_3D::Commands commands(this);
     Texture3D *target = new Texture3D();
-    target->SetWrap(textureProperties.wrap);
+    target->SetWrap(properties.wrap);
     
     target->SetWidth(dimensions.width);
     target->SetHeight(dimensions.height);
     target->SetDepth(dimensions.depth);
-    target->SetMinFilter(textureProperties.minFilter);
-    target->SetMagFilter(textureProperties.magFilter);
-    target->SetPixelFormat(textureProperties.pixelFormat);
-    target->SetDataType(textureProperties.dataFormat);
-    target->SetInternalFormat(textureProperties.internalFormat);
+    target->SetMinFilter(properties.minFilter);
+    target->SetMagFilter(properties.magFilter);
+    target->SetPixelFormat(properties.pixelFormat);
+    target->SetDataType(properties.dataFormat);
+    target->SetInternalFormat(properties.internalFormat);
     target->SaveTextureState();
     
     renderTextures.push_back(target);
@@ -55,6 +60,7 @@ void FBO_3D::ClearRenderTextures()
 }
 FBO_3D::~FBO_3D()
 {
+    GLState::deletedFramebuffer(frameBuffer);
     glDeleteFramebuffers(1, &frameBuffer);
 }
 
@@ -70,7 +76,7 @@ FBO::Commands()
         glGenFramebuffers(1, &fbo3d->frameBuffer);
     }
     init(_fbo3d);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo3d->frameBuffer);
+    GLState::bindFramebuffer(fbo3d->frameBuffer);
 }
 
 FBO_3D::Commands::~Commands()
@@ -38,6 +38,9 @@ public:
     ~FBO_3D() override;
     
     virtual Texture* addRenderTarget() override;
+    
+    //same as above, but the target's storage comes from properties instead of the ones the FBO was created with
+    Texture* addRenderTarget(const Texture::Properties& properties);
 private:
 
     unsigned int generateAttachment(unsigned int w, unsigned int h, bool depth, bool stencil, GLenum magFilter, GLenum minFilter, GLenum wrap);
@@ -0,0 +1,241 @@
+//
+//  GLState.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "GLState.h"
+#include <assert.h>
+
+const unsigned int GLState::MAX_TEXTURE_UNITS;
+const GLuint GLState::UNKNOWN;
+const unsigned int GLState::CAPABILITIES;
+const unsigned int GLState::TARGETS;
+
+GLuint GLState::program = GLState::UNKNOWN;
+GLuint GLState::vertexArray = GLState::UNKNOWN;
+GLuint GLState::framebuffer = GLState::UNKNOWN;
+GLuint GLState::unit = GLState::UNKNOWN;
+GLuint GLState::textures[GLState::MAX_TEXTURE_UNITS][GLState::TARGETS];
+GLuint GLState::capabilities[GLState::CAPABILITIES];
+GLuint GLState::blendSource = GLState::UNKNOWN;
+GLuint GLState::blendDestination = GLState::UNKNOWN;
+GLuint GLState::face = GLState::UNKNOWN;
+glm::ivec4 GLState::viewportRect;
+bool GLState::viewportKnown = false;
+GLState::Statistics GLState::statistics;
+
+namespace
+{
+    //the arrays can't be filled with UNKNOWN in their definitions
+    struct Startup
+    {
+        Startup(){ GLState::invalidate(); }
+    } startup;
+}
+
+bool GLState::changed(GLuint& shadow, GLuint value)
+{
+    if(shadow == value)
+    {
+        ++statistics.elided;
+        return false;
+    }
+    ++statistics.issued;
+    shadow = value;
+    return true;
+}
+
+unsigned int GLState::targetIndex(GLenum target)
+{
+    switch(target)
+    {
+        case GL_TEXTURE_2D:     return 0;
+        case GL_TEXTURE_3D:     return 1;
+        case GL_TEXTURE_BUFFER: return 2;
+        default:
+            assert(false && "only 2D, 3D and buffer textures are shadowed");
+            return 0;
+    }
+}
+
+unsigned int GLState::capabilityIndex(GLenum capability)
+{
+    switch(capability)
+    {
+        case GL_BLEND:          return 0;
+        case GL_DEPTH_TEST:     return 1;
+        case GL_CULL_FACE:      return 2;
+        case GL_SCISSOR_TEST:   return 3;
+        default:
+            assert(false && "capability isn't shadowed");
+            return 0;
+    }
+}
+
+void GLState::useProgram(GLuint value)
+{
+    if(changed(program, value)) glUseProgram(value);
+}
+
+void GLState::bindVertexArray(GLuint value)
+{
+    if(changed(vertexArray, value)) glBindVertexArray(value);
+}
+
+void GLState::bindFramebuffer(GLuint value)
+{
+    if(changed(framebuffer, value)) glBindFramebuffer(GL_FRAMEBUFFER, value);
+}
+
+void GLState::activeTexture(unsigned int value)
+{
+    assert(value < MAX_TEXTURE_UNITS);
+    if(changed(unit, value)) glActiveTexture(GL_TEXTURE0 + value);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+    //nothing bound through here yet, find out which unit GL is on
+    if(unit == UNKNOWN)
+    {
+        GLint active = GL_TEXTURE0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &active);
+        unit = GLuint(active - GL_TEXTURE0);
+    }
+    if(changed(textures[unit][targetIndex(target)], texture)) glBindTexture(target, texture);
+}
+
+void GLState::bindTexture(unsigned int _unit, GLenum target, GLuint texture)
+{
+    assert(_unit < MAX_TEXTURE_UNITS);
+    //only switch units when the binding changes, the active unit is nobody's business but this class'
+    if(textures[_unit][targetIndex(target)] == texture)
+    {
+        ++statistics.elided;
+        return;
+    }
+    activeTexture(_unit);
+    bindTexture(target, texture);
+}
+
+void GLState::enable(GLenum capability, bool value)
+{
+    if(changed(capabilities[capabilityIndex(capability)], value ? 1 : 0))
+    {
+        value ? glEnable(capability) : glDisable(capability);
+    }
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination)
+{
+    if(blendSource == source && blendDestination == destination)
+    {
+        ++statistics.elided;
+        return;
+    }
+    ++statistics.issued;
+    blendSource = source;
+    blendDestination = destination;
+    glBlendFunc(source, destination);
+}
+
+void GLState::cullFace(GLenum value)
+{
+    if(changed(face, value)) glCullFace(value);
+}
+
+void GLState::viewport(int x, int y, int width, int height)
+{
+    glm::ivec4 rect(x, y, width, height);
+    if(viewportKnown && viewportRect == rect)
+    {
+        ++statistics.elided;
+        return;
+    }
+    ++statistics.issued;
+    viewportRect = rect;
+    viewportKnown = true;
+    glViewport(x, y, width, height);
+}
+
+glm::ivec4 GLState::getViewport()
+{
+    if(!viewportKnown)
+    {
+        glGetIntegerv(GL_VIEWPORT, &viewportRect[0]);
+        viewportKnown = true;
+    }
+    return viewportRect;
+}
+
+GLuint GLState::getFramebuffer()
+{
+    if(framebuffer == UNKNOWN)
+    {
+        GLint bound = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+        framebuffer = GLuint(bound);
+    }
+    return framebuffer;
+}
+
+GLuint GLState::getTexture(GLenum target)
+{
+    if(unit == UNKNOWN)
+    {
+        GLint active = GL_TEXTURE0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &active);
+        unit = GLuint(active - GL_TEXTURE0);
+    }
+    GLuint& shadow = textures[unit][targetIndex(target)];
+    if(shadow == UNKNOWN)
+    {
+        GLint bound = 0;
+        static const GLenum bindings[TARGETS] = { GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_3D, GL_TEXTURE_BINDING_BUFFER };
+        glGetIntegerv(bindings[targetIndex(target)], &bound);
+        shadow = GLuint(bound);
+    }
+    return shadow;
+}
+
+void GLState::deletedProgram(GLuint value)
+{
+    //GL keeps a deleted program in use until another is, but it's gone as far as names go
+    if(program == value) program = UNKNOWN;
+}
+
+void GLState::deletedVertexArray(GLuint value)
+{
+    if(vertexArray == value) vertexArray = 0;
+}
+
+void GLState::deletedFramebuffer(GLuint value)
+{
+    if(framebuffer == value) framebuffer = 0;
+}
+
+void GLState::deletedTexture(GLuint value)
+{
+    for(unsigned int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+    {
+        for(GLuint& texture : textures[i])
+        {
+            if(texture == value) texture = 0;
+        }
+    }
+}
+
+void GLState::invalidate()
+{
+    program = vertexArray = framebuffer = unit = UNKNOWN;
+    for(unsigned int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+    {
+        textures[i][0] = textures[i][1] = textures[i][2] = UNKNOWN;
+    }
+    for(GLuint& capability : capabilities)
+    {
+        capability = UNKNOWN;
+    }
+    blendSource = blendDestination = face = UNKNOWN;
+    viewportKnown = false;
+}
@@ -0,0 +1,83 @@
+//
+//  GLState.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include "OpenGL_Includes.h"
+#include "glm/glm.hpp"
+
+/// <summary> Shadows the GL state the Commands classes keep setting (program, vertex array, framebuffer, texture
+/// bindings per unit, blend/depth/cull/scissor and the viewport) and only calls GL when a value actually changes.
+/// Every bind of these goes through here, anything that changes them behind its back has to call invalidate().
+/// State starts out unknown, so the first call for each piece of state always reaches GL. </summary>
+class GLState
+{
+public:
+    /// <summary> GL calls asked for since the last resetStatistics(), and how many of them were skipped. </summary>
+    struct Statistics
+    {
+        unsigned int issued = 0;
+        unsigned int elided = 0;
+    };
+    
+    static const unsigned int MAX_TEXTURE_UNITS = 32;
+    
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vao);
+    static void bindFramebuffer(GLuint framebuffer);
+    
+    /// <summary> unit counts from 0, not GL_TEXTURE0. </summary>
+    static void activeTexture(unsigned int unit);
+    
+    /// <summary> Binds to the active unit, target is GL_TEXTURE_2D, GL_TEXTURE_3D or GL_TEXTURE_BUFFER. </summary>
+    static void bindTexture(GLenum target, GLuint texture);
+    static void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+    
+    /// <summary> capability is GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE or GL_SCISSOR_TEST. </summary>
+    static void enable(GLenum capability, bool value);
+    static void blendFunc(GLenum source, GLenum destination);
+    static void cullFace(GLenum face);
+    static void viewport(int x, int y, int width, int height);
+    
+    /// <summary> The shadowed values, no glGet involved once they're known. </summary>
+    static glm::ivec4 getViewport();
+    static GLuint getFramebuffer();
+    static GLuint getTexture(GLenum target);
+    
+    /// <summary> GL unbinds deleted objects, these keep the shadow from thinking a recycled name is still bound. </summary>
+    static void deletedProgram(GLuint program);
+    static void deletedVertexArray(GLuint vao);
+    static void deletedFramebuffer(GLuint framebuffer);
+    static void deletedTexture(GLuint texture);
+    
+    /// <summary> Forgets everything, the next call for each piece of state goes to GL. </summary>
+    static void invalidate();
+    
+    static inline const Statistics& getStatistics(){ return statistics; }
+    static inline void resetStatistics(){ statistics = Statistics(); }
+    
+private:
+    static bool changed(GLuint& shadow, GLuint value);
+    static unsigned int targetIndex(GLenum target);
+    static unsigned int capabilityIndex(GLenum capability);
+    
+    static const GLuint UNKNOWN = 0xFFFFFFFF;
+    static const unsigned int CAPABILITIES = 4;
+    static const unsigned int TARGETS = 3;
+    
+    static GLuint program;
+    static GLuint vertexArray;
+    static GLuint framebuffer;
+    static GLuint unit;
+    static GLuint textures[MAX_TEXTURE_UNITS][TARGETS];
+    static GLuint capabilities[CAPABILITIES];
+    static GLuint blendSource;
+    static GLuint blendDestination;
+    static GLuint face;
+    static glm::ivec4 viewportRect;
+    static bool viewportKnown;
+    
+    static Statistics statistics;
+};
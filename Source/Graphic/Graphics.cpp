@@ -23,42 +23,256 @@
 #include "Graphic/Material/Voxelization/VoxelizationMaterial.h"
 #include "Graphic/Material/Voxelization/VoxelVisualizationMaterial.h"
 #include "Graphic/RenderTarget/VoxelizeRT.h"
+#include "Graphic/RenderTarget/CPUVoxelizeRT.h"
+#include "Graphic/RenderTarget/ClipmapVoxelizeRT.h"
 #include "Graphic/RenderTarget/VoxelVisualizationRT.h"
 #include "Graphic/RenderTarget/VoxelConeTracingRT.h"
 #include "Graphic/FBO/FBO_2D.h"
 #include "Graphic/FBO/FBO_3D.h"
+#include "Graphic/Voxelization/BrickPool.h"
+#include "Shape/DrawList.h"
+#include "Time/Profiler.h"
 #include "Texture3D.h"
+
+//voxelize on the CPU instead of depth peeling on the GPU, useful on machines where the GPU path isn't available
+#define __CPU_VOXELIZATION 0
+
+//cone trace and visualize through a sparse brick pool instead of the dense voxel textures.  With GPU voxelization the
+//voxels are read back every time they change, so this is mostly useful together with __CPU_VOXELIZATION
+#define __SPARSE_BRICK_POOL 0
+
+//cone trace through voxel cascades that follow the camera instead of the fixed volume, voxelized on the CPU.  The
+//voxelization visualization keeps showing the fixed volume
+#define __CLIPMAP_CASCADES 0
 
+//shade cone tracing once per pixel from a geometry buffer instead of once per fragment of every mesh drawn
+#define __DEFERRED_CONE_TRACING 1
+
+//keep indirect light from frame to frame, reprojected to where the camera moved, and trace only one in this many
+//screen tiles each frame (1, 2 or 4).  0 traces all of it from scratch every frame
+#define __TEMPORAL_INTERLEAVE 0
+
+//voxelize the GPU path's volume in one geometry shader pass instead of depth peeling it from the three axes, see
+//VoxelizeRT.h.  Can be switched at runtime with V
+#define __GEOMETRY_SHADER_VOXELIZATION 0
+
+//fill every voxel a triangle touches when voxelizing with the geometry shader, so thin walls don't leak light at low
+//resolutions.  Can be switched at runtime with B
+#define __CONSERVATIVE_VOXELIZATION 0
+
+//keep six directional albedo values per voxel in the GPU path's mip maps, so cones see thin walls at coarse levels as
+//opaque as they are, see AnisotropicMips.h.  The albedo mips take six times the memory
+#define __ANISOTROPIC_MIPMAPS 0
+
+//keep an occupancy pyramid next to the voxels so the visualization's rays jump over empty space instead of sampling
+//it, see OccupancyGrid.h.  Doesn't apply with the sparse brick pool, which skips empty bricks its own way
+#define __EMPTY_SPACE_SKIPPING 0
+
+//milliseconds a frame may spend voxelizing on the GPU path, the rest of a revoxelization waits for the next frames
+//while cone tracing keeps using the last finished volume.  0 revoxelizes in the frame it's needed
+#define __VOXELIZATION_BUDGET_MS 2.0
+
 // ----------------------
 // Rendering pipeline.
 // ----------------------
 void Graphics::init(unsigned int viewportWidth, unsigned int viewportHeight)
 {
     cubeShape = nullptr;
+    drawList = new DrawList();
+    
+#if __CPU_VOXELIZATION
+    cpuVoxelizeRenderTarget = new CPUVoxelizeRT();
+    cpuVoxelizeRenderTarget->setOccupancy(__EMPTY_SPACE_SKIPPING);
     
+    std::shared_ptr<FBO_3D> voxelFBO = cpuVoxelizeRenderTarget->getFBO();
+    std::vector<std::shared_ptr<Texture3D>>& albedoMipMaps = cpuVoxelizeRenderTarget->getAlbedoMipMaps();
+    std::vector<std::shared_ptr<Texture3D>>& normalMipMaps = cpuVoxelizeRenderTarget->getNormalMipMaps();
+    glm::mat4 voxViewProj = cpuVoxelizeRenderTarget->getVoxViewProjection();
+#else
     float const worldCubeDimensions = 10.0f;
     voxelizeRenderTarget = new VoxelizeRT(worldCubeDimensions, worldCubeDimensions,worldCubeDimensions);
+    voxelizeRenderTarget->setTimeBudget(__VOXELIZATION_BUDGET_MS);
+    voxelizeRenderTarget->setDrawList(drawList);
+#if __GEOMETRY_SHADER_VOXELIZATION
+    voxelizeRenderTarget->setStrategy(VoxelizeRT::Strategy::GEOMETRY_SHADER);
+#endif
+    voxelizeRenderTarget->setConservative(__CONSERVATIVE_VOXELIZATION);
+    voxelizeRenderTarget->setAnisotropic(__ANISOTROPIC_MIPMAPS);
+    voxelizeRenderTarget->setOccupancy(__EMPTY_SPACE_SKIPPING);
+    
+    std::shared_ptr<FBO_3D> voxelFBO = voxelizeRenderTarget->getFBO();
+    std::vector<std::shared_ptr<Texture3D>>& albedoMipMaps = voxelizeRenderTarget->getAlbedoMipMaps();
+    std::vector<std::shared_ptr<Texture3D>>& normalMipMaps = voxelizeRenderTarget->getNormalMipMaps();
+    glm::mat4 voxViewProj = voxelizeRenderTarget->getVoxViewProjection();
+#endif
 
-    Texture3D* albedoVoxels = static_cast<Texture3D*>(voxelizeRenderTarget->getFBO()->getRenderTexture(0));
-    Texture3D* normalVoxels = static_cast<Texture3D*>(voxelizeRenderTarget->getFBO()->getRenderTexture(1));
+    Texture3D* albedoVoxels = static_cast<Texture3D*>(voxelFBO->getRenderTexture(0));
+    Texture3D* normalVoxels = static_cast<Texture3D*>(voxelFBO->getRenderTexture(1));
     
     //std::shared_ptr<Texture3D> mipMap = voxelizeRenderTarget->getNormalMipMapLevel(5);
     voxVisualizationRT = new VoxelVisualizationRT(albedoVoxels);
+#if __CPU_VOXELIZATION
+    voxVisualizationRT->setOccupancy(cpuVoxelizeRenderTarget->getOccupancyTexture());
+#else
+    voxVisualizationRT->setOccupancy(voxelizeRenderTarget->getOccupancyTexture());
+#endif
     
-    glm::mat4 voxViewProj = voxelizeRenderTarget->getVoxViewProjection();
-    voxConeTracingRT = new VoxelConeTracingRT(albedoVoxels, normalVoxels, voxelizeRenderTarget->getAlbedoMipMaps(), voxelizeRenderTarget->getNormalMipMaps(),
-                                              voxViewProj);
+    voxConeTracingRT = new VoxelConeTracingRT(albedoVoxels, normalVoxels, albedoMipMaps, normalMipMaps, voxViewProj);
+    voxConeTracingRT->setDeferred(__DEFERRED_CONE_TRACING);
+    voxConeTracingRT->setTemporal(__TEMPORAL_INTERLEAVE);
+    voxConeTracingRT->setAnisotropic(voxelizeRenderTarget != nullptr && voxelizeRenderTarget->isAnisotropic());
+    voxConeTracingRT->setDrawList(drawList);
+    
+#if __SPARSE_BRICK_POOL
+    //the atlas is sized for half the bricks of a full volume, build() warns if a scene needs more than that
+    unsigned int levels = (unsigned int)albedoMipMaps.size() + 1;
+    unsigned int capacity = BrickPool::denseBrickCount(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS, levels) / 2;
+    brickPool = new BrickPool(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS, levels, capacity);
+    
+    voxVisualizationRT->setBrickPool(brickPool);
+    voxConeTracingRT->setBrickPool(brickPool);
+#endif
+    
+#if __CLIPMAP_CASCADES
+    clipmapVoxelizeRenderTarget = new ClipmapVoxelizeRT();
+    voxConeTracingRT->setClipmap(clipmapVoxelizeRenderTarget);
+#endif
+}
+
+void Graphics::queueVoxelization()
+{
+    if(voxelizeRenderTarget != nullptr) voxelizeRenderTarget->queueVoxelization();
+    if(cpuVoxelizeRenderTarget != nullptr) cpuVoxelizeRenderTarget->queueVoxelization();
+    if(clipmapVoxelizeRenderTarget != nullptr) clipmapVoxelizeRenderTarget->queueVoxelization();
+    if(voxConeTracingRT != nullptr) voxConeTracingRT->resetHistory();
+    if(drawList != nullptr) drawList->invalidate();
+}
+
+bool Graphics::toggleVoxelizationStrategy()
+{
+    if(voxelizeRenderTarget == nullptr) return false;
+    
+    using Strategy = VoxelizeRT::Strategy;
+    bool geometryShader = voxelizeRenderTarget->getStrategy() == Strategy::DEPTH_PEELING;
+    voxelizeRenderTarget->setStrategy(geometryShader ? Strategy::GEOMETRY_SHADER : Strategy::DEPTH_PEELING);
+    return geometryShader;
+}
+
+bool Graphics::usesGeometryShaderVoxelization() const
+{
+    return voxelizeRenderTarget != nullptr && voxelizeRenderTarget->getStrategy() == VoxelizeRT::Strategy::GEOMETRY_SHADER;
+}
+
+void Graphics::compareVoxelization(Scene & renderingScene)
+{
+    if(voxelizeRenderTarget == nullptr) return;
+    
+    DrawList::Commands drawCommands(drawList);
+    drawCommands.update(renderingScene);
+    voxelizeRenderTarget->compareCoverage(renderingScene);
+}
+
+bool Graphics::toggleConservativeVoxelization(Scene & renderingScene)
+{
+    if(!usesGeometryShaderVoxelization()) return false;
+    
+    voxelizeRenderTarget->setConservative(!voxelizeRenderTarget->isConservative());
+    
+    DrawList::Commands drawCommands(drawList);
+    drawCommands.update(renderingScene);
+    voxelizeRenderTarget->validateCoverage(renderingScene);
+    return voxelizeRenderTarget->isConservative();
+}
+
+unsigned int Graphics::getIndirectDivisor(RenderingMode renderingMode)
+{
+    switch(renderingMode)
+    {
+        case RenderingMode::VOXEL_CONE_TRACING:                     return 1;
+        case RenderingMode::VOXEL_CONE_TRACING_HALF_RESOLUTION:     return 2;
+        case RenderingMode::VOXEL_CONE_TRACING_QUARTER_RESOLUTION:  return 4;
+        default:                                                    return 0;
+    }
+}
+
+void Graphics::updateBrickPool()
+{
+    Profiler::Scope profile("brick pool");
+#if __CPU_VOXELIZATION
+    unsigned int revision = cpuVoxelizeRenderTarget->getRevision();
+    if(revision == brickPoolRevision) return;
+    
+    brickPool->build(cpuVoxelizeRenderTarget->getGrid(), cpuVoxelizeRenderTarget->getMipGrids());
+#else
+    unsigned int revision = voxelizeRenderTarget->getRevision();
+    if(revision == brickPoolRevision) return;
+    
+    voxelizeRenderTarget->readBack(brickPoolBase, brickPoolMips);
+    brickPool->build(brickPoolBase, brickPoolMips);
+#endif
+    brickPool->upload();
+    brickPoolRevision = revision;
 }
 
 void Graphics::render(Scene & renderingScene, unsigned int viewportWidth, unsigned int viewportHeight, RenderingMode renderingMode)
 {
-    voxelizeRenderTarget->Render(renderingScene);
+    {
+        Profiler::Scope profile("draw list");
+        DrawList::Commands drawCommands(drawList);
+        drawCommands.update(renderingScene);
+    }
+    
+    {
+        Profiler::Scope profile("voxelization");
+#if __CPU_VOXELIZATION
+        cpuVoxelizeRenderTarget->Render(renderingScene);
+#else
+        voxelizeRenderTarget->Render(renderingScene);
+        
+        //the volumes swap when a revoxelization finishes
+        unsigned int revision = voxelizeRenderTarget->getRevision();
+        if(revision != voxelRevision)
+        {
+            std::shared_ptr<FBO_3D> voxelFBO = voxelizeRenderTarget->getFBO();
+            voxConeTracingRT->setVoxels(static_cast<Texture3D*>(voxelFBO->getRenderTexture(0)), static_cast<Texture3D*>(voxelFBO->getRenderTexture(1)));
+            voxVisualizationRT->SetVoxelTexture(static_cast<Texture3D*>(voxelFBO->getRenderTexture(0)));
+            voxVisualizationRT->setOccupancy(voxelizeRenderTarget->getOccupancyTexture());
+            voxelRevision = revision;
+        }
+#endif
+    }
+    
+#if __CPU_VOXELIZATION
+    //depth peeling maps only exist on the GPU path
+    if( renderingMode >= RenderingMode::ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_0)
+    {
+        renderingMode = RenderingMode::VOXEL_CONE_TRACING;
+    }
+#endif
+    
+#if __SPARSE_BRICK_POOL
+    updateBrickPool();
+#endif
+    
+#if __CLIPMAP_CASCADES
+    if(getIndirectDivisor(renderingMode) > 0)
+    {
+        Profiler::Scope profile("clipmap voxelization");
+        clipmapVoxelizeRenderTarget->Render(renderingScene);
+    }
+#endif
 
     switch (renderingMode) {
     case RenderingMode::VOXELIZATION_VISUALIZATION:
+    {
+        Profiler::Scope profile("voxel visualization");
         voxVisualizationRT->Render(renderingScene);
         break;
+    }
     case RenderingMode::VOXEL_CONE_TRACING:
+    case RenderingMode::VOXEL_CONE_TRACING_HALF_RESOLUTION:
+    case RenderingMode::VOXEL_CONE_TRACING_QUARTER_RESOLUTION:
+        voxConeTracingRT->setResolution(viewportWidth, viewportHeight, getIndirectDivisor(renderingMode));
         voxConeTracingRT->Render(renderingScene);
         break;
     case RenderingMode::ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_0:
@@ -87,6 +301,10 @@ Graphics::~Graphics()
     delete worldPositionMaterial;
     delete voxelTexture;
     delete voxelizeRenderTarget;
+    delete cpuVoxelizeRenderTarget;
+    delete clipmapVoxelizeRenderTarget;
     delete voxVisualizationRT;
     delete voxConeTracingRT;
+    delete brickPool;
+    delete drawList;
 }
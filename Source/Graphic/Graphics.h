@@ -9,6 +9,7 @@
 #include "Scene/Scene.h"
 #include "Graphic/Camera/OrthographicCamera.h"
 #include "Shape/Mesh.h"
+#include "Graphic/Voxelization/VoxelGrid.h"
 
 class MeshRenderer;
 class Material;
@@ -21,8 +22,12 @@ class FBO_2D;
 class FBO_3D;
 class Texture3D;
 class VoxelizeRT;
+class CPUVoxelizeRT;
+class ClipmapVoxelizeRT;
 class VoxelVisualizationRT;
 class VoxelConeTracingRT;
+class BrickPool;
+class DrawList;
 
 
 /// <summary> A graphical context used for rendering. </summary>
@@ -32,6 +37,8 @@ public:
 	enum class RenderingMode {
 		VOXELIZATION_VISUALIZATION = 0,
 		VOXEL_CONE_TRACING,
+        VOXEL_CONE_TRACING_HALF_RESOLUTION,     //indirect light traced at half and a quarter of the screen's
+        VOXEL_CONE_TRACING_QUARTER_RESOLUTION,  //resolution, see VoxelConeTracingRT.h
         ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_0,
         ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_1,
         ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_2,
@@ -47,9 +54,34 @@ public:
 		Scene & renderingScene, unsigned int viewportWidth,
 		unsigned int viewportHeight, RenderingMode renderingMode = RenderingMode::VOXEL_CONE_TRACING
 	);
+
+	/// <summary> Revoxelizes everything next frame and forgets the indirect light kept from earlier frames, for when
+	/// the scene is swapped for another one. </summary>
+	void queueVoxelization();
+    
+    /// <summary> Switches the GPU voxelization between depth peeling and the single geometry shader pass, returns
+    /// whether it now uses the geometry shader.  Does nothing on the CPU path. </summary>
+    bool toggleVoxelizationStrategy();
+    
+    /// <summary> Whether the GPU voxelization currently uses the geometry shader pass. </summary>
+    bool usesGeometryShaderVoxelization() const;
+    
+    /// <summary> Voxelizes the scene with both GPU strategies and prints how their voxels differ. </summary>
+    void compareVoxelization(Scene & renderingScene);
+    
+    /// <summary> Switches conservative rasterization of the geometry shader voxelization on or off and checks the
+    /// voxels against the CPU voxelizer, returns whether it's now on.  Does nothing unless the geometry shader
+    /// voxelization is in use, depth peeling and the CPU path have no conservative mode. </summary>
+    bool toggleConservativeVoxelization(Scene & renderingScene);
+    
+    /// <summary> How many times smaller than the viewport on each side a cone tracing mode traces indirect light, 0
+    /// for the modes that don't cone trace. </summary>
+    static unsigned int getIndirectDivisor(RenderingMode renderingMode);
     
 	~Graphics();
 private:
+    
+    void updateBrickPool();
 
 	// ----------------
 	// Voxel cone tracing.
@@ -67,6 +99,15 @@ private:
     Texture3D* voxelTexture;
     
     VoxelizeRT* voxelizeRenderTarget = nullptr;
+    CPUVoxelizeRT* cpuVoxelizeRenderTarget = nullptr;
+    ClipmapVoxelizeRT* clipmapVoxelizeRenderTarget = nullptr;
     VoxelVisualizationRT* voxVisualizationRT = nullptr;
     VoxelConeTracingRT* voxConeTracingRT = nullptr;
+    DrawList* drawList = nullptr;               //every mesh of the scene, one draw per pass
+    unsigned int voxelRevision = 0;             //front volume the renderers were last given
+    
+    BrickPool* brickPool = nullptr;
+    unsigned int brickPoolRevision = 0;
+    VoxelGrid brickPoolBase;                    //GPU voxels read back to build the pool from
+    std::vector<VoxelGrid> brickPoolMips;
 };
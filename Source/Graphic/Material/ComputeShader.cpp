@@ -7,6 +7,9 @@
 //
 
 #include "ComputeShader.h"
+
+#ifdef __APPLE__
+
 #include <OpenGL/OpenGL.h>
 #include <OpenCL/OpenCL.h>
 #include <string.h>
@@ -351,7 +354,7 @@ void ComputeShader::run()
     
     cl_event kernel_completion;
 
-    int error = clEnqueueNDRangeKernel(command_queue, kernel, dimensions, NULL, globalWorkSize, nullptr, 0, NULL, &kernel_completion);
+    int error = clEnqueueNDRangeKernel(command_queue, kernel, dimensions, globalWorkOffset, globalWorkSize, nullptr, 0, NULL, &kernel_completion);
     checkError(error);
     error = clWaitForEvents(1, &kernel_completion);
     error |= clReleaseEvent(kernel_completion);
@@ -435,3 +438,5 @@ bool ComputeShader::checkError(cl_int errMsg)
 #endif
     return false;
 }
+
+#endif
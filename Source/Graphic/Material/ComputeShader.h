@@ -8,6 +8,10 @@
 
 #pragma once
 
+//the kernels reach GL textures through Apple's CGL share groups and run on a GCD queue, so this only exists on macOS.
+//Everywhere else VoxelizeRT builds its mip maps on the CPU, see __CPU_MIP_CHAIN
+#ifdef __APPLE__
+
 #include <OpenCL/OpenCL.h>
 #include <OpenGL/gl3.h>
 #include <OpenGL/gl3ext.h>
@@ -32,6 +36,7 @@ public:
     void setReadWriteImage2DArgument(int index, int textureID);
     
     void setGlobalWorkSize(glm::vec3 globalSize){ globalWorkSize[0] = globalSize.x; globalWorkSize[1] = globalSize.y; globalWorkSize[2] = globalSize.z; }
+    void setGlobalWorkOffset(glm::vec3 offset){ globalWorkOffset[0] = offset.x; globalWorkOffset[1] = offset.y; globalWorkOffset[2] = offset.z; }
     void run();
     
     
@@ -74,6 +79,7 @@ protected:
     cl_kernel kernel;
     
     size_t globalWorkSize[3] = {0,0,0};
+    size_t globalWorkOffset[3] = {0,0,0};
     
     static const int MAX_IMAGES = 9;
     cl_image image_objects[MAX_IMAGES];
@@ -85,3 +91,5 @@ protected:
     std::unordered_map<int, cl_image> images;
     std::unordered_map<int, cl_image> argument_images;
 };
+
+#endif
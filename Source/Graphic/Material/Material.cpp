@@ -9,6 +9,7 @@
 
 
 #include "Shader.h"
+#include "UniformBlocks.h"
 
 
 const char * const Material::Commands::PROJECTION_MATRIX_NAME = "P";
@@ -18,9 +19,12 @@ const char * const Material::Commands::NUMBER_OF_LIGHTS_NAME = "numberOfLights";
 const char * const Material::Commands::MODEL_MATRIX_NAME = "M";
 const char * const Material::Commands::SCREEN_SIZE_NAME = "screenSize";
 const char * const Material::Commands::APP_STATE_NAME = "state";
+
+Material::UniformLookups Material::uniformLookups;
 
 Material::~Material()
 {
+	GLState::deletedProgram(program);
 	glDeleteProgram(program);
 }
 
@@ -95,9 +99,91 @@ void Material::AssembleProgram(
     }
     else {
         std::cout << "- Material '" << name << "' (program " << program << ") sucessfully created." << std::endl;
+        reflectUniforms();
     }
 }
 
+void Material::reflectUniforms()
+{
+    uniforms.clear();
+    uniformLocations.clear();
+    
+    int count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    
+    GLchar uniformName[256];
+    for(int i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, GLuint(i), sizeof(uniformName), &length, &size, &type, uniformName);
+        
+        //uniforms living in a uniform block have no location
+        int location = glGetUniformLocation(program, uniformName);
+        if(location == -1) continue;
+        
+        //arrays are reported as "name[0]", parameters set them as "name", "name[0]" and "name[i]"
+        std::string base(uniformName, size_t(length));
+        size_t bracket = base.rfind("[0]");
+        bool isArray = bracket != std::string::npos && bracket + 3 == base.size();
+        if(isArray)
+        {
+            base.erase(bracket);
+            uniforms.push_back({ base, location, type });
+        }
+        uniforms.push_back({ std::string(uniformName, size_t(length)), location, type });
+        
+        for(GLint element = 1; isArray && element < size; ++element)
+        {
+            std::string elementName = base + "[" + std::to_string(element) + "]";
+            uniforms.push_back({ elementName, glGetUniformLocation(program, elementName.c_str()), type });
+        }
+    }
+    
+    //the vector is done growing, its strings can be keys now
+    uniformLocations.reserve(uniforms.size());
+    for(const Uniform& uniform : uniforms)
+    {
+        uniformLocations[uniform.name.c_str()] = uniform.location;
+    }
+    reflected = true;
+    
+    //every program sees a shared block at the same binding point, see UniformBlocks.h
+    int blocks = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blocks);
+    for(int i = 0; i < blocks; ++i)
+    {
+        glGetActiveUniformBlockName(program, GLuint(i), sizeof(uniformName), nullptr, uniformName);
+        int binding = UniformBlocks::getBinding(uniformName);
+        if(binding == -1)
+        {
+            std::cerr << "- Material '" << name << "' uses uniform block " << uniformName << " which has no binding." << std::endl;
+            continue;
+        }
+        glUniformBlockBinding(program, GLuint(i), GLuint(binding));
+    }
+    
+    //the draw table sits on the same unit for every program too, DrawList binds it there
+    int drawTable = getUniformLocation("drawTable");
+    if(drawTable != -1)
+    {
+        glProgramUniform1i(program, drawTable, GLint(UniformBlocks::DRAW_TABLE_UNIT));
+    }
+}
+
+int Material::getUniformLocation(const GLchar* uniformName) const
+{
+    if(!reflected)
+    {
+        ++uniformLookups.uncached;
+        return glGetUniformLocation(program, uniformName);
+    }
+    
+    ++uniformLookups.cachedByName;
+    auto it = uniformLocations.find(uniformName);
+    return it != uniformLocations.end() ? it->second : -1;
+}
 
 ///Comands
 
@@ -105,7 +191,7 @@ Material::Commands::Commands(Material* _material):
 textureUnits(0)
 {
     material = _material;
-    glUseProgram(material->program);
+    GLState::useProgram(material->program);
 }
 
 void Material::Commands::setValue(ShaderParameter &setting, const GLchar* name)
@@ -201,49 +287,49 @@ void Material::Commands::setValue(ShaderParameter &setting, const GLchar* name)
 
 int Material::Commands::SetParameteri(const GLchar* parameterName, int const value)
 {
-    int location = glGetUniformLocation(material->program, parameterName);
+    int location = material->getUniformLocation(parameterName);
     glUniform1i(location, value);
     return location;
 }
 
 int Material::Commands::SetParameterui(const GLchar* parameterName, unsigned int const value)
 {
-    unsigned int location = glGetUniformLocation(material->program, parameterName);
+    unsigned int location = material->getUniformLocation(parameterName);
     glUniform1ui(location, value);
     return location;
 }
 
 int Material::Commands::SetParameterf(const GLchar* parameterName, float const value)
 {
-    int location = glGetUniformLocation(material->program, parameterName);
+    int location = material->getUniformLocation(parameterName);
     glUniform1f(location,(value));
     return location;
 }
 
 int Material::Commands::SetParameterv4(const GLchar* parameterName, const glm::vec4 &value)
 {
-    int location = glGetUniformLocation(material->program, parameterName);
+    int location = material->getUniformLocation(parameterName);
     glUniform4fv(location, 1, glm::value_ptr(value));
     return location;
 }
 
 int Material::Commands::SetParameterv3(const GLchar *parameterName, const glm::vec3 &value)
 {
-    int location = glGetUniformLocation(material->program, parameterName);
+    int location = material->getUniformLocation(parameterName);
     glUniform3fv(location, 1, glm::value_ptr(value));
     return location;
 }
 
 int Material::Commands::SetParameterv2(const GLchar *parameterName, const glm::vec2 &value)
 {
-    int location = glGetUniformLocation(material->program, parameterName);
+    int location = material->getUniformLocation(parameterName);
     glUniform2fv(location, 1, glm::value_ptr(value));
     return location;
 }
 
 int Material::Commands::SetParamatermat4(const GLchar* parameterName, const glm::mat4 &value)
 {
-    int location = glGetUniformLocation(material->program, parameterName);
+    int location = material->getUniformLocation(parameterName);
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
     return location;
 }
@@ -263,9 +349,12 @@ int Material::Commands::SetParameterSampler3D(const GLchar* parameterName, Textu
 
 int Material::Commands::SetPointLight(const GLchar *parameterName, const PointLight &light)
 {
-    int location = glGetUniformLocation(material->program, ("pointLights[" + std::to_string(light.index) + "].position").c_str());
+    GLchar uniformName[64];
+    snprintf(uniformName, sizeof(uniformName), "pointLights[%u].position", light.index);
+    int location = material->getUniformLocation(uniformName);
     glUniform3fv(location, 1, glm::value_ptr(light.position));
-    location = location != -1 ?  glGetUniformLocation(material->program, ("pointLights[" + std::to_string(light.index) + "].color").c_str()) : location;
+    snprintf(uniformName, sizeof(uniformName), "pointLights[%u].color", light.index);
+    location = location != -1 ?  material->getUniformLocation(uniformName) : location;
     glUniform3fv(location, 1, glm::value_ptr(light.color));
     return location;
 }
@@ -273,9 +362,8 @@ int Material::Commands::SetPointLight(const GLchar *parameterName, const PointLi
 int Material::Commands::ActivateTexture2D(const GLchar* samplerName, const int textureName, const int textureUnit)
 {
     assert(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS > textureUnit);
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_2D, textureName);
-    int location = glGetUniformLocation(material->program, samplerName);
+    GLState::bindTexture(textureUnit, GL_TEXTURE_2D, textureName);
+    int location = material->getUniformLocation(samplerName);
     glUniform1i(location, textureUnit);
     
     return location;
@@ -283,7 +371,7 @@ int Material::Commands::ActivateTexture2D(const GLchar* samplerName, const int t
 
 int Material::Commands::SetParameterBool(const GLchar *parameterName, bool value)
 {
-    int result = glGetUniformLocation(material->program, parameterName);
+    int result = material->getUniformLocation(parameterName);
     glUniform1i(result, value);
     return result;
 }
@@ -305,18 +393,17 @@ int Material::Commands::ActivateTexture3D(const GLchar* samplerName, const int t
 {
     assert(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS > textureUnit);
     //bind texture to texture unit
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_3D, textureName);
+    GLState::bindTexture(textureUnit, GL_TEXTURE_3D, textureName);
     
     //bind shader uniform location to texture unit
-    int location = glGetUniformLocation(material->program, samplerName);
+    int location = material->getUniformLocation(samplerName);
     glUniform1i(location, textureUnit);
     return location;
 }
 
 int Material::Commands::SetMatrix(const GLchar* parameterName, const glm::mat4& mat)
 {
-    int location = glGetUniformLocation(material->program, parameterName);
+    int location = material->getUniformLocation(parameterName);
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
     return location;
 }
@@ -324,10 +411,10 @@ int Material::Commands::SetMatrix(const GLchar* parameterName, const glm::mat4&
 void Material::Commands::uploadParameters(ShaderParameter::ShaderParamsGroup &group)
 {
     textureUnits = 0;
-    for (std::pair<const GLchar* , ShaderParameter > pair : group)
+    for (ShaderParameterGroup::Entry& entry : group)
     {
-        const GLchar* name = pair.first;
-        ShaderParameter setting = pair.second;
+        const GLchar* name = entry.name;
+        ShaderParameter& setting = entry.parameter;
         glError();
         setValue(setting, name);
         glError();
@@ -340,7 +427,7 @@ void Material::Commands::uploadParameters(ShaderParameter::ShaderParamsGroup &gr
 
 Material::Commands::~Commands()
 {
-    glUseProgram(0);
+    //the program stays in use, the next Commands only switches it if it's a different one
 }
 
 
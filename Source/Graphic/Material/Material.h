@@ -9,6 +9,7 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <cstring>
 #include "Graphic/Material/Resource.h"
 #include "Graphic/Material/ShaderParameter.h"
 #include "Graphic/Lighting/PointLight.h"
@@ -25,6 +26,14 @@ class Scene;
 class Material : public Resource {
 public:
 
+    /// <summary> Uniform uploads since the last resetUniformLookups(), every one of them used to cost a
+    /// glGetUniformLocation call. </summary>
+    struct UniformLookups
+    {
+        unsigned int cachedByName = 0;  //name resolved through the material's reflected table
+        unsigned int uncached = 0;      //still went to glGetUniformLocation, the program was never reflected
+    };
+
     class Commands
     {
     public:
@@ -79,7 +88,14 @@ public:
     Material(const GLchar *name): name(name){}
     
 
-    inline void Deactivate(){ glUseProgram(0) ;}
+    inline void Deactivate(){ GLState::useProgram(0) ;}
+    
+    /// <summary> Location of an active uniform, -1 if the program doesn't use it.  Array elements and struct members
+    /// are looked up by their full name, e.g. "pointLights[0].color". </summary>
+    int getUniformLocation(const GLchar* name) const;
+    
+    static inline const UniformLookups& getUniformLookups(){ return uniformLookups; }
+    static inline void resetUniformLookups(){ uniformLookups = UniformLookups(); }
     
     virtual ~Material();
     
@@ -101,10 +117,45 @@ protected:
                         const ShaderSharedPtr& tessControlShader
                         );
     
+    /// <summary> Builds the name to location table from the program's active uniforms, once after linking. </summary>
+    void reflectUniforms();
+    
 
     
     /// <summary> The actual OpenGL / GLSL program identifier. </summary>
     unsigned int program;
+    
+private:
+    
+    struct CStringHash
+    {
+        inline size_t operator()(const GLchar* name) const
+        {
+            //FNV-1a
+            size_t hash = 2166136261u;
+            for(; *name; ++name) hash = (hash ^ size_t(*name)) * 16777619u;
+            return hash;
+        }
+    };
+    
+    struct CStringEqual
+    {
+        inline bool operator()(const GLchar* a, const GLchar* b) const { return std::strcmp(a, b) == 0; }
+    };
+    
+    struct Uniform
+    {
+        std::string name;
+        int location;
+        GLenum type;
+    };
+    
+    bool reflected = false;
+    std::vector<Uniform> uniforms;
+    //keys point into uniforms, which doesn't change once reflected
+    std::unordered_map<const GLchar*, int, CStringHash, CStringEqual> uniformLocations;
+    
+    static UniformLookups uniformLookups;
 
 public:
 
@@ -13,7 +13,8 @@
 #include "Graphic/Material/Voxelization/VoxelVisualizationMaterial.h"
 
 
-static std::unordered_map<const GLchar*,  ShaderSharedPtr> shaderDatabase;
+//keyed by path plus defines, the same file can be compiled in several variants
+static std::unordered_map<std::string,  ShaderSharedPtr> shaderDatabase;
 static std::unordered_map<const GLchar*,  MaterialSharedPtr > materialDatabase;
 
 MaterialStore::MaterialStore()
@@ -25,8 +26,15 @@ MaterialStore::MaterialStore()
     ShaderSharedPtr textureDisplayVert = AddShader("Texture Display/textureDisplay.vert", Shader::ShaderType::VERTEX);
     ShaderSharedPtr depthPeelingVert = AddShader("Depth Peeling/depthPeeling.vert", Shader::ShaderType::VERTEX);
     ShaderSharedPtr textDisplayVert = AddShader("Text Display/textDisplay.vert", Shader::ShaderType::VERTEX);
+    ShaderSharedPtr geometryVoxelizationVert = AddShader("Voxelization/geometryVoxelization.vert", Shader::ShaderType::VERTEX);
+    ShaderSharedPtr voxelResolveVert = AddShader("Voxelization/voxelResolve.vert", Shader::ShaderType::VERTEX);
 
     ShaderSharedPtr voxelizationGeom = AddShader("Voxelization/voxelization.geom", Shader::ShaderType::GEOMETRY);
+    //one invocation per 16 slabs of the volume, 32 is as many as OpenGL guarantees
+    unsigned int slabInvocations = (VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS + 15) / 16;
+    assert(slabInvocations <= 32 && "the geometry shader voxelizer covers up to 512 voxels a side");
+    std::string slabDefines = "INVOCATIONS=" + std::to_string(slabInvocations);
+    ShaderSharedPtr geometryVoxelizationGeom = AddShader("Voxelization/geometryVoxelization.geom", Shader::ShaderType::GEOMETRY, slabDefines.c_str());
     
     ShaderSharedPtr voxelizationFrag = AddShader("Voxelization/voxelization.frag", Shader::ShaderType::FRAGMENT);
     ShaderSharedPtr voxelConeTracingFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT);
@@ -35,16 +43,78 @@ MaterialStore::MaterialStore()
     ShaderSharedPtr textureDisplayFrag = AddShader("Texture Display/textureDisplay.frag", Shader::ShaderType::FRAGMENT);
     ShaderSharedPtr depthPeelingFrag = AddShader("Depth Peeling/depthPeeling.frag", Shader::ShaderType::FRAGMENT);
     ShaderSharedPtr textDisplayFrag = AddShader("Text Display/textDisplay.frag", Shader::ShaderType::FRAGMENT);
+    ShaderSharedPtr geometryBufferFrag = AddShader("Voxel Cone Tracing/geometryBuffer.frag", Shader::ShaderType::FRAGMENT);
+    ShaderSharedPtr geometryVoxelizationFrag = AddShader("Voxelization/geometryVoxelization.frag", Shader::ShaderType::FRAGMENT);
+    
+    ShaderSharedPtr voxelConeTracingSparseFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "SPARSE_BRICK_POOL");
+    ShaderSharedPtr voxelVisualizationSparseFrag = AddShader("Voxelization/Visualization/voxel_visualization.frag", Shader::ShaderType::FRAGMENT, "SPARSE_BRICK_POOL");
+    ShaderSharedPtr voxelVisualizationSkippingFrag = AddShader("Voxelization/Visualization/voxel_visualization.frag", Shader::ShaderType::FRAGMENT, "EMPTY_SPACE_SKIPPING");
+    ShaderSharedPtr voxelConeTracingClipmapFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "CLIPMAP_CASCADES");
+    
+    ShaderSharedPtr indirectTracingFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "INDIRECT_PASS");
+    ShaderSharedPtr indirectTracingSparseFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "INDIRECT_PASS SPARSE_BRICK_POOL");
+    ShaderSharedPtr indirectTracingClipmapFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "INDIRECT_PASS CLIPMAP_CASCADES");
+    ShaderSharedPtr upsampledConeTracingFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "UPSAMPLE_INDIRECT");
+    
+    ShaderSharedPtr deferredShadingFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "DEFERRED_SHADING");
+    ShaderSharedPtr deferredShadingSparseFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "DEFERRED_SHADING SPARSE_BRICK_POOL");
+    ShaderSharedPtr deferredShadingClipmapFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "DEFERRED_SHADING CLIPMAP_CASCADES");
+    ShaderSharedPtr deferredUpsampledShadingFrag = AddShader("Voxel Cone Tracing/voxelConeTracing.frag", Shader::ShaderType::FRAGMENT, "DEFERRED_SHADING UPSAMPLE_INDIRECT");
 
     
     MaterialSharedPtr voxelizationMaterial = CREATE_MAT<VoxelizationMaterial>("voxelization", voxelizationVert, voxelizationFrag, voxelizationGeom);
     AddMaterial(voxelizationMaterial);
     
+    MaterialSharedPtr voxelResolveMaterial = CREATE_MAT<VoxelizationMaterial>("voxel-resolve", voxelResolveVert, voxelizationFrag, voxelizationGeom);
+    AddMaterial(voxelResolveMaterial);
+    
     MaterialSharedPtr voxelizationConeTracing = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing", voxelConeTractingVert, voxelConeTracingFrag);
     AddMaterial(voxelizationConeTracing);
     
     MaterialSharedPtr voxelVizMaterial = CREATE_MAT<VoxelVisualizationMaterial>("voxel-visualization",  voxelVisualizationVert, voxelVisualizationFrag);
     AddMaterial(voxelVizMaterial);
+    
+    //same shaders, sampling the voxels through BrickPool's page table and atlas
+    MaterialSharedPtr voxelizationConeTracingSparse = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-sparse", voxelConeTractingVert, voxelConeTracingSparseFrag);
+    AddMaterial(voxelizationConeTracingSparse);
+    
+    MaterialSharedPtr voxelVizSparseMaterial = CREATE_MAT<VoxelVisualizationMaterial>("voxel-visualization-sparse",  voxelVisualizationVert, voxelVisualizationSparseFrag);
+    AddMaterial(voxelVizSparseMaterial);
+    
+    //same march, jumping over the empty cells of an occupancy pyramid, see OccupancyGrid.h
+    MaterialSharedPtr voxelVizSkippingMaterial = CREATE_MAT<VoxelVisualizationMaterial>("voxel-visualization-skipping",  voxelVisualizationVert, voxelVisualizationSkippingFrag);
+    AddMaterial(voxelVizSkippingMaterial);
+    
+    //cone tracing through ClipmapVoxelizeRT's camera centered cascades
+    MaterialSharedPtr voxelizationConeTracingClipmap = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-clipmap", voxelConeTractingVert, voxelConeTracingClipmapFrag);
+    AddMaterial(voxelizationConeTracingClipmap);
+    
+    //reduced resolution cone tracing, see VoxelConeTracingRT.h: indirect light is traced from the geometry buffer into
+    //a smaller target per voxel source, then the meshes are shaded with it upsampled
+    MaterialSharedPtr indirectTracing = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-indirect", textureDisplayVert, indirectTracingFrag);
+    AddMaterial(indirectTracing);
+    
+    MaterialSharedPtr indirectTracingSparse = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-indirect-sparse", textureDisplayVert, indirectTracingSparseFrag);
+    AddMaterial(indirectTracingSparse);
+    
+    MaterialSharedPtr indirectTracingClipmap = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-indirect-clipmap", textureDisplayVert, indirectTracingClipmapFrag);
+    AddMaterial(indirectTracingClipmap);
+    
+    MaterialSharedPtr upsampledConeTracing = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-upsampled", voxelConeTractingVert, upsampledConeTracingFrag);
+    AddMaterial(upsampledConeTracing);
+    
+    //deferred shading, one full screen pass over the geometry buffer
+    MaterialSharedPtr deferredShading = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-deferred", textureDisplayVert, deferredShadingFrag);
+    AddMaterial(deferredShading);
+    
+    MaterialSharedPtr deferredShadingSparse = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-deferred-sparse", textureDisplayVert, deferredShadingSparseFrag);
+    AddMaterial(deferredShadingSparse);
+    
+    MaterialSharedPtr deferredShadingClipmap = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-deferred-clipmap", textureDisplayVert, deferredShadingClipmapFrag);
+    AddMaterial(deferredShadingClipmap);
+    
+    MaterialSharedPtr deferredUpsampledShading = CREATE_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-deferred-upsampled", textureDisplayVert, deferredUpsampledShadingFrag);
+    AddMaterial(deferredUpsampledShading);
 
     MaterialSharedPtr material = CREATE_MAT<Material>("world-position", wordPositionVert, worldPositionFrag);
     AddMaterial(material);
@@ -55,9 +125,15 @@ MaterialStore::MaterialStore()
     material = CREATE_MAT<Material>("depth-peeling", depthPeelingVert, depthPeelingFrag);
     AddMaterial(material);
     
+    material = CREATE_MAT<Material>("geometry-voxelization", geometryVoxelizationVert, geometryVoxelizationFrag, geometryVoxelizationGeom);
+    AddMaterial(material);
+    
     material = CREATE_MAT<Material>("text-display", textDisplayVert, textDisplayFrag );
     AddMaterial(material);
     
+    material = CREATE_MAT<Material>("geometry-buffer", voxelConeTractingVert, geometryBufferFrag);
+    AddMaterial(material);
+    
     glError();
 }
 
@@ -70,18 +146,19 @@ void MaterialStore::AddMaterial( MaterialSharedPtr material)
     }
 }
 
-ShaderSharedPtr MaterialStore::AddShader(const GLchar *shaderPath, Shader::ShaderType shaderType)
+ShaderSharedPtr MaterialStore::AddShader(const GLchar *shaderPath, Shader::ShaderType shaderType, const GLchar* defines)
 {
     
     ShaderSharedPtr result = nullptr;
-    if(shaderDatabase.count(shaderPath) == 0)
+    std::string key = defines == nullptr ? std::string(shaderPath) : std::string(shaderPath) + "#" + defines;
+    if(shaderDatabase.count(key) == 0)
     {
-        result = std::make_shared<Shader>(shaderPath, shaderType);
-        shaderDatabase[shaderPath] = result;
+        result = std::make_shared<Shader>(shaderPath, shaderType, defines);
+        shaderDatabase[key] = result;
     }
     else
     {
-        result = shaderDatabase[shaderPath];
+        result = shaderDatabase[key];
     }
     
     return result;
@@ -33,7 +33,7 @@ private:
     
     MaterialSharedPtr getMaterial(const GLchar* name) const;
     inline ShaderSharedPtr const  findShaderUsingPath(const GLchar* path)const ;
-    ShaderSharedPtr AddShader(const GLchar* shaderPath, Shader::ShaderType shaderType);
+    ShaderSharedPtr AddShader(const GLchar* shaderPath, Shader::ShaderType shaderType, const GLchar* defines = nullptr);
     void AddMaterial( std::shared_ptr<Material> material);
     
     void InitShaders();
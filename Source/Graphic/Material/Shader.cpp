@@ -1,13 +1,36 @@
- #include "Shader.h"
+#include "Shader.h"
 
 #include "Resource.h"
 #include <cassert>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 
 
 const std::string Shader::shaderResourcePath =  "/Shaders/";
+
+namespace
+{
+    //pastes in the file an #include "..." line names, relative to the shaders folder
+    void appendInclude(const std::string& line, std::string& source)
+    {
+        size_t begin = line.find('"') + 1;
+        size_t end = line.find('"', begin);
+        std::string path = Resource::resourceRoot + Shader::shaderResourcePath + line.substr(begin, end - begin);
+        
+        std::ifstream includeStream(path, std::ios::in);
+        if (!includeStream.is_open()) {
+            std::cerr << "Couldn't load shader include '" + path + "'." << std::endl;
+            assert(false);
+            return;
+        }
+        std::string included;
+        while (std::getline(includeStream, included)) {
+            source.append(included + "\n");
+        }
+    }
+}
 
 unsigned int Shader::compile() {
 	// Create and compile shader.
@@ -40,7 +63,7 @@ unsigned int Shader::compile() {
 	return shaderID;
 }
 
-Shader::Shader(const char* _path, ShaderType _type) :  shaderType(_type) {
+Shader::Shader(const char* _path, ShaderType _type, const char* defines) :  shaderType(_type) {
 	
     // Load the shader instantly.
     path = Resource::resourceRoot + Shader::shaderResourcePath + _path;
@@ -56,10 +79,35 @@ Shader::Shader(const char* _path, ShaderType _type) :  shaderType(_type) {
 	rawShader = "";
 	while (!fileStream.eof()) {
 		std::getline(fileStream, line);
+        if (line.compare(0, 10, "#include \"") == 0) {
+            appendInclude(line, rawShader);
+            continue;
+        }
 		rawShader.append(line + "\n");
 	}
 	fileStream.close();
     
+    if(defines != nullptr)
+    {
+        std::string definitions;
+        std::istringstream names(defines);
+        std::string name;
+        while(names >> name)
+        {
+            size_t equals = name.find('=');
+            if(equals != std::string::npos)
+            {
+                name[equals] = ' ';
+            }
+            definitions += "#define " + name + "\n";
+        }
+        
+        //#version has to stay the first statement of the shader
+        size_t version = rawShader.find("#version");
+        size_t insertAt = version == std::string::npos ? 0 : rawShader.find('\n', version) + 1;
+        rawShader.insert(insertAt, definitions);
+    }
+    
     compile();
 }
 
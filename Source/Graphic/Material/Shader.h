@@ -3,6 +3,7 @@
 #include "OpenGL_Includes.h"
 
 #include <string>
+#include <memory>
 #include "Resource.h"
 
 
@@ -28,8 +29,10 @@ public:
     
     const int ShaderID() const { return shaderID; };
     
-    /// <summary> Creates and loads a shader from disk. Does not compile it. </summary>
-    Shader(const char* _path, ShaderType _type);
+    /// <summary> Creates and loads a shader from disk. Does not compile it. defines holds macro names separated by
+    /// spaces, NAME=VALUE giving one a value, each one is #defined right after the #version line so one file can be
+    /// built in several variants. </summary>
+    Shader(const char* _path, ShaderType _type, const char* defines = nullptr);
     
     /// <summary> Compiles the shader. Returns the OpenGL shader ID. </summary>
     unsigned int compile();
@@ -36,7 +36,10 @@ void Texture::Commands::end()
 
 void Texture::Commands::deleteTexture()
 {
+    GLState::deletedTexture(tex->textureID);
     glDeleteTextures(1, &tex->textureID);
+    //the texture may have been bound before these commands started, a deleted name can't be bound back at the end
+    if(previousTexture == int(tex->textureID)) previousTexture = 0;
 }
 
 void Texture::Commands::unpackAlignment(unsigned int alignment)
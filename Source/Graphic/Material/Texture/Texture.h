@@ -9,6 +9,7 @@
 #pragma once
 
 #include "OpenGL_Includes.h"
+#include "Graphic/GLState.h"
 #include <string>
 #include "glm.hpp"
 #include "Graphic/Material/Resource.h"
@@ -131,6 +132,7 @@ public:
     
     ~Texture()
     {
+        GLState::deletedTexture(textureID);
         glDeleteTextures(1, &textureID);
     }
     
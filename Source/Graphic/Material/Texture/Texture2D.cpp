@@ -77,7 +77,7 @@ Texture2D::~Texture2D()
 Texture2D::Commands::Commands(Texture2D* _texture):
 Texture::Commands(_texture)
 {
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    previousTexture = GLState::getTexture(GL_TEXTURE_2D);
     
     texture = _texture;
     if(texture->textureID == 0)
@@ -87,7 +87,7 @@ Texture::Commands(_texture)
     
 //    assert((GL_TEXTURE0 + textureUnit) < GL_ACTIVE_TEXTURE);
 //    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_2D, texture->textureID);
+    GLState::bindTexture(GL_TEXTURE_2D, texture->textureID);
 }
 
 
@@ -120,7 +120,15 @@ void Texture2D::Commands::enableMipMaps()
 void Texture2D::Commands::allocateOnGPU()
 {
     static const int border = 0;
-    int format = texture->pixelFormat == GL_DEPTH_COMPONENT32 ? GL_DEPTH_COMPONENT : texture->pixelFormat;
+    //sized formats store the texture, the data handed over is still described by the base format
+    int format = texture->pixelFormat;
+    switch(texture->pixelFormat)
+    {
+        case GL_DEPTH_COMPONENT32:  format = GL_DEPTH_COMPONENT; break;
+        case GL_RGBA16F:
+        case GL_RGBA32F:            format = GL_RGBA; break;
+        case GL_RGBA32UI:           format = GL_RGBA_INTEGER; break;
+    }
     glTexImage2D(GL_TEXTURE_2D, 0, texture->pixelFormat, texture->width, texture->height, border, format , texture->dataType , &texture->textureBuffer[0]);
     glError();
 }
@@ -138,7 +146,7 @@ void Texture2D::Commands::clear(glm::vec4 clearColor)
 void Texture2D::Commands::end()
 {
     Texture::Commands::end();
-    glBindTexture(GL_TEXTURE_2D, previousTexture);
+    GLState::bindTexture(GL_TEXTURE_2D, previousTexture);
 }
 
 #if __APPLE__
@@ -61,13 +61,15 @@ Texture3D::~Texture3D()
 Texture3D::Commands::Commands(Texture3D* _texture):
 Texture::Commands(_texture)
 {
+    previousTexture = GLState::getTexture(GL_TEXTURE_3D);
+    
     texture = _texture;
     if(texture->textureID == INVALID_TEXTURE)
     {
         glGenTextures(1, &texture->textureID);
     }
     
-    glBindTexture(GL_TEXTURE_3D, texture->textureID);
+    GLState::bindTexture(GL_TEXTURE_3D, texture->textureID);
 }
 
 #ifdef __APPLE__
@@ -105,8 +107,7 @@ void Texture3D::Commands::glTexStorage3D(    GLenum target,
     glError();
     for (GLsizei i = 0; i < levels; i++)
     {
-        unsigned int dataType = GL_FLOAT;
-        glTexImage3D(target, i, internalformat, tempWidth, tempHeight, tempDepth, 0, texture->pixelFormat, dataType, NULL);
+        glTexImage3D(target, i, internalformat, tempWidth, tempHeight, tempDepth, 0, texture->pixelFormat, texture->dataType, NULL);
         tempWidth = std::max(1, (int)(tempWidth >> 1));
         tempHeight = std::max(1, (int)(tempHeight >> 1));
         tempDepth = std::max(1, (int)(tempDepth >> 1));
@@ -135,16 +136,78 @@ void Texture3D::Commands::setMagFiltering(unsigned int filter)
 void Texture3D::Commands::allocateOnGPU()
 {
     glError();
-    glTexStorage3D(GL_TEXTURE_3D, levels, texture->pixelFormat);
     int level = 0, border = 0;
+#ifdef __APPLE__
+    glTexStorage3D(GL_TEXTURE_3D, levels, texture->internalFormat);
     glTexImage3D(GL_TEXTURE_3D, level, texture->internalFormat, texture->width, texture->height, texture->depth, border, texture->pixelFormat, texture->dataType, &texture->textureBuffer[0]);
+#else
+    //the real glTexStorage3D makes the storage immutable, a texture allocated twice or smaller than 2^levels would be
+    //rejected, so the levels are specified one by one the same way the Apple version does it
+    for (GLsizei i = 0; i < levels; i++)
+    {
+        unsigned int levelWidth = std::max(1, (int)(texture->width >> i));
+        unsigned int levelHeight = std::max(1, (int)(texture->height >> i));
+        unsigned int levelDepth = std::max(1, (int)(texture->depth >> i));
+        glTexImage3D(GL_TEXTURE_3D, i, texture->internalFormat, levelWidth, levelHeight, levelDepth, border, texture->pixelFormat, texture->dataType, i == level ? &texture->textureBuffer[0] : NULL);
+    }
+#endif
+    glError();
+}
+
+void Texture3D::Commands::uploadData(const void* data, int level)
+{
+    unsigned int levelWidth = std::max(1, (int)(texture->width >> level));
+    unsigned int levelHeight = std::max(1, (int)(texture->height >> level));
+    unsigned int levelDepth = std::max(1, (int)(texture->depth >> level));
+    glTexSubImage3D(GL_TEXTURE_3D, level, 0, 0, 0, levelWidth, levelHeight, levelDepth, texture->pixelFormat, texture->dataType, data);
+    glError();
+}
+
+void Texture3D::Commands::uploadRegion(const void* data, glm::ivec3 offset, glm::ivec3 size, int level)
+{
+    int levelWidth = std::max(1, (int)(texture->width >> level));
+    int levelHeight = std::max(1, (int)(texture->height >> level));
+    
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, levelWidth);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, levelHeight);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, offset.x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, offset.y);
+    glPixelStorei(GL_UNPACK_SKIP_IMAGES, offset.z);
+    
+    glTexSubImage3D(GL_TEXTURE_3D, level, offset.x, offset.y, offset.z, size.x, size.y, size.z, texture->pixelFormat, texture->dataType, data);
+    
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_IMAGES, 0);
+    glError();
+}
+
+void Texture3D::Commands::clearRegion(glm::ivec3 offset, glm::ivec3 size, int level)
+{
+    //zero bytes are zero in every format we use, 16 bytes covers the widest texel (RGBA32F)
+    static std::vector<unsigned char> zeros;
+    size_t bytes = size_t(size.x) * size.y * size.z * 16;
+    if(zeros.size() < bytes)
+    {
+        zeros.resize(bytes, 0);
+    }
+    
+    glTexSubImage3D(GL_TEXTURE_3D, level, offset.x, offset.y, offset.z, size.x, size.y, size.z, texture->pixelFormat, texture->dataType, zeros.data());
+    glError();
+}
+
+void Texture3D::Commands::readData(void* data, int level)
+{
+    glGetTexImage(GL_TEXTURE_3D, level, texture->pixelFormat, texture->dataType, data);
     glError();
 }
 
 void Texture3D::Commands::end()
 {
     Texture::Commands::end();
-    glBindTexture(GL_TEXTURE_2D, previousTexture);
+    GLState::bindTexture(GL_TEXTURE_3D, previousTexture);
 }
 void Texture3D::Commands::generateMipmaps()
 {
@@ -21,6 +21,12 @@ public:
         void enableMipMaps() override;
         void generateMipmaps() override;
         void allocateOnGPU() override;
+        void uploadData(const void* data, int level = 0);
+        
+        //data holds the whole level, only the texels in [offset, offset + size) are sent
+        void uploadRegion(const void* data, glm::ivec3 offset, glm::ivec3 size, int level = 0);
+        void clearRegion(glm::ivec3 offset, glm::ivec3 size, int level = 0);
+        void readData(void* data, int level = 0);
         void end() override;
         ~Commands();
     private:
@@ -0,0 +1,18 @@
+//
+//  UniformBlocks.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "UniformBlocks.h"
+#include <cstring>
+
+const unsigned int UniformBlocks::MAX_LIGHTS;
+const unsigned int UniformBlocks::SAMPLING_RAYS;
+const unsigned int UniformBlocks::MIP_MAPS;
+const unsigned int UniformBlocks::DRAW_TABLE_UNIT;
+
+int UniformBlocks::getBinding(const GLchar* blockName)
+{
+    if(std::strcmp(blockName, "FrameBlock") == 0) return FRAME_BINDING;
+    return -1;
+}
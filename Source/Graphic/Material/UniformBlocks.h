@@ -0,0 +1,86 @@
+//
+//  UniformBlocks.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include "OpenGL_Includes.h"
+#include "glm/glm.hpp"
+#include <cstddef>
+
+/// <summary> C++ side of the std140 uniform blocks declared in Shaders/Common/uniformBlocks.glsl, and the binding point
+/// each block gets in every program.  GLSL 4.1 can't give a block its binding, so Material binds every block it finds
+/// by name right after linking; a buffer bound to FRAME_BINDING is then seen by all shaders that include the file.
+/// The structs are laid out the way std140 wants them, vec3 arrays and float arrays step 16 bytes.  Draw isn't a block,
+/// DrawList keeps one per mesh in a texture buffer that every program sees on DRAW_TABLE_UNIT, see
+/// Shaders/Common/drawTable.glsl. </summary>
+class UniformBlocks
+{
+public:
+    static const unsigned int MAX_LIGHTS = 1;
+    static const unsigned int SAMPLING_RAYS = 5;
+    static const unsigned int MIP_MAPS = 7;
+    
+    enum Binding : GLuint
+    {
+        FRAME_BINDING = 0
+    };
+    
+    //above every unit Material hands out to the samplers it uploads
+    static const unsigned int DRAW_TABLE_UNIT = 31;
+    
+    struct PointLight
+    {
+        glm::vec3 position;
+        float padding0;
+        glm::vec3 color;
+        float padding1;
+    };
+    
+    /// <summary> "FrameBlock", what stays the same for every draw of a pass. </summary>
+    struct Frame
+    {
+        glm::mat4 V;
+        glm::mat4 P;
+        glm::mat4 voxViewProjection;
+        glm::vec3 cameraPosition;
+        float voxelDimensionsInWorldSpace;
+        PointLight pointLights[MAX_LIGHTS];
+        glm::vec4 samplingRays[SAMPLING_RAYS];  //xyz
+        glm::vec4 coneVariances[MIP_MAPS];      //x
+        int numberOfLights;
+        unsigned int numberOfLods;
+        unsigned int octahedralNormals;         //a GLSL bool is 4 bytes
+        float padding;
+    };
+    
+    /// <summary> A record of the draw table, the model matrix and the voxel material properties of one mesh.  Eight
+    /// RGBA32F texels, the shaders fetch them in this order. </summary>
+    struct Draw
+    {
+        glm::mat4 M;
+        glm::vec3 diffuseColor;
+        float diffuseReflectivity;
+        glm::vec3 specularColor;
+        float specularDiffusion;
+        float specularReflectivity;
+        float emissivity;
+        float refractiveIndex;
+        float transparency;
+        float padding[4];
+    };
+    
+    /// <summary> Binding point of the block called blockName, -1 if it isn't one of these blocks. </summary>
+    static int getBinding(const GLchar* blockName);
+};
+
+static_assert(offsetof(UniformBlocks::Frame, cameraPosition) == 192, "FrameBlock doesn't match std140");
+static_assert(offsetof(UniformBlocks::Frame, pointLights) == 208, "FrameBlock doesn't match std140");
+static_assert(offsetof(UniformBlocks::Frame, samplingRays) == 240, "FrameBlock doesn't match std140");
+static_assert(offsetof(UniformBlocks::Frame, coneVariances) == 320, "FrameBlock doesn't match std140");
+static_assert(offsetof(UniformBlocks::Frame, numberOfLights) == 432, "FrameBlock doesn't match std140");
+static_assert(sizeof(UniformBlocks::Frame) == 448, "FrameBlock doesn't match std140");
+static_assert(offsetof(UniformBlocks::Draw, diffuseColor) == 64, "Draw doesn't match drawTable.glsl");
+static_assert(offsetof(UniformBlocks::Draw, transparency) == 108, "Draw doesn't match drawTable.glsl");
+static_assert(sizeof(UniformBlocks::Draw) == 128, "Draw doesn't match drawTable.glsl");
@@ -0,0 +1,51 @@
+//
+//  UniformBuffer.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "UniformBuffer.h"
+#include <assert.h>
+
+UniformBuffer::UniformBuffer(size_t _blockSize):
+blockSize(_blockSize)
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride = (blockSize + size_t(alignment) - 1) / size_t(alignment) * size_t(alignment);
+    
+    glGenBuffers(1, &ubo);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    glDeleteBuffers(1, &ubo);
+}
+
+UniformBuffer::Commands::Commands(UniformBuffer* _buffer):
+buffer(_buffer)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer->ubo);
+}
+
+void UniformBuffer::Commands::allocate(size_t count)
+{
+    buffer->count = count;
+    glBufferData(GL_UNIFORM_BUFFER, GLsizeiptr(buffer->stride * count), nullptr, GL_DYNAMIC_DRAW);
+}
+
+void UniformBuffer::Commands::upload(const void* data, size_t index)
+{
+    assert(index < buffer->count);
+    glBufferSubData(GL_UNIFORM_BUFFER, GLintptr(buffer->stride * index), GLsizeiptr(buffer->blockSize), data);
+}
+
+void UniformBuffer::Commands::bindRange(GLuint binding, size_t index)
+{
+    assert(index < buffer->count);
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer->ubo, GLintptr(buffer->stride * index), GLsizeiptr(buffer->blockSize));
+}
+
+UniformBuffer::Commands::~Commands()
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
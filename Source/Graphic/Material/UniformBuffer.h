@@ -0,0 +1,51 @@
+//
+//  UniformBuffer.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include "OpenGL_Includes.h"
+#include <cstddef>
+
+/// <summary> A GL_UNIFORM_BUFFER holding one or more std140 blocks (see UniformBlocks.h).  Several copies of a block
+/// can share one buffer at getStride() apart, a draw then picks its copy with a single bindRange(). </summary>
+class UniformBuffer
+{
+public:
+    
+    class Commands
+    {
+    public:
+        explicit Commands(UniformBuffer* buffer);
+        
+        /// <summary> Makes room for count copies of the block, whatever the buffer held is lost. </summary>
+        void allocate(size_t count);
+        
+        void upload(const void* data, size_t index = 0);
+        
+        /// <summary> Binds copy index to binding, the block the shaders see there from now on. </summary>
+        void bindRange(GLuint binding, size_t index = 0);
+        
+        ~Commands();
+        
+    private:
+        UniformBuffer* buffer = nullptr;
+    };
+    
+    explicit UniformBuffer(size_t blockSize);
+    ~UniformBuffer();
+    
+    inline size_t getCount() const { return count; }
+    
+    /// <summary> blockSize rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. </summary>
+    inline size_t getStride() const { return stride; }
+    
+private:
+    UniformBuffer(UniformBuffer& rhs);
+    
+    GLuint ubo = 0;
+    size_t blockSize = 0;
+    size_t stride = 0;
+    size_t count = 0;
+};
@@ -16,6 +16,9 @@
 
 constexpr unsigned int VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS = 64u;
 
+//RGBA8 albedo with octahedral normals takes 3/8 of the memory and bandwidth, see VoxelFormat::report() for what it costs in accuracy
+const VoxelFormat VoxelizationMaterial::VOXEL_FORMAT = VoxelFormat(VoxelFormat::Albedo::RGBA32F, VoxelFormat::Normal::RGBA32F);
+
 VoxelizationMaterial::VoxelizationMaterial(const GLchar* _name, const ShaderSharedPtr vertexShader,
                                            const ShaderSharedPtr fragmentShader, const ShaderSharedPtr geometryShader):
 Material(_name, vertexShader, fragmentShader, geometryShader)
@@ -12,6 +12,7 @@
 #include "Graphic/Material/Shader.h"
 #include "Shape/Transform.h"
 #include "Graphic/Camera/OrthographicCamera.h"
+#include "Graphic/Voxelization/VoxelFormat.h"
 #include <string>
 
 
@@ -60,6 +61,16 @@ public:
             return *this;
         }
         
+        inline bool operator==(const VoxProperties& properties) const
+        {
+            return diffuseColor == properties.diffuseColor && specularColor == properties.specularColor &&
+            diffuseReflectivity == properties.diffuseReflectivity && specularReflectivity == properties.specularReflectivity &&
+            specularDiffusion == properties.specularDiffusion && emissivity == properties.emissivity &&
+            transparency == properties.transparency && refractiveIndex == properties.refractiveIndex;
+        }
+        
+        inline bool operator!=(const VoxProperties& properties) const { return !(*this == properties); }
+        
     private:
         
         inline void copy(const VoxProperties& properties)
@@ -107,6 +118,7 @@ private:
 public:
     static const std::vector<float> initTextureBuffer;
     static const unsigned int VOXEL_TEXTURE_DIMENSIONS; //must be a power of two
+    static const VoxelFormat VOXEL_FORMAT;              //storage of the albedo and normal voxel textures and their mips
     
 };
 
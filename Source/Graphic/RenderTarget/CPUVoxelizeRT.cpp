@@ -0,0 +1,151 @@
+//
+//  CPUVoxelizeRT.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "CPUVoxelizeRT.h"
+#include "VoxelizeRT.h"
+#include "Graphic/Material/Texture/Texture3D.h"
+#include "Graphic/Material/Voxelization/VoxelizationMaterial.h"
+#include "Graphic/FBO/FBO_3D.h"
+#include "Graphic/Voxelization/MipChainBuilder.h"
+#include <assert.h>
+#include <iostream>
+
+CPUVoxelizeRT::CPUVoxelizeRT():
+voxViewProjection(VoxelizeRT::makeVoxViewProjection()),
+voxelizer(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS, voxViewProjection),
+grid(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS)
+{
+    Texture::Dimensions dimensions;
+    dimensions.width = dimensions.height = dimensions.depth = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
+
+    Texture::Properties properties;
+    properties.minFilter = GL_NEAREST;
+    properties.magFilter = GL_NEAREST;
+
+    Texture::Properties albedoProperties = properties;
+    Texture::Properties normalProperties = properties;
+    VoxelizationMaterial::VOXEL_FORMAT.setAlbedoProperties(albedoProperties);
+    VoxelizationMaterial::VOXEL_FORMAT.setNormalProperties(normalProperties);
+
+    //same layout as VoxelizeRT so the visualization and cone tracing targets can't tell them apart
+    voxelFBO = std::make_shared<FBO_3D>(dimensions, albedoProperties);
+    voxelFBO->addRenderTarget(normalProperties);
+
+    initMipMaps(albedoProperties, normalProperties);
+}
+
+void CPUVoxelizeRT::initMipMaps(Texture::Properties &albedoProperties, Texture::Properties &normalProperties)
+{
+    unsigned int downDimensions = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS >> 1;
+    while(downDimensions)
+    {
+        std::shared_ptr<Texture3D> textures[2] = { std::make_shared<Texture3D>(), std::make_shared<Texture3D>() };
+        for(int i = 0; i < 2; ++i)
+        {
+            std::shared_ptr<Texture3D>& texture = textures[i];
+            Texture::Properties& properties = i == 0 ? albedoProperties : normalProperties;
+            texture->SetWidth(downDimensions);
+            texture->SetHeight(downDimensions);
+            texture->SetDepth(downDimensions);
+            texture->SetWrap(properties.wrap);
+            texture->SetMinFilter(properties.minFilter);
+            texture->SetMagFilter(properties.magFilter);
+            texture->SetPixelFormat(properties.pixelFormat);
+            texture->SetDataType(properties.dataFormat);
+            texture->SetInternalFormat(properties.internalFormat);
+            texture->SaveTextureState();
+        }
+
+        albedoMipMaps.push_back(textures[0]);
+        normalMipMaps.push_back(textures[1]);
+        mipGrids.push_back(VoxelGrid(downDimensions));
+
+        downDimensions = downDimensions >> 1;
+    }
+}
+
+void CPUVoxelizeRT::upload(const VoxelGrid& source, Texture3D* albedoTexture, Texture3D* normalTexture, const VoxelGrid::Region& region)
+{
+    {
+        Texture3D::Commands commands(albedoTexture);
+        commands.uploadRegion(&source.albedo[0], region.begin, region.size());
+    }
+    {
+        Texture3D::Commands commands(normalTexture);
+        commands.uploadRegion(VoxelizationMaterial::VOXEL_FORMAT.encodeNormals(source, region, encodedNormals), region.begin, region.size());
+    }
+}
+
+void CPUVoxelizeRT::setOccupancy(bool value)
+{
+    if(value == (occupancyTexture != nullptr)) return;
+    
+    occupancyTexture = nullptr;
+    if(value)
+    {
+        occupancyTexture = OccupancyGrid::createTexture(grid.getDimensions());
+        occupancy.build(grid);
+        occupancy.upload(occupancyTexture.get());
+    }
+}
+
+void CPUVoxelizeRT::generateMipMaps(VoxelGrid::Region region)
+{
+    MipChainBuilder::build(grid, mipGrids, region);
+    if(occupancyTexture != nullptr)
+    {
+        occupancy.build(grid, region);
+        occupancy.upload(occupancyTexture.get());
+    }
+    for(size_t i = 0; i < mipGrids.size(); ++i)
+    {
+        region = region.downsampled();
+        upload(mipGrids[i], albedoMipMaps[i].get(), normalMipMaps[i].get(), region);
+    }
+}
+
+void CPUVoxelizeRT::Render(Scene& renderScene)
+{
+    if(!dirtyRegion.update(renderScene))
+    {
+        return;
+    }
+
+    glm::mat4 gridFromWorld = VoxelGrid::gridFromWorld(voxViewProjection, grid.getDimensions());
+    VoxelGrid::Region region = dirtyRegion.getVoxelRegion(gridFromWorld, grid.getDimensions());
+    if(!region.isEmpty())
+    {
+        voxelizer.voxelize(renderScene, grid, region);
+
+        upload(grid, static_cast<Texture3D*>(voxelFBO->getRenderTexture(0)), static_cast<Texture3D*>(voxelFBO->getRenderTexture(1)), region);
+        generateMipMaps(region);
+        ++revision;
+    }
+    dirtyRegion.clear(renderScene);
+}
+
+VoxelGrid::Difference CPUVoxelizeRT::compareAgainst(Texture3D* albedoTexture, Texture3D* normalTexture)
+{
+    VoxelGrid gpuGrid(grid.getDimensions());
+    {
+        Texture3D::Commands commands(albedoTexture);
+        commands.readData(&gpuGrid.albedo[0]);
+    }
+    {
+        Texture3D::Commands commands(normalTexture);
+        commands.readData(&gpuGrid.normal[0]);
+    }
+    VoxelizationMaterial::VOXEL_FORMAT.decodeNormals(gpuGrid);
+
+    VoxelGrid::Difference difference = grid.compare(gpuGrid);
+    std::cout << "cpu vs gpu voxelization: " << difference.occupiedInThis << " cpu voxels, " << difference.occupiedInOther
+              << " gpu voxels, " << difference.occupancyMismatches << " occupancy mismatches, albedo error max "
+              << difference.maxAlbedoError << " mean " << difference.meanAlbedoError << std::endl;
+    return difference;
+}
+
+CPUVoxelizeRT::~CPUVoxelizeRT()
+{
+}
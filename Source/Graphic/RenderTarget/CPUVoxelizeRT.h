@@ -0,0 +1,71 @@
+//
+//  CPUVoxelizeRT.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include "RenderTarget.h"
+#include "Graphic/Voxelization/CPUVoxelizer.h"
+#include "Graphic/Voxelization/VoxelGrid.h"
+#include "Graphic/Voxelization/DirtyRegionTracker.h"
+#include "Graphic/Voxelization/OccupancyGrid.h"
+#include "Graphic/Material/Texture/Texture.h"
+#include <vector>
+#include <memory>
+
+class FBO_3D;
+class Texture3D;
+
+/// <summary> Drop in replacement for VoxelizeRT that voxelizes on the CPU and uploads the result into the same kind of
+/// textures and mip maps the cone tracer samples from.  Also used to diff the GPU voxelization against ground truth. </summary>
+class CPUVoxelizeRT : public RenderTarget
+{
+public:
+    CPUVoxelizeRT();
+
+    virtual void Render( Scene& scene ) override;
+    virtual ~CPUVoxelizeRT();
+
+    inline std::shared_ptr<FBO_3D> getFBO(){ return voxelFBO;};
+    inline glm::mat4 getVoxViewProjection(){ return voxViewProjection; }
+
+    std::vector<std::shared_ptr<Texture3D>>& getNormalMipMaps(){ return normalMipMaps; }
+    std::vector<std::shared_ptr<Texture3D>>& getAlbedoMipMaps(){ return albedoMipMaps; }
+
+    inline const VoxelGrid& getGrid() const { return grid; }
+    inline const std::vector<VoxelGrid>& getMipGrids() const { return mipGrids; }
+    
+    ///<summary> Builds an occupancy pyramid (see OccupancyGrid.h) alongside the mips from now on, nullptr when off. </summary>
+    void setOccupancy(bool value);
+    inline Texture3D* getOccupancyTexture() const { return occupancyTexture.get(); }
+
+    ///<summary> Goes up every time the voxels or their mip maps change. </summary>
+    inline unsigned int getRevision() const { return revision; }
+
+    ///<summary> Revoxelizes the whole volume next frame, regardless of what changed. </summary>
+    inline void queueVoxelization(){ dirtyRegion.invalidateAll(); }
+
+    ///<summary> Reads back GPU voxel textures (VoxelizeRT's level 0 targets) and compares them against the last CPU voxelization. </summary>
+    VoxelGrid::Difference compareAgainst(Texture3D* albedoTexture, Texture3D* normalTexture);
+
+private:
+    void initMipMaps(Texture::Properties& albedoProperties, Texture::Properties& normalProperties);
+    void generateMipMaps(VoxelGrid::Region region);
+    void upload(const VoxelGrid& source, Texture3D* albedoTexture, Texture3D* normalTexture, const VoxelGrid::Region& region);
+
+private:
+    glm::mat4 voxViewProjection;
+    CPUVoxelizer voxelizer;
+    VoxelGrid grid;
+    std::vector<VoxelGrid> mipGrids;
+    OccupancyGrid occupancy;
+    DirtyRegionTracker dirtyRegion;
+    unsigned int revision = 0;
+    std::vector<glm::vec4> encodedNormals;
+
+    std::shared_ptr<FBO_3D> voxelFBO;
+    std::vector< std::shared_ptr<Texture3D> > albedoMipMaps;
+    std::vector< std::shared_ptr<Texture3D> > normalMipMaps;
+    std::shared_ptr<Texture3D> occupancyTexture;
+};
@@ -0,0 +1,118 @@
+//
+//  ClipmapVoxelizeRT.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "ClipmapVoxelizeRT.h"
+#include "VoxelizeRT.h"
+#include "Scene/Scene.h"
+#include "Graphic/Camera/Camera.h"
+#include "Graphic/Material/Texture/Texture3D.h"
+#include "Graphic/Material/Voxelization/VoxelizationMaterial.h"
+
+const unsigned int ClipmapVoxelizeRT::CASCADES;
+
+ClipmapVoxelizeRT::ClipmapVoxelizeRT():
+clipmap(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS, CASCADES, VoxelizeRT::VOXELS_WORLD_SCALE)
+{
+    unsigned int dimensions = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
+
+    Texture::Properties properties;
+    properties.wrap = GL_REPEAT;
+    properties.minFilter = GL_LINEAR;
+    properties.magFilter = GL_LINEAR;
+
+    Texture::Properties albedoProperties = properties;
+    Texture::Properties normalProperties = properties;
+    VoxelizationMaterial::VOXEL_FORMAT.setAlbedoProperties(albedoProperties);
+    VoxelizationMaterial::VOXEL_FORMAT.setNormalProperties(normalProperties);
+
+    for(unsigned int cascade = 0; cascade < CASCADES; ++cascade)
+    {
+        voxelizers.push_back(std::unique_ptr<CPUVoxelizer>(new CPUVoxelizer(dimensions, clipmap.getVoxViewProjection(cascade))));
+        grids.push_back(VoxelGrid(dimensions));
+
+        std::shared_ptr<Texture3D> textures[2] = { std::make_shared<Texture3D>(), std::make_shared<Texture3D>() };
+        for(int i = 0; i < 2; ++i)
+        {
+            std::shared_ptr<Texture3D>& texture = textures[i];
+            Texture::Properties& properties = i == 0 ? albedoProperties : normalProperties;
+            texture->SetWidth(dimensions);
+            texture->SetHeight(dimensions);
+            texture->SetDepth(dimensions);
+            texture->SetWrap(properties.wrap);
+            texture->SetMinFilter(properties.minFilter);
+            texture->SetMagFilter(properties.magFilter);
+            texture->SetPixelFormat(properties.pixelFormat);
+            texture->SetDataType(properties.dataFormat);
+            texture->SetInternalFormat(properties.internalFormat);
+            texture->SaveTextureState();
+        }
+
+        albedoTextures.push_back(textures[0]);
+        normalTextures.push_back(textures[1]);
+    }
+}
+
+void ClipmapVoxelizeRT::upload(unsigned int cascade, const VoxelGrid::Region& region)
+{
+    const VoxelGrid& grid = grids[cascade];
+    clipmap.getStorageRegions(cascade, region, storageRegions);
+    for(const VoxelGrid::Region& storage : storageRegions)
+    {
+        {
+            Texture3D::Commands commands(albedoTextures[cascade].get());
+            commands.uploadRegion(&grid.albedo[0], storage.begin, storage.size());
+        }
+        {
+            Texture3D::Commands commands(normalTextures[cascade].get());
+            commands.uploadRegion(VoxelizationMaterial::VOXEL_FORMAT.encodeNormals(grid, storage, encodedNormals), storage.begin, storage.size());
+        }
+    }
+}
+
+void ClipmapVoxelizeRT::Render(Scene& renderScene)
+{
+    glm::vec3 center = renderScene.renderingCamera != nullptr ? renderScene.renderingCamera->position : glm::vec3(0.0f);
+    clipmap.recenter(center, exposedRegions);
+
+    bool sceneChanged = dirtyRegion.update(renderScene);
+    bool voxelized = false;
+    unsigned int dimensions = clipmap.getDimensions();
+
+    for(unsigned int cascade = 0; cascade < CASCADES; ++cascade)
+    {
+        glm::mat4 voxViewProjection = clipmap.getVoxViewProjection(cascade);
+        std::vector<VoxelGrid::Region>& regions = exposedRegions[cascade];
+
+        //scene changes land wherever they are in each window, on top of whatever scrolled in
+        if(sceneChanged)
+        {
+            VoxelGrid::Region dirty = dirtyRegion.getVoxelRegion(VoxelGrid::gridFromWorld(voxViewProjection, dimensions), dimensions);
+            if(!dirty.isEmpty())
+            {
+                regions.push_back(dirty);
+            }
+        }
+        if(regions.empty()) continue;
+
+        voxelizers[cascade]->setVoxViewProjection(voxViewProjection);
+        voxelizers[cascade]->voxelize(renderScene, grids[cascade], regions, clipmap.getCascade(cascade).getToroidalOffset(dimensions));
+
+        for(const VoxelGrid::Region& region : regions)
+        {
+            upload(cascade, region);
+        }
+        voxelized = true;
+    }
+
+    if(voxelized)
+    {
+        ++revision;
+    }
+    dirtyRegion.clear(renderScene);
+}
+
+ClipmapVoxelizeRT::~ClipmapVoxelizeRT()
+{
+}
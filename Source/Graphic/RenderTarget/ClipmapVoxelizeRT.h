@@ -0,0 +1,61 @@
+//
+//  ClipmapVoxelizeRT.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include "RenderTarget.h"
+#include "Graphic/Voxelization/CPUVoxelizer.h"
+#include "Graphic/Voxelization/VoxelGrid.h"
+#include "Graphic/Voxelization/VoxelClipmap.h"
+#include "Graphic/Voxelization/DirtyRegionTracker.h"
+#include <vector>
+#include <memory>
+
+class Texture3D;
+
+/// <summary> Voxelizes the scene into nested cascades centered on the rendering camera instead of one fixed volume, so
+/// the voxelized area can follow the camera through a scene bigger than VOXELS_WORLD_SCALE.  When the camera moves only
+/// the slabs each cascade scrolled over are voxelized and uploaded; the textures are sampled with GL_REPEAT, which does
+/// the toroidal wrap for free. </summary>
+class ClipmapVoxelizeRT : public RenderTarget
+{
+public:
+    static const unsigned int CASCADES = 4;
+
+    ClipmapVoxelizeRT();
+
+    virtual void Render( Scene& scene ) override;
+    virtual ~ClipmapVoxelizeRT();
+
+    inline const VoxelClipmap& getClipmap() const { return clipmap; }
+    inline Texture3D* getAlbedoTexture(unsigned int cascade) const { return albedoTextures[cascade].get(); }
+    inline Texture3D* getNormalTexture(unsigned int cascade) const { return normalTextures[cascade].get(); }
+
+    ///<summary> Projection of the outermost cascade, everything the cone tracer can see. </summary>
+    inline glm::mat4 getVoxViewProjection() const { return clipmap.getVoxViewProjection(CASCADES - 1); }
+
+    ///<summary> Goes up every time the voxels of any cascade change. </summary>
+    inline unsigned int getRevision() const { return revision; }
+
+    ///<summary> Revoxelizes every cascade next frame, regardless of what changed. </summary>
+    inline void queueVoxelization(){ dirtyRegion.invalidateAll(); }
+
+private:
+    void upload(unsigned int cascade, const VoxelGrid::Region& region);
+
+private:
+    VoxelClipmap clipmap;
+    std::vector<std::unique_ptr<CPUVoxelizer>> voxelizers;
+    std::vector<VoxelGrid> grids;
+    DirtyRegionTracker dirtyRegion;
+    unsigned int revision = 0;
+
+    std::vector<std::vector<VoxelGrid::Region>> exposedRegions;
+    std::vector<VoxelGrid::Region> storageRegions;
+    std::vector<glm::vec4> encodedNormals;
+
+    std::vector< std::shared_ptr<Texture3D> > albedoTextures;
+    std::vector< std::shared_ptr<Texture3D> > normalTextures;
+};
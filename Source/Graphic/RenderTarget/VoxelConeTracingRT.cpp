@@ -13,23 +13,42 @@
 #include "Graphic/Material/MaterialStore.h"
 #include "Shape/Mesh.h"
 #include "Shape/Shape.h"
+#include "Shape/DrawList.h"
 #include "Graphic/FBO/FBO.h"
 #include "Graphic/FBO/FBO_2D.h"
+#include "Graphic/Voxelization/BrickPool.h"
+#include "Graphic/RenderTarget/ClipmapVoxelizeRT.h"
+#include "Time/Profiler.h"
 #include <stdio.h>
+#include <string.h>
 
+const float VoxelConeTracingRT::HISTORY_LENGTH = 4.0f;
 
 VoxelConeTracingRT::VoxelConeTracingRT(Texture3D* _albedoVoxels, Texture3D* _normalVoxels, std::vector<std::shared_ptr<Texture3D>> &_albedoMipMaps,
                                        std::vector<std::shared_ptr<Texture3D>> &_normalMipMaps, glm::mat4& _voxViewProjection):
 albedoMipMaps(_albedoMipMaps),
-normalMipMaps(_normalMipMaps)
+normalMipMaps(_normalMipMaps),
+frameBuffer(sizeof(UniformBlocks::Frame))
 {
-    voxConeTracing = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing");
-    albedoVoxels = _albedoVoxels;
-    normalVoxels = _normalVoxels;
+    selectMaterials();
+    upsampledConeTracing = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-upsampled");
+    deferredUpsampledShading = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-deferred-upsampled");
+    geometryBufferMaterial = MaterialStore::GET_MAT<Material>("geometry-buffer");
     voxViewProjection = _voxViewProjection;
     
     setupSamplingRays();
     
+    UniformBuffer::Commands frameCommands(&frameBuffer);
+    frameCommands.allocate(1);
+    
+    setVoxels(_albedoVoxels, _normalVoxels);
+}
+
+void VoxelConeTracingRT::setVoxels(Texture3D* _albedoVoxels, Texture3D* _normalVoxels)
+{
+    albedoVoxels = _albedoVoxels;
+    normalVoxels = _normalVoxels;
+    
     Texture3D::Commands textureCommands(albedoVoxels);
     
     textureCommands.setMinFiltering(GL_LINEAR);
@@ -44,24 +63,61 @@ normalMipMaps(_normalMipMaps)
     for(std::shared_ptr<Texture3D> vox : albedoMipMaps)
     {
         Texture3D::Commands textureCommans(vox.get());
-        textureCommands.setMinFiltering(GL_LINEAR);
-        textureCommands.setMagFiltering(GL_LINEAR);
-        textureCommands.end();
+        textureCommans.setMinFiltering(GL_LINEAR);
+        textureCommans.setMagFiltering(GL_LINEAR);
+        textureCommans.end();
         
     }
     
     for(std::shared_ptr<Texture3D> vox : normalMipMaps)
     {
         Texture3D::Commands textureCommans(vox.get());
-        textureCommands.setMinFiltering(GL_LINEAR);
-        textureCommands.setMagFiltering(GL_LINEAR);
-        textureCommands.end();
+        textureCommans.setMinFiltering(GL_LINEAR);
+        textureCommans.setMagFiltering(GL_LINEAR);
+        textureCommans.end();
         
     }
 }
 
 
 void VoxelConeTracingRT::Render(Scene& scene)
+{
+    Profiler::Scope profile("cone tracing");
+    
+    setFrameBlock(scene);
+    {
+        UniformBuffer::Commands frameCommands(&frameBuffer);
+        frameCommands.upload(&frameBlock);
+        frameCommands.bindRange(UniformBlocks::FRAME_BINDING);
+    }
+    
+    bool separateIndirect = (divisor > 1 || interleave > 0) && width > 0 && height > 0;
+    bool deferredShading = deferred && width > 0 && height > 0;
+    if(separateIndirect || deferredShading)
+    {
+        if(targetsChanged)
+        {
+            allocateTargets();
+        }
+        renderGeometryBuffer();
+    }
+    if(separateIndirect)
+    {
+        traceIndirect();
+    }
+    
+    Profiler::Scope shadingProfile("shading");
+    if(deferredShading)
+    {
+        shadeDeferred(separateIndirect);
+    }
+    else
+    {
+        shadeForward(separateIndirect);
+    }
+}
+
+void VoxelConeTracingRT::shadeForward(bool upsampled)
 {
     FBO::Commands commands(FBO_2D::getDefault().get());
     
@@ -71,37 +127,238 @@ void VoxelConeTracingRT::Render(Scene& scene)
     commands.backFaceCulling(true);
     commands.blendSrcAlphaOneMinusSrcAlpha();
     
-    static ShaderParameter::ShaderParamsGroup params;
-
-    params["voxViewProjection"] = voxViewProjection;
-    params["voxelDimensionsInWorldSpace"] = float(VoxelizeRT::VOXELS_WORLD_SCALE) / float(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS);
+    //samplers and the per path tables, everything else goes up in the uniform blocks
+    static ShaderParameter::ShaderParamsGroup tracingParams, upsampleParams;
+    ShaderParameter::ShaderParamsGroup& params = upsampled ? upsampleParams : tracingParams;
+    std::shared_ptr<VoxelizationConeTracingMaterial>& material = upsampled ? upsampledConeTracing : voxConeTracing;
+    if(upsampled)
+    {
+        setUpsampleParameters(params);
+    }
+    else
+    {
+        //uploadRenderingSettings(params, voxConeTracing);
+        setVoxelParameters(params);
+    }
     
-    Material::Commands matCommands(voxConeTracing.get());
+    Material::Commands matCommands(material.get());
+    matCommands.uploadParameters(params);
+    renderMeshes();
+    commands.end();
+}
+
+void VoxelConeTracingRT::shadeDeferred(bool upsampled)
+{
+    FBO::Commands commands(FBO_2D::getDefault().get());
     
-    setLightingParameters(params, scene.pointLights);
-    setCameraParameters(params, *scene.renderingCamera);
-    //uploadRenderingSettings(params, voxConeTracing);
-    setMipMapParameters(params);
-    setSamplingRayParameters(params);
+    commands.setClearColor();
+    commands.clearRenderTarget();
+    commands.enableDepthTest(false);
+    commands.enableBlend(false);
     
-    for(Shape* shape: scene.shapes)
+    static ShaderParameter::ShaderParamsGroup tracingParams, upsampleParams;
+    ShaderParameter::ShaderParamsGroup& params = upsampled ? upsampleParams : tracingParams;
+    std::shared_ptr<VoxelizationConeTracingMaterial>& material = upsampled ? deferredUpsampledShading : deferredShading;
+    if(upsampled)
     {
-        size_t numberOfProperties = shape->getMeshProperties().size();
-        glm::mat4 trans = shape->transform.getTransformMatrix();
-        
-        Material::Commands commands(voxConeTracing.get());
-        params[Material::Commands::MODEL_MATRIX_NAME] = trans;
+        setUpsampleParameters(params);
+    }
+    else
+    {
+        setVoxelParameters(params);
+    }
+    setGeometryBufferParameters(params);
+    
+    Material::Commands matCommands(material.get());
+    matCommands.uploadParameters(params);
+    
+    //one fragment per pixel, however many meshes were drawn over it
+    ScreenQuand::Commands quadCommands(&screenQuad);
+    quadCommands.render();
+    commands.end();
+}
 
-        int i = 0;
-        for(Mesh* mesh : shape->meshes)
+void VoxelConeTracingRT::renderMeshes()
+{
+    assert(drawList != nullptr);
+    DrawList::Commands drawCommands(drawList);
+    drawCommands.render();
+}
+
+void VoxelConeTracingRT::renderGeometryBuffer()
+{
+    Profiler::Scope profile("geometry buffer");
+    FBO::Commands commands(geometryBuffer.get());
+    
+    commands.setClearColor();
+    commands.clearRenderTarget();
+    commands.enableDepthTest(true);
+    commands.backFaceCulling(true);
+    commands.enableBlend(false);
+    
+    Material::Commands matCommands(geometryBufferMaterial.get());
+    renderMeshes();
+    commands.end();
+}
+
+void VoxelConeTracingRT::traceIndirect()
+{
+    Profiler::Scope profile("indirect tracing");
+    
+    //the buffer written last frame becomes the history
+    currentIndirect ^= 1u;
+    FBO_2D* history = indirectBuffers[currentIndirect ^ 1u].get();
+    FBO::Commands commands(indirectBuffers[currentIndirect].get());
+    
+    commands.enableDepthTest(false);
+    commands.enableBlend(false);
+    
+    static ShaderParameter::ShaderParamsGroup params;
+    setVoxelParameters(params);
+    setGeometryBufferParameters(params);
+    params["historyTexture"] = static_cast<Texture2D*>(history->getRenderTexture(0));
+    params["previousV"] = previousV;
+    params["previousP"] = previousP;
+    params["historyValid"] = historyValid;
+    params["interleave"] = std::max(interleave, 1u);
+    params["frameIndex"] = frameIndex;
+    params["historyLength"] = interleave > 0 ? HISTORY_LENGTH : 1.0f;
+    
+    Material::Commands matCommands(indirectTracing.get());
+    matCommands.uploadParameters(params);
+    
+    //every texel is written, texels without geometry behind them get zeroes
+    ScreenQuand::Commands quadCommands(&screenQuad);
+    quadCommands.render();
+    commands.end();
+    
+    previousV = frameBlock.V;
+    previousP = frameBlock.P;
+    historyValid = interleave > 0;
+    ++frameIndex;
+}
+
+void VoxelConeTracingRT::setGeometryBufferParameters(ShaderParameter::ShaderParamsGroup& settings)
+{
+    settings["normalDepthTexture"] = static_cast<Texture2D*>(geometryBuffer->getRenderTexture(0));
+    settings["albedoTexture"] = static_cast<Texture2D*>(geometryBuffer->getRenderTexture(1));
+}
+
+void VoxelConeTracingRT::setUpsampleParameters(ShaderParameter::ShaderParamsGroup& settings)
+{
+    FBO_2D* indirectBuffer = indirectBuffers[currentIndirect].get();
+    const Texture::Dimensions& dimensions = indirectBuffer->getDimensions();
+    settings["indirectTexture"] = static_cast<Texture2D*>(indirectBuffer->getRenderTexture(0));
+    settings["indirectSize"] = glm::vec2(float(dimensions.width), float(dimensions.height));
+}
+
+void VoxelConeTracingRT::allocateTargets()
+{
+    //nearest filtering throughout, the geometry buffer is read at pixel and indirect texel centers and the
+    //upsampling fetches texels itself
+    Texture::Properties properties;
+    properties.minFilter = GL_NEAREST;
+    properties.magFilter = GL_NEAREST;
+    properties.dataFormat = GL_FLOAT;
+    
+    //depth needs full floats, albedo and draw ids don't, halfs hold ids up to 2048 exactly
+    Texture::Dimensions dimensions;
+    dimensions.width = width;
+    dimensions.height = height;
+    properties.pixelFormat = GL_RGBA32F;
+    geometryBuffer = std::make_shared<FBO_2D>(dimensions, properties);
+    properties.pixelFormat = GL_RGBA16F;
+    geometryBuffer->addRenderTarget(properties);
+    {
+        FBO_2D::Commands commands(geometryBuffer.get());
+        commands.allocateOnGPU(dimensions);
+    }
+    
+    //one texel packs the light with the normal and depth it was traced at as halfs, see packIndirect() in
+    //voxelConeTracing.frag, which leaves the reprojection a single sampler for its history
+    indirectBuffers[0] = indirectBuffers[1] = nullptr;
+    if(divisor > 1 || interleave > 0)
+    {
+        dimensions.width = std::max(width / divisor, 1u);
+        dimensions.height = std::max(height / divisor, 1u);
+        properties.pixelFormat = GL_RGBA32UI;
+        properties.dataFormat = GL_UNSIGNED_INT;
+        for(std::shared_ptr<FBO_2D>& buffer : indirectBuffers)
         {
-            VoxProperties prop = i < shape->meshProperties.size()  ? shape->meshProperties[i] : shape->defaultVoxProperties;
-            getVoxParameters(params, prop);
-            mesh->render(params, matCommands);
-            ++i;
+            buffer = std::make_shared<FBO_2D>(dimensions, properties);
         }
     }
-    commands.end();
+    
+    historyValid = false;
+    targetsChanged = false;
+}
+
+void VoxelConeTracingRT::setResolution(unsigned int _width, unsigned int _height, unsigned int _divisor)
+{
+    _divisor = std::max(_divisor, 1u);
+    if(_width == width && _height == height && _divisor == divisor) return;
+    
+    width = _width;
+    height = _height;
+    divisor = _divisor;
+    targetsChanged = true;
+}
+
+void VoxelConeTracingRT::setDeferred(bool value)
+{
+    deferred = value;
+}
+
+void VoxelConeTracingRT::setTemporal(unsigned int value)
+{
+    assert(value <= 4 && value != 3 && "tiles take turns in groups of 1, 2 or 4");
+    if((value > 0) != (interleave > 0))
+    {
+        targetsChanged = true;
+    }
+    interleave = value;
+    resetHistory();
+}
+
+void VoxelConeTracingRT::resetHistory()
+{
+    historyValid = false;
+}
+
+void VoxelConeTracingRT::setBrickPool(BrickPool* pool)
+{
+    brickPool = pool;
+    selectMaterials();
+    resetHistory();
+}
+
+void VoxelConeTracingRT::setClipmap(ClipmapVoxelizeRT* _clipmap)
+{
+    clipmap = _clipmap;
+    selectMaterials();
+    resetHistory();
+}
+
+void VoxelConeTracingRT::selectMaterials()
+{
+    if(clipmap != nullptr)
+    {
+        voxConeTracing = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-clipmap");
+        deferredShading = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-deferred-clipmap");
+        indirectTracing = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-indirect-clipmap");
+    }
+    else if(brickPool != nullptr)
+    {
+        voxConeTracing = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-sparse");
+        deferredShading = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-deferred-sparse");
+        indirectTracing = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-indirect-sparse");
+    }
+    else
+    {
+        voxConeTracing = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing");
+        deferredShading = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-deferred");
+        indirectTracing = MaterialStore::GET_MAT<VoxelizationConeTracingMaterial>("voxelization-cone-tracing-indirect");
+    }
 }
 
 void VoxelConeTracingRT::setupSamplingRays()
@@ -122,26 +379,56 @@ void VoxelConeTracingRT::setupSamplingRays()
     
 }
 
-void VoxelConeTracingRT::setSamplingRayParameters(ShaderParameter::ShaderParamsGroup &params)
+void VoxelConeTracingRT::setFrameBlock(Scene& scene)
 {
+    Camera& camera = *scene.renderingCamera;
+    frameBlock.V = camera.viewMatrix;
+    frameBlock.P = camera.getProjectionMatrix();
+    frameBlock.cameraPosition = camera.position;
+    
+    frameBlock.voxelDimensionsInWorldSpace = float(VoxelizeRT::VOXELS_WORLD_SCALE) / float(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS);
+    frameBlock.octahedralNormals = VoxelizationMaterial::VOXEL_FORMAT.hasOctahedralNormals() ? 1u : 0u;
+    if(clipmap != nullptr)
+    {
+        //the windows move with the camera, so the bounds test uses the outermost one every frame
+        frameBlock.voxViewProjection = clipmap->getVoxViewProjection();
+        frameBlock.numberOfLods = ClipmapVoxelizeRT::CASCADES;
+    }
+    else
+    {
+        frameBlock.voxViewProjection = voxViewProjection;
+        frameBlock.numberOfLods = brickPool != nullptr ? brickPool->getLevelCount() : (unsigned int)(albedoMipMaps.size() + 1);
+    }
+    
+    unsigned int lights = (unsigned int)std::min(scene.pointLights.size(), size_t(UniformBlocks::MAX_LIGHTS));
+    for(unsigned int i = 0; i < lights; ++i)
+    {
+        frameBlock.pointLights[i].position = scene.pointLights[i].position;
+        frameBlock.pointLights[i].color = scene.pointLights[i].color;
+    }
+    frameBlock.numberOfLights = int(lights);
+    
     for(int i = 0; i < SAMPLING_RAYS; ++i)
     {
-        sprintf(samplingRayArgs[i], "samplingRays[%d]", i);
-        params[samplingRayArgs[i]] = samplingRays[i];
+        frameBlock.samplingRays[i] = glm::vec4(samplingRays[i], 0.0f);
     }
+    setConeApertureAndVariances(frameBlock);
 }
 
-void VoxelConeTracingRT::getVoxParameters(ShaderParameter::ShaderParamsGroup &settings, VoxProperties &voxProperties)
+void VoxelConeTracingRT::setVoxelParameters(ShaderParameter::ShaderParamsGroup& settings)
 {
-    settings["material.diffuseColor"] = voxProperties.diffuseColor;
-    settings["material.specularColor"] = voxProperties.specularColor;
-    settings["material.emissivity"] = voxProperties.emissivity;
-    settings["material.specularReflectivity"] = voxProperties.specularReflectivity;
-    settings["material.specularDiffusion"] = voxProperties.specularDiffusion;
-    settings["material.transparency"] = voxProperties.transparency;
-    settings["material.refractiveIndex"] = voxProperties.refractiveIndex;
-    settings["material.diffuseReflectivity"] = voxProperties.diffuseReflectivity;
-    
+    if(clipmap != nullptr)
+    {
+        setClipmapParameters(settings);
+    }
+    else if(brickPool != nullptr)
+    {
+        setBrickPoolParameters(settings);
+    }
+    else
+    {
+        setMipMapParameters(settings);
+    }
 }
 
 void VoxelConeTracingRT::setMipMapParameters(ShaderParameter::ShaderParamsGroup& settings)
@@ -153,7 +440,7 @@ void VoxelConeTracingRT::setMipMapParameters(ShaderParameter::ShaderParamsGroup&
     
     settings[albedoArgs[index]] = albedoVoxels;
     settings[normalArgs[index]] = normalVoxels;
-    settings["numberOfLods"] = (unsigned int)(albedoMipMaps.size() + 1);
+    settings["anisotropicMipMaps"] = anisotropic;
     ++index;
     
     assert(albedoMipMaps.size() == normalMipMaps.size());
@@ -173,28 +460,49 @@ void VoxelConeTracingRT::setMipMapParameters(ShaderParameter::ShaderParamsGroup&
     }
 }
 
+void VoxelConeTracingRT::setBrickPoolParameters(ShaderParameter::ShaderParamsGroup& settings)
+{
+    settings["pageTable"] = brickPool->getPageTableTexture();
+    settings["albedoAtlas"] = brickPool->getAlbedoAtlasTexture();
+    settings["normalAtlas"] = brickPool->getNormalAtlasTexture();
+    settings["atlasSize"] = brickPool->getAtlasSize();
+    
+    for(unsigned int level = 0; level < brickPool->getLevelCount(); ++level)
+    {
+        assert(level < MAX_ARGUMENTS);
+        sprintf(brickLevelArgs[level], "brickLevels[%d]", level);
+        settings[brickLevelArgs[level]] = glm::vec2(float(brickPool->getPageTableOffset(level)), float(brickPool->getLevelDimensions(level)));
+    }
+}
 
-void VoxelConeTracingRT::setCameraParameters(ShaderParameter::ShaderParamsGroup& params, Camera &camera)
+void VoxelConeTracingRT::setClipmapParameters(ShaderParameter::ShaderParamsGroup& settings)
 {
-    params[Material::Commands::VIEW_MATRIX_NAME] = camera.viewMatrix;
-    params[Material::Commands::PROJECTION_MATRIX_NAME] = camera.getProjectionMatrix();
-    params[Material::Commands::CAMERA_POSITION_NAME] = camera.position;
+    const VoxelClipmap& cascades = clipmap->getClipmap();
+    for(unsigned int cascade = 0; cascade < ClipmapVoxelizeRT::CASCADES; ++cascade)
+    {
+        assert(cascade < MAX_ARGUMENTS);
+        sprintf(albedoArgs[cascade], "albedoCascades[%d]", cascade);
+        sprintf(normalArgs[cascade], "normalCascades[%d]", cascade);
+        sprintf(cascadeWindowArgs[cascade], "cascadeWindows[%d]", cascade);
+        
+        settings[albedoArgs[cascade]] = clipmap->getAlbedoTexture(cascade);
+        settings[normalArgs[cascade]] = clipmap->getNormalTexture(cascade);
+        settings[cascadeWindowArgs[cascade]] = glm::vec4(cascades.getCascade(cascade).getWorldMin(), cascades.getWorldSize(cascade));
+    }
 }
 
 
-void VoxelConeTracingRT::setConeApertureAndVariances(ShaderParameter::ShaderParamsGroup& params)
+void VoxelConeTracingRT::setConeApertureAndVariances(UniformBlocks::Frame& frame)
 {
     static const float PI = 3.14159265359f;
     static float apertureInDegrees = .50f;
     
     float radians = apertureInDegrees * (PI/180.0f);
     float initialApertureInRadians = radians;
-    for(int i = 0; i < albedoMipMaps.size(); ++i)
+    for(unsigned int i = 0; i < UniformBlocks::MIP_MAPS; ++i)
     {
-        
-        sprintf(coneVariances[i], "coneVariances[%d]", i);
         float value = cos(initialApertureInRadians);
-        params[coneVariances[i]] = value;
+        frame.coneVariances[i] = glm::vec4(value, 0.0f, 0.0f, 0.0f);
         
         initialApertureInRadians += radians;
         
@@ -10,11 +10,31 @@
 
 #include "RenderTarget.h"
 #include "Graphic/Camera/Camera.h"
+#include "Graphic/Material/UniformBlocks.h"
+#include "Graphic/Material/UniformBuffer.h"
+#include "Shape/ScreenQuad.h"
+#include <memory>
 
 class VoxelizationConeTracingMaterial;
 class Texture3D;
+class BrickPool;
+class ClipmapVoxelizeRT;
+class FBO_2D;
+class Material;
+class DrawList;
 
 
+/// <summary> Shades the scene with voxel cone tracing.  Deferred, the meshes go into a geometry buffer (normal and view
+/// depth, albedo and draw id per pixel) and one full screen pass shades every pixel once from it, so
+/// cone tracing costs the same however much the meshes overdraw.  Forward, every mesh is shaded as it's drawn, tracing
+/// cones for every fragment that passes the depth test.
+/// With a resolution divisor above 1, indirect light and ambient occlusion are traced from the geometry buffer into a
+/// target divisor times smaller on each side, and shading adds direct light to the indirect light upsampled by a joint
+/// bilateral filter, which weighs the nearest traced texels by how close their depth and normal are to the pixel's.
+/// Temporal, indirect light is traced into its own target at any divisor and kept from frame to frame: every texel
+/// looks up last frame's target where its surface was, keeps that light if the depth and normal there match, and
+/// only one in interleave screen tiles traces cones each frame, averaged into what was kept.  Texels that just came
+/// into view trace every frame until they have history. </summary>
 class VoxelConeTracingRT : public RenderTarget
 {
 public:
@@ -23,16 +43,57 @@ public:
                        std::vector<std::shared_ptr<Texture3D>> &_normalMipMaps, glm::mat4& voxViewProjection);
     
     void Render( Scene& scene) override;
+    
+    ///<summary> Cone traces these voxels from now on, for when the voxelization swaps its volumes.  The mip map
+    /// vectors given to the constructor are expected to hold the matching levels by then. </summary>
+    void setVoxels(Texture3D* albedoVoxels, Texture3D* normalVoxels);
+    
+    ///<summary> Samples the voxels through the pool's page table and atlas instead of the dense mip maps, nullptr goes back to the mip maps. </summary>
+    void setBrickPool(BrickPool* pool);
+    
+    ///<summary> Samples the camera centered cascades of a clipmap instead, nullptr goes back to the mip maps. </summary>
+    void setClipmap(ClipmapVoxelizeRT* clipmap);
+    
+    ///<summary> What the meshes are drawn with, one draw per pass.  Expected to be updated for the scene before every
+    /// Render(). </summary>
+    inline void setDrawList(DrawList* list){ drawList = list; }
+    
+    ///<summary> Size of the screen and how many times smaller on each side indirect light is traced, 1 traces every
+    /// fragment.  The targets are reallocated on the next Render() when either changes. </summary>
+    void setResolution(unsigned int width, unsigned int height, unsigned int divisor);
+    
+    ///<summary> Shades once per pixel from the geometry buffer instead of once per fragment, see the class summary. </summary>
+    void setDeferred(bool value);
+    
+    ///<summary> Keeps indirect light across frames and traces one in interleave (1, 2 or 4) tiles a frame, see the
+    /// class summary.  0 traces everything every frame. </summary>
+    void setTemporal(unsigned int interleave);
+    
+    ///<summary> Whether the albedo mip maps keep one texel per axis direction, see AnisotropicMips.h. </summary>
+    inline void setAnisotropic(bool value){ anisotropic = value; }
+    
+    ///<summary> Forgets the indirect light of earlier frames, for when the scene or the voxels change wholesale. </summary>
+    void resetHistory();
     ~VoxelConeTracingRT() override;
     
 private:
-    void getVoxParameters(ShaderParameter::ShaderParamsGroup &settings, VoxProperties &voxProperties);
+    void selectMaterials();
+    void allocateTargets();
+    void renderMeshes();
+    void renderGeometryBuffer();
+    void traceIndirect();
+    void shadeForward(bool upsampled);
+    void shadeDeferred(bool upsampled);
+    void setGeometryBufferParameters(ShaderParameter::ShaderParamsGroup& settings);
+    void setUpsampleParameters(ShaderParameter::ShaderParamsGroup& settings);
+    void setFrameBlock(Scene& scene);
+    void setVoxelParameters(ShaderParameter::ShaderParamsGroup& settings);
     void setMipMapParameters(ShaderParameter::ShaderParamsGroup& settings);
-    void setCameraParameters(ShaderParameter::ShaderParamsGroup& params, Camera &camera);
+    void setBrickPoolParameters(ShaderParameter::ShaderParamsGroup& settings);
+    void setClipmapParameters(ShaderParameter::ShaderParamsGroup& settings);
     void uploadRenderingSettings(ShaderParameter::ShaderParamsGroup& params, std::shared_ptr<VoxelizationConeTracingMaterial> &material );
     void setupSamplingRays();
-    void setSamplingRayParameters(ShaderParameter::ShaderParamsGroup& params);
-    void setConeApertureAndVariances(ShaderParameter::ShaderParamsGroup& params);
+    void setConeApertureAndVariances(UniformBlocks::Frame& frame);
     void setSamplingWeights(ShaderParameter::ShaderParamsGroup& params);
 
 private:
@@ -52,8 +113,44 @@ private:
     char samplingWeightsArgs[MAX_ARGUMENTS][MAX_ARGUMENTS];
     char normalArgs[MAX_ARGUMENTS][MAX_ARGUMENTS ];
     char albedoArgs[MAX_ARGUMENTS][MAX_ARGUMENTS];
-    char samplingRayArgs[MAX_ARGUMENTS][MAX_ARGUMENTS];
-    char coneVariances[MAX_ARGUMENTS][MAX_ARGUMENTS];
+    char brickLevelArgs[MAX_ARGUMENTS][MAX_ARGUMENTS];
+    char cascadeWindowArgs[MAX_ARGUMENTS][MAX_ARGUMENTS];
     
     std::shared_ptr<VoxelizationConeTracingMaterial> voxConeTracing = nullptr;
+    std::shared_ptr<VoxelizationConeTracingMaterial> indirectTracing = nullptr;
+    std::shared_ptr<VoxelizationConeTracingMaterial> upsampledConeTracing = nullptr;
+    std::shared_ptr<VoxelizationConeTracingMaterial> deferredShading = nullptr;
+    std::shared_ptr<VoxelizationConeTracingMaterial> deferredUpsampledShading = nullptr;
+    std::shared_ptr<Material> geometryBufferMaterial = nullptr;
+    BrickPool* brickPool = nullptr;
+    ClipmapVoxelizeRT* clipmap = nullptr;
+    DrawList* drawList = nullptr;
+    
+    ///<summary> One FrameBlock per frame, see UniformBlocks.h, the meshes' model matrices and properties are in the
+    /// draw list's table. </summary>
+    UniformBlocks::Frame frameBlock;
+    UniformBuffer frameBuffer;
+    
+    ///<summary> Deferred shading, reduced resolution and temporal tracing, see the class summary.  The indirect buffers
+    /// hold the traced light and, for the upsampling and the reprojection, the normal and depth each texel was traced
+    /// at.  They take turns, the one written last frame is the history of this one. </summary>
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned int divisor = 1;
+    unsigned int interleave = 0;
+    bool deferred = false;
+    bool anisotropic = false;
+    bool targetsChanged = true;
+    std::shared_ptr<FBO_2D> geometryBuffer;
+    std::shared_ptr<FBO_2D> indirectBuffers[2];
+    unsigned int currentIndirect = 0;
+    ScreenQuand screenQuad;
+    
+    ///<summary> Last frame's camera, where the history is looked up.  At most HISTORY_LENGTH traces are averaged, so
+    /// a moving light is caught up with after HISTORY_LENGTH * interleave frames. </summary>
+    static const float HISTORY_LENGTH;
+    bool historyValid = false;
+    unsigned int frameIndex = 0;
+    glm::mat4 previousV;
+    glm::mat4 previousP;
 };
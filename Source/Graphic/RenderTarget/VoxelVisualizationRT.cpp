@@ -15,6 +15,7 @@
 #include "Utility/ObjLoader.h"
 #include "Utility/Logger.h"
 #include "Graphic/FBO/FBO_2D.h"
+#include "Graphic/Voxelization/BrickPool.h"
 
 
 VoxelVisualizationRT::VoxelVisualizationRT(Texture3D* _voxelTexture)
@@ -28,11 +29,31 @@ VoxelVisualizationRT::VoxelVisualizationRT(Texture3D* _voxelTexture)
 
 }
 
+void VoxelVisualizationRT::SetVoxelTexture(Texture3D* _voxelTexture)
+{
+    voxelTexture = _voxelTexture;
+}
+
 void VoxelVisualizationRT::Render( Scene& scene )
 {
 
     static ShaderParameter::ShaderParamsGroup group;
-    group["texture3D"] = voxelTexture;
+    if(brickPool != nullptr)
+    {
+        group["pageTable"] = brickPool->getPageTableTexture();
+        group["albedoAtlas"] = brickPool->getAlbedoAtlasTexture();
+        group["atlasSize"] = brickPool->getAtlasSize();
+        group["voxelDimensions"] = float(brickPool->getLevelDimensions(0));
+    }
+    else
+    {
+        group["texture3D"] = voxelTexture;
+        if(occupancy != nullptr)
+        {
+            group["occupancy"] = occupancy;
+            group["voxelDimensions"] = float(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS);
+        }
+    }
     group["camPosition"] = scene.renderingCamera->position;
     
     glm::mat4 modelView = scene.renderingCamera->viewMatrix * cubeShape->transform.getTransformMatrix();
@@ -57,6 +78,24 @@ void VoxelVisualizationRT::Render( Scene& scene )
     commands.end();
 }
 
+void VoxelVisualizationRT::setBrickPool(BrickPool* pool)
+{
+    brickPool = pool;
+    selectMaterial();
+}
+
+void VoxelVisualizationRT::setOccupancy(Texture3D* occupancyTexture)
+{
+    occupancy = occupancyTexture;
+    selectMaterial();
+}
+
+void VoxelVisualizationRT::selectMaterial()
+{
+    const char* name = brickPool != nullptr ? "voxel-visualization-sparse" : occupancy != nullptr ? "voxel-visualization-skipping" : "voxel-visualization";
+    voxelVisualizationMaterial = MaterialStore::GET_MAT<VoxelVisualizationMaterial>(name);
+}
+
 VoxelVisualizationRT::~VoxelVisualizationRT()
 {
     delete cubeShape;
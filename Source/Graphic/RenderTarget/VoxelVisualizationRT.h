@@ -9,6 +9,7 @@
 #pragma once
 
 #include "RenderTarget.h"
+#include <memory>
 
 class Material;
 class VoxelVisualizationMaterial;
@@ -18,6 +19,7 @@ class Texture3D;
 class FBO_2D;
 class MeshRenderer;
 class PointRenderer;
+class BrickPool;
 
 class VoxelVisualizationRT : public RenderTarget
 {
@@ -29,9 +31,18 @@ public:
     
     void SetVoxelTexture(Texture3D* voxelTexture);
     
+    ///<summary> Ray marches the base level of the pool instead of the voxel texture, nullptr goes back to the texture. </summary>
+    void setBrickPool(BrickPool* pool);
+    
+    ///<summary> Jumps over the empty cells of an occupancy pyramid (see OccupancyGrid.h) built from the voxel texture
+    /// instead of sampling them, the image comes out the same.  nullptr samples every step.  The brick pool, when set,
+    /// is marched without it. </summary>
+    void setOccupancy(Texture3D* occupancyTexture);
+    
     ~VoxelVisualizationRT();
     
 private:
+    void selectMaterial();
     
     std::shared_ptr<VoxelVisualizationMaterial>  voxelVisualizationMaterial = nullptr;
     std::shared_ptr<Mesh> cubeMeshRenderer;
@@ -39,4 +50,6 @@ private:
     //TODO: make these pointers shared pointers
     Shape *cubeShape = nullptr;
     Texture3D* voxelTexture = nullptr;
+    BrickPool* brickPool = nullptr;
+    Texture3D* occupancy = nullptr;
 };
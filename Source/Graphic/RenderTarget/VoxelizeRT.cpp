@@ -17,14 +17,34 @@
 #include "Utility/Logger.h"
 #include "Shape/Mesh.h"
 #include "Shape.h"
+#include "Shape/DrawList.h"
+#include "Graphic/Voxelization/MipChainBuilder.h"
+#include "Graphic/Voxelization/CPUVoxelizer.h"
+#include "Time/Profiler.h"
 #include <stdio.h>
+#include <iostream>
+#include <limits>
+#include <cmath>
+
+//build mip maps with MipChainBuilder instead of one OpenCL dispatch per level.  Costs a read back of the voxel textures
+//but skips the per level acquire/release of GL objects and the blocking wait in ComputeShader::run
+#define __CPU_MIP_CHAIN 0
+
+//ComputeShader is macOS only, other platforms always build the mips on the CPU
+#ifndef __APPLE__
+#undef __CPU_MIP_CHAIN
+#define __CPU_MIP_CHAIN 1
+#endif
 
 
 const float VoxelizeRT::VOXELS_WORLD_SCALE = 3.5f;
 
 VoxelizeRT::VoxelizeRT( float worldSpaceWidth, float worldSpaceHeight, float worldSpaceDepth ):
-downSample("downsize.cl", "downsample",
+scheduler(2 + (unsigned int)std::log2(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS)) //peeled layers, one kind per mip level, then the geometry shader pass
+#ifdef __APPLE__
+,downSample("downsize.cl", VoxelizationMaterial::VOXEL_FORMAT.hasOctahedralNormals() ? "downsampleOctahedral" : "downsample",
            glm::vec3(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS, VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS, VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS), 3)
+#endif
 {
     Texture::Dimensions dimensions;
     dimensions.width = dimensions.height = dimensions.depth = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
@@ -34,31 +54,51 @@ downSample("downsize.cl", "downsample",
     
     properties.minFilter = GL_NEAREST;
     properties.magFilter = GL_NEAREST;
-    voxelFBO = std::make_shared<FBO_3D>(dimensions, properties);
+    
+    albedoProperties = properties;
+    normalProperties = properties;
+    VoxelizationMaterial::VOXEL_FORMAT.setAlbedoProperties(albedoProperties);
+    VoxelizationMaterial::VOXEL_FORMAT.setNormalProperties(normalProperties);
+    voxelFBO = std::make_shared<FBO_3D>(dimensions, albedoProperties);
+    backFBO = std::make_shared<FBO_3D>(dimensions, albedoProperties);
     
     //normal render target
-    voxelFBO->addRenderTarget();
+    voxelFBO->addRenderTarget(normalProperties);
+    backFBO->addRenderTarget(normalProperties);
 
     orthoCamera = OrthographicCamera(VOXELS_WORLD_SCALE, VOXELS_WORLD_SCALE, VOXELS_WORLD_SCALE);
     
-    orthoCamera.position = glm::vec3(0.0f, .0f, 1.5f);
-    orthoCamera.forward =  glm::vec3(0.0f, 0.0f, -1.0f);
-    orthoCamera.up = glm::vec3(0.0f, 1.0f, 0.0f);
-    orthoCamera.updateViewMatrix();
-    
-    voxViewProjection = orthoCamera.getProjectionMatrix() * orthoCamera.viewMatrix;
+    voxViewProjection = makeVoxViewProjection();
+    gridFromWorld = VoxelGrid::gridFromWorld(voxViewProjection, VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS);
+    mipRegion = VoxelGrid::Region::whole(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS);
     
     positionsMaterial = MaterialStore::GET_MAT<Material>("world-position");
     points = std::make_shared<Points>(dimensions.width * dimensions.height );
     voxMaterial = MaterialStore::GET_MAT<VoxelizationMaterial> ("voxelization");
     textureDisplayMat = MaterialStore::GET_MAT<Material>("texture-display");
     depthPeelingMat = MaterialStore::GET_MAT<Material>("depth-peeling");
+    slabsMat = MaterialStore::GET_MAT<Material>("geometry-voxelization");
+    resolveMat = MaterialStore::GET_MAT<VoxelizationMaterial>("voxel-resolve");
     
     initDepthPeelingBuffers(dimensions, properties);
-    initMipMaps(properties);
+    initMipMaps(albedoProperties, normalProperties, albedoMipMaps, normalMipMaps);
+    initMipMaps(albedoProperties, normalProperties, backAlbedoMipMaps, backNormalMipMaps);
 }
 
-void VoxelizeRT::initMipMaps(Texture::Properties &properties)
+glm::mat4 VoxelizeRT::makeVoxViewProjection()
+{
+    OrthographicCamera camera(VOXELS_WORLD_SCALE, VOXELS_WORLD_SCALE, VOXELS_WORLD_SCALE);
+    
+    camera.position = glm::vec3(0.0f, .0f, 1.5f);
+    camera.forward =  glm::vec3(0.0f, 0.0f, -1.0f);
+    camera.up = glm::vec3(0.0f, 1.0f, 0.0f);
+    camera.updateViewMatrix();
+    
+    return camera.getProjectionMatrix() * camera.viewMatrix;
+}
+
+void VoxelizeRT::initMipMaps(Texture::Properties &albedoProperties, Texture::Properties &normalProperties,
+                             std::vector<std::shared_ptr<Texture3D>>& albedoLevels, std::vector<std::shared_ptr<Texture3D>>& normalLevels)
 {
     unsigned int downDimensions = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
     assert( downDimensions % 2 == 0);
@@ -68,35 +108,79 @@ void VoxelizeRT::initMipMaps(Texture::Properties &properties)
         std::shared_ptr<Texture3D>  albedoTexture = std::make_shared<Texture3D>();
         std::shared_ptr<Texture3D>  normalTexture = std::make_shared<Texture3D>();
         
-        albedoTexture->SetWidth(downDimensions);
+        albedoTexture->SetWidth(downDimensions * (anisotropic ? AnisotropicMips::DIRECTIONS : 1));
         albedoTexture->SetHeight(downDimensions);
         albedoTexture->SetDepth(downDimensions);
-        albedoTexture->SetWrap(properties.wrap);
-        albedoTexture->SetMinFilter(properties.minFilter);
-        albedoTexture->SetMagFilter(properties.magFilter);
-        albedoTexture->SetPixelFormat(properties.pixelFormat);
-        albedoTexture->SetDataType(properties.dataFormat);
-        albedoTexture->SetInternalFormat(properties.internalFormat);
+        albedoTexture->SetWrap(albedoProperties.wrap);
+        albedoTexture->SetMinFilter(albedoProperties.minFilter);
+        albedoTexture->SetMagFilter(albedoProperties.magFilter);
+        albedoTexture->SetPixelFormat(albedoProperties.pixelFormat);
+        albedoTexture->SetDataType(albedoProperties.dataFormat);
+        albedoTexture->SetInternalFormat(albedoProperties.internalFormat);
         
         normalTexture->SetWidth(downDimensions);
         normalTexture->SetHeight(downDimensions);
         normalTexture->SetDepth(downDimensions);
-        normalTexture->SetWrap(properties.wrap);
-        normalTexture->SetMinFilter(properties.minFilter);
-        normalTexture->SetMagFilter(properties.magFilter);
-        normalTexture->SetPixelFormat(properties.pixelFormat);
-        normalTexture->SetDataType(properties.dataFormat);
-        normalTexture->SetInternalFormat(properties.internalFormat);
+        normalTexture->SetWrap(normalProperties.wrap);
+        normalTexture->SetMinFilter(normalProperties.minFilter);
+        normalTexture->SetMagFilter(normalProperties.magFilter);
+        normalTexture->SetPixelFormat(normalProperties.pixelFormat);
+        normalTexture->SetDataType(normalProperties.dataFormat);
+        normalTexture->SetInternalFormat(normalProperties.internalFormat);
         
         albedoTexture->SaveTextureState();
         normalTexture->SaveTextureState();
-        albedoMipMaps.push_back(albedoTexture);
-        normalMipMaps.push_back(normalTexture);
+        albedoLevels.push_back(albedoTexture);
+        normalLevels.push_back(normalTexture);
     
         downDimensions = downDimensions >> 1;
     }
 }
 
+void VoxelizeRT::setAnisotropic(bool value)
+{
+    if(value == anisotropic) return;
+    anisotropic = value;
+    
+#ifdef __APPLE__
+    if(anisotropic && anisotropicDownSample == nullptr)
+    {
+        unsigned int dimensions = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
+        anisotropicDownSample = std::make_shared<ComputeShader>("downsize.cl", "downsampleAnisotropic", glm::vec3(dimensions), 3);
+    }
+#endif
+    
+    //the vectors trade their textures for new ones in place, so whoever holds on to them sees the new levels
+    albedoMipMaps.clear();
+    normalMipMaps.clear();
+    backAlbedoMipMaps.clear();
+    backNormalMipMaps.clear();
+    initMipMaps(albedoProperties, normalProperties, albedoMipMaps, normalMipMaps);
+    initMipMaps(albedoProperties, normalProperties, backAlbedoMipMaps, backNormalMipMaps);
+    queueVoxelization();
+}
+
+void VoxelizeRT::setOccupancy(bool value)
+{
+    if(value == (occupancy != nullptr)) return;
+    
+    occupancy = backOccupancy = occupancyScratch = nullptr;
+#ifdef __APPLE__
+    occupancyBuild = nullptr;
+#endif
+    if(value)
+    {
+        unsigned int dimensions = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
+        occupancy = OccupancyGrid::createTexture(dimensions);
+        backOccupancy = OccupancyGrid::createTexture(dimensions);
+        occupancyScratch = OccupancyGrid::createTexture(dimensions);
+#ifdef __APPLE__
+        occupancyBuild = std::make_shared<ComputeShader>("downsize.cl", "buildOccupancy", glm::vec3(dimensions, dimensions >> 1, dimensions >> 1), 3);
+#endif
+    }
+    queueVoxelization();
+}
+
 void VoxelizeRT::initDepthBuffer(int index, Texture::Dimensions &dimensions, Texture::Properties& properties)
 {
     depthFBOs[index] = std::make_shared<FBO_2D>(dimensions, properties);
@@ -112,41 +196,41 @@ void VoxelizeRT::initDepthPeelingBuffers(Texture::Dimensions& dimensions, Textur
     }
 }
 
-void VoxelizeRT::voxelize(Scene& renderScene)
+void VoxelizeRT::reprojectLayer(Scene& renderScene, int layer)
 {
-    FBO::Commands voxelCommands(voxelFBO.get());
+    Profiler::Scope profile("voxel reprojection");
+    FBO::Commands voxelCommands(backFBO.get());
     
     voxelCommands.colorMask( true );
     voxelCommands.enableBlend(false);
     voxelCommands.backFaceCulling(true);
     
-    for(int i = 0; i < depthFBOs.size(); ++i)
-    {
-        Texture2D* depthTexture = static_cast<Texture2D*>(depthFBOs[i]->getDepthTexture());
-        Texture2D* albedoTexture = static_cast<Texture2D*>(depthFBOs[i]->getRenderTexture(0));
-        Texture2D* normalTexture = static_cast<Texture2D*>(depthFBOs[i]->getRenderTexture(1));
-        
-        static ShaderParameter::ShaderParamsGroup settings;
-        setLightingParameters(settings, renderScene.pointLights);
-
-        settings["depthTexture"] = depthTexture;
-        settings["albedoTexture"] = albedoTexture;
-        settings["normalTexture"] = normalTexture;
-        settings["numberOfLights"] = 1u;
-        
-        glm::mat4 toWorldSpace = orthoCamera.getProjectionMatrix() * orthoCamera.viewMatrix;
-        toWorldSpace = glm::inverse(toWorldSpace);
-        settings["zPlaneProjection"] = voxViewProjection;
-        settings["toWorldSpace"] = toWorldSpace;
-        settings["cubeDimensions"] = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
-        
-        Material::Commands commands(voxMaterial.get());
-        commands.uploadParameters(settings);
-        
-        Points::Commands pointsCommands (points.get());
-        pointsCommands.render();
+    Texture2D* depthTexture = static_cast<Texture2D*>(depthFBOs[layer]->getDepthTexture());
+    Texture2D* albedoTexture = static_cast<Texture2D*>(depthFBOs[layer]->getRenderTexture(0));
+    Texture2D* normalTexture = static_cast<Texture2D*>(depthFBOs[layer]->getRenderTexture(1));
+    
+    static ShaderParameter::ShaderParamsGroup settings;
+    setLightingParameters(settings, renderScene.pointLights);
 
-    }
+    settings["depthTexture"] = depthTexture;
+    settings["albedoTexture"] = albedoTexture;
+    settings["normalTexture"] = normalTexture;
+    settings["numberOfLights"] = 1u;
+    
+    glm::mat4 toWorldSpace = orthoCamera.getProjectionMatrix() * orthoCamera.viewMatrix;
+    toWorldSpace = glm::inverse(toWorldSpace);
+    settings["zPlaneProjection"] = voxViewProjection;
+    settings["toWorldSpace"] = toWorldSpace;
+    settings["cubeDimensions"] = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
+    settings["regionBegin"] = glm::vec3(voxelRegion.begin);
+    settings["regionEnd"] = glm::vec3(voxelRegion.end);
+    settings["octahedralNormals"] = VoxelizationMaterial::VOXEL_FORMAT.hasOctahedralNormals();
+    
+    Material::Commands commands(voxMaterial.get());
+    commands.uploadParameters(settings);
+    
+    Points::Commands pointsCommands (points.get());
+    pointsCommands.render();
     voxelCommands.end();
 
 }
@@ -174,123 +258,517 @@ void VoxelizeRT::presentOrthographicDepth(Scene &scene,  int layer)
     fboCommands.end();
 }
 
-void VoxelizeRT::generateDepthPeelingMaps(Scene& renderScene)
+void VoxelizeRT::peelLayer(int layer)
 {    
+    Profiler::Scope profile("depth peeling");
     static ShaderParameter::ShaderParamsGroup params;
     
-    glm::mat4 MVP = orthoCamera.getProjectionMatrix() * orthoCamera.viewMatrix;
-    bool firstRender = true;
+    glm::mat4 VP = orthoCamera.getProjectionMatrix() * orthoCamera.viewMatrix;
+    bool firstRender = layer == 0;
+    
+    //only the part of the maps that lands in the region being voxelized matters, the rest is left cleared and the
+    //voxelization shader throws those texels away
+    glm::ivec4 scissorRect;
+    bool useScissor = getScissorRect(scissorRect);
     
+    //every layer peels what's behind the layer before it, which is still in its map from an earlier slice
     Texture2D dummyTexture(true);
-    Texture2D* texture = firstRender ? &dummyTexture : static_cast<Texture2D*>(depthFBOs[0]->getDepthTexture());
+    Texture2D* texture = firstRender ? &dummyTexture : static_cast<Texture2D*>(depthFBOs[layer - 1]->getDepthTexture());
 
     params["depthTexture"] = texture;
+    params["firstRender"]  = firstRender ? 1 : 0;
+    params["VP"] = VP;
     
     Material::Commands depthPeelingCommands(depthPeelingMat.get());
-    for(int i = 0; i < depthFBOs.size(); ++i)
+    FBO::Commands commands(depthFBOs[layer].get());
+
+    commands.clearRenderTarget();
+    commands.colorMask(true);
+    commands.backFaceCulling(false);
+    commands.enableDepthTest(true);
+    if(useScissor)
     {
-        params["firstRender"]  = firstRender ? 1 : 0;
-        FBO::Commands commands(depthFBOs[i].get());
+        commands.scissor(scissorRect.x, scissorRect.y, scissorRect.z, scissorRect.w);
+    }
+    
+    //every mesh's model matrix and color come from the draw list's table
+    assert(drawList != nullptr);
+    depthPeelingCommands.uploadParameters(params);
+    DrawList::Commands drawCommands(drawList);
+    drawCommands.render();
+    commands.disableScissor();
+    commands.end();
+}
 
-        commands.clearRenderTarget();
-        commands.colorMask(true);
-        commands.backFaceCulling(false);
-        commands.enableDepthTest(true);
+void VoxelizeRT::voxelizeSlabs()
+{
+    Profiler::Scope profile("slab voxelization");
+    unsigned int dimensions = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
+    if(slabsFBO == nullptr)
+    {
+        //the x, y and z slabs one after the other, with plain normals since nothing filters them
+        Texture::Dimensions slabDimensions;
+        slabDimensions.width = slabDimensions.height = dimensions;
+        slabDimensions.depth = 3 * dimensions;
         
-        for(Shape* shape: renderScene.shapes)
-        {
-            params["MVP"] = MVP *shape->transform.getTransformMatrix();
-            size_t numberOfProperties = shape->getMeshProperties().size();
+        Texture::Properties slabProperties;
+        slabProperties.minFilter = GL_NEAREST;
+        slabProperties.magFilter = GL_NEAREST;
+        slabProperties.internalFormat = GL_RGBA16F;
+        slabsFBO = std::make_shared<FBO_3D>(slabDimensions, slabProperties);
+        slabsFBO->addRenderTarget();
+        voxelPoints = std::make_shared<Points>(dimensions * dimensions * dimensions);
+    }
+    
+    //the whole scene goes in every time, only resolveSlabs() keeps to the region being voxelized
+    slabsFBO->ClearRenderTextures();
+    
+    static ShaderParameter::ShaderParamsGroup params;
+    params["gridFromWorld"] = gridFromWorld;
+    params["cubeDimensions"] = dimensions;
+    params["conservative"] = conservative;
+    
+    Material::Commands slabCommands(slabsMat.get());
+    FBO::Commands commands(slabsFBO.get());
+    commands.colorMask(true);
+    commands.enableBlend(false);
+    commands.backFaceCulling(false);
+    commands.enableDepthTest(false);
+    
+    //the two planes of the slab every copy of a triangle is clipped to
+    glEnable(GL_CLIP_DISTANCE0);
+    glEnable(GL_CLIP_DISTANCE1);
+    
+    assert(drawList != nullptr);
+    slabCommands.uploadParameters(params);
+    DrawList::Commands drawCommands(drawList);
+    drawCommands.render();
+    
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_CLIP_DISTANCE1);
+    commands.end();
+}
 
-            int i = 0;
-            for(Mesh* mesh : shape->meshes)
-            {
-                glError();
-                params["diffuseColor"] = i < numberOfProperties ? shape->getMeshProperties()[i].diffuseColor : shape->defaultVoxProperties.diffuseColor;
-                
-                mesh->render(params, depthPeelingCommands);
-                glError();
-                ++i;
-            }
-        }
-        commands.end();
-        firstRender = false;
-        texture = static_cast<Texture2D*>(depthFBOs[i]->getDepthTexture());
-        params["depthTexture"] = texture;
+void VoxelizeRT::resolveSlabs(Scene& renderScene)
+{
+    Profiler::Scope profile("slab resolve");
+    FBO::Commands voxelCommands(backFBO.get());
+    
+    voxelCommands.colorMask( true );
+    voxelCommands.enableBlend(false);
+    voxelCommands.backFaceCulling(true);
+    
+    static ShaderParameter::ShaderParamsGroup settings;
+    setLightingParameters(settings, renderScene.pointLights);
+    
+    settings["albedoSlabs"] = static_cast<Texture3D*>(slabsFBO->getRenderTexture(0));
+    settings["normalSlabs"] = static_cast<Texture3D*>(slabsFBO->getRenderTexture(1));
+    settings["numberOfLights"] = 1u;
+    settings["worldFromGrid"] = glm::inverse(gridFromWorld);
+    settings["cubeDimensions"] = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
+    settings["regionBegin"] = glm::vec3(voxelRegion.begin);
+    settings["regionEnd"] = glm::vec3(voxelRegion.end);
+    settings["octahedralNormals"] = VoxelizationMaterial::VOXEL_FORMAT.hasOctahedralNormals();
+    
+    Material::Commands commands(resolveMat.get());
+    commands.uploadParameters(settings);
+    
+    Points::Commands pointsCommands(voxelPoints.get());
+    pointsCommands.render();
+    voxelCommands.end();
+}
+
+bool VoxelizeRT::getScissorRect(glm::ivec4& rect)
+{
+    int dimensions = int(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS);
+    if(voxelRegion.begin == glm::ivec3(0) && voxelRegion.end == glm::ivec3(dimensions))
+    {
+        return false;
+    }
+    
+    glm::mat4 clipFromGrid = orthoCamera.getProjectionMatrix() * orthoCamera.viewMatrix * glm::inverse(gridFromWorld);
+    glm::vec2 minCorner(std::numeric_limits<float>::max());
+    glm::vec2 maxCorner(-std::numeric_limits<float>::max());
+    for(int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner((i & 1) ? voxelRegion.end.x : voxelRegion.begin.x,
+                         (i & 2) ? voxelRegion.end.y : voxelRegion.begin.y,
+                         (i & 4) ? voxelRegion.end.z : voxelRegion.begin.z);
+        glm::vec2 pixel = (glm::vec2(clipFromGrid * glm::vec4(corner, 1.0f)) * 0.5f + 0.5f) * float(dimensions);
+        minCorner = glm::min(minCorner, pixel);
+        maxCorner = glm::max(maxCorner, pixel);
+    }
+    
+    glm::ivec2 begin = glm::max(glm::ivec2(glm::floor(minCorner)) - 1, glm::ivec2(0));
+    glm::ivec2 end = glm::min(glm::ivec2(glm::ceil(maxCorner)) + 1, glm::ivec2(dimensions));
+    rect = glm::ivec4(begin, glm::max(end - begin, glm::ivec2(0)));
+    return true;
+}
+
+void VoxelizeRT::clearVoxelRegion(const VoxelGrid::Region& region)
+{
+    if(region.begin == glm::ivec3(0) && region.end == glm::ivec3(int(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS)))
+    {
+        backFBO->ClearRenderTextures();
+        return;
+    }
+    
+    for(int i = 0; i < backFBO->getNumOfRenderTargets(); ++i)
+    {
+        Texture3D::Commands commands(static_cast<Texture3D*>(backFBO->getRenderTexture(i)));
+        commands.clearRegion(region.begin, region.size());
     }
 }
 
-void VoxelizeRT::fillUpVoxelTexture(Scene& renderScene)
+#ifdef __APPLE__
+void VoxelizeRT::generateMipMapLevel(unsigned int level, VoxelGrid::Region region)
 {
-    generateDepthPeelingMaps(renderScene);
-    voxelize(renderScene);
+    Profiler::Scope profile("mip generation");
+    Texture3D* currentAlbedoTexture = level == 0 ? static_cast<Texture3D*>(backFBO->getRenderTexture(0)) : backAlbedoMipMaps[level - 1].get();
+    Texture3D* currentNormalTexture = level == 0 ? static_cast<Texture3D*>(backFBO->getRenderTexture(1)) : backNormalMipMaps[level - 1].get();
+    
+    std::shared_ptr<Texture3D> albedoMipMap = backAlbedoMipMaps[level];
+    std::shared_ptr<Texture3D> normalMipMap = backNormalMipMaps[level];
+    ComputeShader& kernel = anisotropic ? *anisotropicDownSample : downSample;
+    int error = kernel.setReadWriteImage3DArgument(0, currentAlbedoTexture->GetTextureID());
+    error |= kernel.setReadWriteImage3DArgument(1, currentNormalTexture->GetTextureID());
+    
+    error |= kernel.setReadWriteImage3DArgument(2, albedoMipMap->GetTextureID());
+    assert(error == CL_SUCCESS);
+    error |= kernel.setReadWriteImage3DArgument(3, normalMipMap->GetTextureID());
+    assert(error == CL_SUCCESS);
+    if(anisotropic)
+    {
+        kernel.setArgument(4, level > 0 ? 1 : 0);
+        kernel.setArgument(5, VoxelizationMaterial::VOXEL_FORMAT.hasOctahedralNormals() ? 1 : 0);
+    }
+    for(unsigned int i = 0; i <= level; ++i)
+    {
+        region = region.downsampled();
+    }
+    kernel.setGlobalWorkOffset(glm::vec3(region.begin));
+    kernel.setGlobalWorkSize(glm::vec3(region.size()));
+    kernel.run();
+    
+    if(occupancy != nullptr)
+    {
+        generateOccupancyLevel(level + 1);
+    }
+}
+
+void VoxelizeRT::generateOccupancyLevel(unsigned int level)
+{
+    //the whole level is rebuilt, a byte per cell, and the rest copied, so no region is needed
+    int error = occupancyBuild->setReadWriteImage3DArgument(0, backFBO->getRenderTexture(0)->GetTextureID());
+    error |= occupancyBuild->setReadWriteImage3DArgument(1, backOccupancy->GetTextureID());
+    error |= occupancyBuild->setReadWriteImage3DArgument(2, occupancyScratch->GetTextureID());
+    assert(error == CL_SUCCESS);
+    occupancyBuild->setArgument(3, int(level));
+    occupancyBuild->run();
+    std::swap(backOccupancy, occupancyScratch);
+}
+#endif
+
+void VoxelizeRT::generateMipMapsOnCPU(VoxelGrid::Region region)
+{
+    Profiler::Scope profile("mip generation");
+    if(cpuVoxels.getDimensions() != VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS)
+    {
+        cpuVoxels.resize(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS);
+    }
+    
+    {
+        Texture3D::Commands commands(static_cast<Texture3D*>(backFBO->getRenderTexture(0)));
+        commands.readData(&cpuVoxels.albedo[0]);
+    }
+    {
+        Texture3D::Commands commands(static_cast<Texture3D*>(backFBO->getRenderTexture(1)));
+        commands.readData(&cpuVoxels.normal[0]);
+    }
+    VoxelizationMaterial::VOXEL_FORMAT.decodeNormals(cpuVoxels);
+    
+    MipChainBuilder::build(cpuVoxels, cpuMipMaps, region);
+    if(occupancy != nullptr)
+    {
+        cpuOccupancy.build(cpuVoxels, region);
+        cpuOccupancy.upload(backOccupancy.get());
+    }
+    if(anisotropic)
+    {
+        AnisotropicMips::build(cpuVoxels, cpuAnisotropicMipMaps, region);
+    }
+    
+    for(size_t i = 0; i < backAlbedoMipMaps.size(); ++i)
+    {
+        region = region.downsampled();
+        if(anisotropic)
+        {
+            //one box per direction, the level's texels are laid out like the texture
+            Texture3D::Commands commands(backAlbedoMipMaps[i].get());
+            for(unsigned int direction = 0; direction < AnisotropicMips::DIRECTIONS; ++direction)
+            {
+                glm::ivec3 offset = region.begin + glm::ivec3(int(direction * cpuAnisotropicMipMaps[i].dimensions), 0, 0);
+                commands.uploadRegion(&cpuAnisotropicMipMaps[i].albedo[0], offset, region.size());
+            }
+        }
+        else
+        {
+            Texture3D::Commands commands(backAlbedoMipMaps[i].get());
+            commands.uploadRegion(&cpuMipMaps[i].albedo[0], region.begin, region.size());
+        }
+        {
+            Texture3D::Commands commands(backNormalMipMaps[i].get());
+            commands.uploadRegion(VoxelizationMaterial::VOXEL_FORMAT.encodeNormals(cpuMipMaps[i], region, encodedNormals), region.begin, region.size());
+        }
+    }
 }
 
-void VoxelizeRT::generateMipMaps()
+void VoxelizeRT::readBack(VoxelGrid& base, std::vector<VoxelGrid>& mips)
 {
-    Texture3D* currentAlbedoTexture = static_cast<Texture3D*>(voxelFBO->getRenderTexture(0));
-    Texture3D* currentNormalTexture = static_cast<Texture3D*>(voxelFBO->getRenderTexture(1));
+    mips.resize(albedoMipMaps.size());
     
     unsigned int dimensions = VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS;
-    int i = 0;
-    for( std::shared_ptr<Texture3D> albedoMipMap : albedoMipMaps)
+    for(size_t level = 0; level <= albedoMipMaps.size(); ++level)
     {
-        dimensions = dimensions >> 1;
-        if( dimensions == 0) break;
+        VoxelGrid& grid = level == 0 ? base : mips[level - 1];
+        Texture3D* albedoTexture = level == 0 ? static_cast<Texture3D*>(voxelFBO->getRenderTexture(0)) : albedoMipMaps[level - 1].get();
+        Texture3D* normalTexture = level == 0 ? static_cast<Texture3D*>(voxelFBO->getRenderTexture(1)) : normalMipMaps[level - 1].get();
         
-        std::shared_ptr<Texture3D> normalMipMap = normalMipMaps[i];
-        int error = downSample.setReadWriteImage3DArgument(0, currentAlbedoTexture->GetTextureID());
-        error |= downSample.setReadWriteImage3DArgument(1, currentNormalTexture->GetTextureID());
-        
-        error |= downSample.setReadWriteImage3DArgument(2, albedoMipMap->GetTextureID());
-        assert(error == CL_SUCCESS);
-        error |= downSample.setReadWriteImage3DArgument(3, normalMipMap->GetTextureID());
-        assert(error == CL_SUCCESS);
-        downSample.setGlobalWorkSize(glm::vec3(float(dimensions), float(dimensions), float(dimensions)));
-        downSample.run();
-        currentAlbedoTexture = albedoMipMap.get();
-        currentNormalTexture = normalMipMap.get();
-        ++i;
+        if(grid.getDimensions() != dimensions)
+        {
+            grid.resize(dimensions);
+        }
+        if(anisotropic && level > 0)
+        {
+            std::vector<glm::vec4> directions(size_t(AnisotropicMips::DIRECTIONS) * grid.size());
+            Texture3D::Commands commands(albedoTexture);
+            commands.readData(&directions[0]);
+            AnisotropicMips::collapse(&directions[0], dimensions, grid.albedo);
+        }
+        else
+        {
+            Texture3D::Commands commands(albedoTexture);
+            commands.readData(&grid.albedo[0]);
+        }
+        {
+            Texture3D::Commands commands(normalTexture);
+            commands.readData(&grid.normal[0]);
+        }
+        VoxelizationMaterial::VOXEL_FORMAT.decodeNormals(grid);
+        dimensions = dimensions >> 1;
+    }
+}
+
+VoxelGrid::Difference VoxelizeRT::compareCoverage(Scene& scene)
+{
+    //the current strategy goes last so its volume is the one left in front
+    Strategy current = strategy;
+    Strategy other = current == Strategy::DEPTH_PEELING ? Strategy::GEOMETRY_SHADER : Strategy::DEPTH_PEELING;
+    VoxelGrid peeled, sliced;
+    std::vector<VoxelGrid> mips;
+    for(Strategy pass : {other, current})
+    {
+        strategy = pass;
+        queueVoxelization();
+        Render(scene);
+        readBack(pass == Strategy::DEPTH_PEELING ? peeled : sliced, mips);
     }
     
+    VoxelGrid::Difference difference = peeled.compare(sliced);
+    std::cout << "depth peeling vs geometry shader voxelization: " << difference.occupiedInThis << " peeled voxels, "
+              << difference.occupiedInOther << " geometry shader voxels, " << difference.occupancyMismatches
+              << " occupancy mismatches, albedo error max " << difference.maxAlbedoError << " mean "
+              << difference.meanAlbedoError << std::endl;
+    return difference;
 }
-void VoxelizeRT::Render(Scene& renderScene)
+
+VoxelGrid::Difference VoxelizeRT::validateCoverage(Scene& scene)
 {
+    //a build in progress or a budgeted one would leave the front volume behind the scene
+    queueVoxelization();
+    Render(scene);
     
-    //for opengl 4.2  (Macs support up to  4.1) this code isn't necessary because you have access to extensions that allow you to
-    //to do this much easier in a shader, check out imageLoad/imageStore glsl functions.  Also, check out
-    //this article which explains how to voxelize a scene using an octree:
-    //https://www.seas.upenn.edu/~pcozzi/OpenGLInsights/OpenGLInsights-SparseVoxelization.pdf (chapter 22)
+    VoxelGrid reference(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS);
+    CPUVoxelizer voxelizer(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS, voxViewProjection);
+    voxelizer.voxelize(scene, reference);
     
-    voxelFBO->ClearRenderTextures();
+    VoxelGrid gpuGrid;
+    std::vector<VoxelGrid> mips;
+    readBack(gpuGrid, mips);
     
-    //from y plane
-    orthoCamera.position = glm::vec3(0.0f, 1.5f, 0.0f);
-    orthoCamera.forward =  glm::vec3(0.0f, -1.0f, 0.0f);
-    orthoCamera.up = glm::vec3(-1.0f, 0.0f, 0.0f);
-    orthoCamera.updateViewMatrix();
+    //every mismatch is a voxel only one of the two has
+    VoxelGrid::Difference difference = reference.compare(gpuGrid);
+    size_t missed = (difference.occupancyMismatches + difference.occupiedInThis - difference.occupiedInOther) / 2;
+    size_t extra = difference.occupancyMismatches - missed;
+    std::cout << (strategy == Strategy::DEPTH_PEELING ? "depth peeling" : (conservative ? "conservative geometry shader" : "geometry shader"))
+              << " voxelization vs cpu reference: " << difference.occupiedInThis << " reference voxels, " << missed
+              << " missed, " << extra << " extra" << std::endl;
+    return difference;
+}
 
-    fillUpVoxelTexture(renderScene);
+void VoxelizeRT::Render(Scene& renderScene)
+{
+    ++ticksSinceLastVoxelization;
+    scheduler.beginFrame();
+    
+    bool sceneChanged = dirtyRegion.update(renderScene);
+    if(automaticallyVoxelize && sceneChanged && ticksSinceLastVoxelization >= voxelizationSparsity)
+    {
+        voxelizationQueued = true;
+    }
+    
+    //a build in progress finishes before the next one starts, what changed meanwhile stays in the dirty region
+    bool rebuild = rebuildQueued;
+    if(rebuild || (!building && (voxelizationQueued || regenerateMipmapQueued)))
+    {
+        startBuild(renderScene);
+    }
+    
+    //nothing to show yet or the whole volume asked for, either way it can't wait for later frames
+    bool unbudgeted = rebuild || revision == 0;
+    while(building && (unbudgeted || scheduler.fits(getSliceKind(nextSlice))))
+    {
+        scheduler.beginSlice(getSliceKind(nextSlice));
+        runSlice(renderScene, nextSlice);
+        scheduler.endSlice();
+        
+        if(++nextSlice == getSliceCount())
+        {
+            publish();
+        }
+    }
+}
 
+void VoxelizeRT::startBuild(Scene& renderScene)
+{
+    //the back volume still misses what the last build put in the front one
+    voxelRegion = staleVoxelRegion;
+    if(voxelizationQueued)
+    {
+        voxelRegion = voxelRegion.merged(dirtyRegion.getVoxelRegion(gridFromWorld, VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS));
+        dirtyRegion.clear(renderScene);
+        voxelizationQueued = false;
+        ticksSinceLastVoxelization = 0;
+    }
+    
+    buildMipRegion = staleMipRegion;
+    if(automaticallyRegenerateMipmap)
+    {
+        buildMipRegion = buildMipRegion.merged(voxelRegion);
+    }
+    if(regenerateMipmapQueued)
+    {
+        buildMipRegion = buildMipRegion.merged(mipRegion);
+        regenerateMipmapQueued = false;
+    }
+    
+    rebuildQueued = false;
+    building = !voxelRegion.isEmpty() || !buildMipRegion.isEmpty();
+    nextSlice = voxelRegion.isEmpty() ? getVoxelSlices() : 0;
+}
 
-    //from z plane
-    orthoCamera.position = glm::vec3(0.0f, .0f, 1.5f);
-    orthoCamera.forward =  glm::vec3(0.0f, 0.0f, -1.0f);
-    orthoCamera.up = glm::vec3(0.0f, 1.0f, 0.0f);
-    orthoCamera.updateViewMatrix();
+unsigned int VoxelizeRT::getSliceCount() const
+{
+#if __CPU_MIP_CHAIN
+    unsigned int mipSlices = 1;
+#else
+    unsigned int mipSlices = (unsigned int)backAlbedoMipMaps.size();
+#endif
+    return getVoxelSlices() + mipSlices;
+}
 
-    fillUpVoxelTexture(renderScene);
+unsigned int VoxelizeRT::getVoxelSlices() const
+{
+    return strategy == Strategy::GEOMETRY_SHADER ? 1 : 3 * (unsigned int)depthFBOs.size();
+}
 
-    //from x plane
-    orthoCamera.position = glm::vec3(1.5f, .0f, 0.f);
-    orthoCamera.forward =  glm::vec3(-1.0f, 0.0f, .0f);
-    orthoCamera.up = glm::vec3(0.0f, 1.0f, 0.0f);
-    orthoCamera.updateViewMatrix();
+unsigned int VoxelizeRT::getSliceKind(unsigned int slice) const
+{
+    unsigned int voxelSlices = getVoxelSlices();
+    if(slice < voxelSlices)
+    {
+        return strategy == Strategy::GEOMETRY_SHADER ? 1 + (unsigned int)backAlbedoMipMaps.size() : 0;
+    }
+    return 1 + slice - voxelSlices;
+}
 
-    fillUpVoxelTexture(renderScene);
+void VoxelizeRT::runSlice(Scene& renderScene, unsigned int slice)
+{
+    unsigned int voxelSlices = getVoxelSlices();
+    if(slice < voxelSlices)
+    {
+        if(slice == 0)
+        {
+            clearVoxelRegion(voxelRegion);
+        }
+        if(strategy == Strategy::GEOMETRY_SHADER)
+        {
+            voxelizeSlabs();
+            resolveSlabs(renderScene);
+            return;
+        }
+        
+        int axis = int(slice / depthFBOs.size());
+        int layer = int(slice % depthFBOs.size());
+        if(layer == 0)
+        {
+            setAxis(axis);
+        }
+        peelLayer(layer);
+        reprojectLayer(renderScene, layer);
+        return;
+    }
+    
+    if(buildMipRegion.isEmpty()) return;
+#if __CPU_MIP_CHAIN
+    generateMipMapsOnCPU(buildMipRegion);
+#else
+    generateMipMapLevel(slice - voxelSlices, buildMipRegion);
+#endif
+}
 
-    generateMipMaps();
+void VoxelizeRT::publish()
+{
+    //the vectors trade contents rather than places so whoever holds on to the front ones sees the new levels
+    std::swap(voxelFBO, backFBO);
+    albedoMipMaps.swap(backAlbedoMipMaps);
+    normalMipMaps.swap(backNormalMipMaps);
+    std::swap(occupancy, backOccupancy);
+    
+    staleVoxelRegion = voxelRegion;
+    staleMipRegion = buildMipRegion;
+    building = false;
+    ++revision;
+}
 
+void VoxelizeRT::setAxis(int axis)
+{
+    //for opengl 4.2  (Macs support up to  4.1) this code isn't necessary because you have access to extensions that allow you to
+    //to do this much easier in a shader, check out imageLoad/imageStore glsl functions.  Also, check out
+    //this article which explains how to voxelize a scene using an octree:
+    //https://www.seas.upenn.edu/~pcozzi/OpenGLInsights/OpenGLInsights-SparseVoxelization.pdf (chapter 22)
+    switch(axis)
+    {
+        case 0:
+            //from y plane
+            orthoCamera.position = glm::vec3(0.0f, 1.5f, 0.0f);
+            orthoCamera.forward =  glm::vec3(0.0f, -1.0f, 0.0f);
+            orthoCamera.up = glm::vec3(-1.0f, 0.0f, 0.0f);
+            break;
+        case 1:
+            //from z plane
+            orthoCamera.position = glm::vec3(0.0f, .0f, 1.5f);
+            orthoCamera.forward =  glm::vec3(0.0f, 0.0f, -1.0f);
+            orthoCamera.up = glm::vec3(0.0f, 1.0f, 0.0f);
+            break;
+        default:
+            //from x plane
+            orthoCamera.position = glm::vec3(1.5f, .0f, 0.f);
+            orthoCamera.forward =  glm::vec3(-1.0f, 0.0f, .0f);
+            orthoCamera.up = glm::vec3(0.0f, 1.0f, 0.0f);
+            break;
+    }
+    orthoCamera.updateViewMatrix();
 }
 
 VoxelizeRT::~VoxelizeRT()
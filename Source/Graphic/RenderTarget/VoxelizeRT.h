@@ -16,6 +16,11 @@
 #include "ScreenQuad.h"
 #include <array>
 #include "ComputeShader.h"
+#include "Graphic/Voxelization/VoxelGrid.h"
+#include "Graphic/Voxelization/DirtyRegionTracker.h"
+#include "Graphic/Voxelization/AnisotropicMips.h"
+#include "Graphic/Voxelization/OccupancyGrid.h"
+#include "Time/SliceScheduler.h"
 
 class OrthographicCamera;
 class Material;
@@ -23,16 +28,33 @@ class Points;
 class VoxelizationMaterial;
 class FBO_3D;
 class Texture3D;
+class DrawList;
 
+/// <summary> Voxelizes the scene by depth peeling it from the three axes and reprojecting every layer into the volume,
+/// or, with Strategy::GEOMETRY_SHADER, in a single scene pass that rasterizes every triangle along its dominant axis
+/// into a volume of voxel slabs and a pass that resolves the slabs into the voxels, then box filters the mip maps.  The
+/// volume is double buffered: a build fills the back volume in slices, one peeled layer of one axis (or the whole
+/// geometry shader pass) or one mip level at a time, as many a frame as the time budget allows, and cone tracing keeps
+/// reading the front volume until the build is done and the two swap.  A build only covers the dirty region, plus
+/// whatever the last build put in the other volume.  Meshes that move during a build show up where they were when their
+/// slice ran and get picked up again by the next build. </summary>
 class VoxelizeRT : public RenderTarget
 {
 public:
+    enum class Strategy
+    {
+        DEPTH_PEELING,      //five layers peeled from each axis, 15 scene passes and 15 reprojections
+        GEOMETRY_SHADER     //one scene pass, see Shaders/Voxelization/geometryVoxelization.geom
+    };
+    
     VoxelizeRT(float worldSpaceWidth, float worldSpaceHeight, float worldSpaceDepth );
     void presentOrthographicDepth( Scene& scene, int layer);
     
     virtual void Render( Scene& scene ) override;
     virtual ~VoxelizeRT();
     
+    ///<summary> The front volume and mip maps, the last ones finished.  The textures swap with the back ones when a
+    /// build finishes and getRevision() goes up, the mip map vectors stay the same objects. </summary>
     inline std::shared_ptr<FBO_3D> getFBO(){ return voxelFBO;};
     inline glm::mat4 getVoxViewProjection(){ return voxViewProjection; }
     inline std::shared_ptr<Texture3D> getAlbedoMipMapLevel( int index) { assert(index < albedoMipMaps.size()); return albedoMipMaps[index];}
@@ -41,15 +63,83 @@ public:
     std::vector<std::shared_ptr<Texture3D>>& getNormalMipMaps(){ return normalMipMaps; }
     std::vector<std::shared_ptr<Texture3D>>& getAlbedoMipMaps(){ return albedoMipMaps; }
     
+    ///<summary> Revoxelizes the whole volume next frame in one go, regardless of what changed or the time budget.  A
+    /// build in progress is dropped. </summary>
+    inline void queueVoxelization(){ voxelizationQueued = true; rebuildQueued = true; dirtyRegion.invalidateAll(); }
+    inline void queueMipmapRegeneration(){ regenerateMipmapQueued = true; mipRegion = VoxelGrid::Region::whole(VoxelizationMaterial::VOXEL_TEXTURE_DIMENSIONS); }
+    
+    ///<summary> When off, the volume is only voxelized through queueVoxelization(). </summary>
+    inline void setAutomaticallyVoxelize(bool value){ automaticallyVoxelize = value; }
+    inline void setVoxelizationSparsity(int ticks){ voxelizationSparsity = ticks; }
+    
+    ///<summary> Milliseconds a frame may spend building the back volume, 0 builds it all in the frame it starts.  The
+    /// first build and the ones queueVoxelization() asks for ignore it. </summary>
+    inline void setTimeBudget(double milliseconds){ scheduler.setBudget(milliseconds); }
+    
+    ///<summary> What the depth peeling draws the scene's meshes with, one draw per layer.  Expected to be updated for
+    /// the scene before every Render(). </summary>
+    inline void setDrawList(DrawList* list){ drawList = list; }
+    
+    ///<summary> Revoxelizes the whole volume with the new strategy next frame. </summary>
+    inline void setStrategy(Strategy value){ strategy = value; queueVoxelization(); }
+    inline Strategy getStrategy() const { return strategy; }
+    
+    ///<summary> Conservative rasterization for the geometry shader strategy: every voxel a triangle touches is filled,
+    /// so thin walls don't leak light at low resolutions.  Revoxelizes the whole volume next frame. </summary>
+    inline void setConservative(bool value){ conservative = value; queueVoxelization(); }
+    inline bool isConservative() const { return conservative; }
+    
+    ///<summary> Albedo mips with six directions per voxel (see AnisotropicMips.h) instead of one average.  Replaces the
+    /// albedo mip textures inside the same vectors and rebuilds the mips next frame. </summary>
+    void setAnisotropic(bool value);
+    inline bool isAnisotropic() const { return anisotropic; }
+    
+    ///<summary> Builds an occupancy pyramid (see OccupancyGrid.h) alongside the mips, for ray marchers to skip empty
+    /// space with.  Rebuilds the volume next frame.  The texture swaps along with the volumes, nullptr when off. </summary>
+    void setOccupancy(bool value);
+    inline Texture3D* getOccupancyTexture() const { return occupancy.get(); }
+    
+    ///<summary> Voxelizes the whole volume with both strategies right away and prints how much their voxels differ,
+    /// leaving the current strategy's volume in front. </summary>
+    VoxelGrid::Difference compareCoverage(Scene& scene);
+    
+    ///<summary> Voxelizes the whole volume right away, then voxelizes the scene with CPUVoxelizer, which fills every
+    /// voxel a triangle touches, and prints how many of those voxels the GPU misses and how many it has that the
+    /// reference doesn't. </summary>
+    VoxelGrid::Difference validateCoverage(Scene& scene);
+    
+    ///<summary> Goes up every time the front volume is swapped for a newer one. </summary>
+    inline unsigned int getRevision() const { return revision; }
+    
+    ///<summary> Reads the front voxel textures and all of their mip maps back from the GPU.  Anisotropic albedo mips
+    /// come back as the average of their six directions. </summary>
+    void readBack(VoxelGrid& base, std::vector<VoxelGrid>& mips);
+    
     static const float VOXELS_WORLD_SCALE;
     
+    ///<summary> The world to voxel volume projection every voxelization path (GPU or CPU) shares. </summary>
+    static glm::mat4 makeVoxViewProjection();
+    
 private:
-    void fillUpVoxelTexture( Scene& renderScene);
-    void voxelize(Scene& renderScene);
-    void generateDepthPeelingMaps(Scene& renderScene);
+    void startBuild(Scene& renderScene);
+    void runSlice(Scene& renderScene, unsigned int slice);
+    void publish();
+    unsigned int getSliceCount() const;
+    unsigned int getSliceKind(unsigned int slice) const;
+    unsigned int getVoxelSlices() const;
+    void setAxis(int axis);
+    void reprojectLayer(Scene& renderScene, int layer);
+    void peelLayer(int layer);
+    void voxelizeSlabs();
+    void resolveSlabs(Scene& renderScene);
     void initDepthBuffer(int index, Texture::Dimensions &dimensions, Texture::Properties& properties);
-    void generateMipMaps();
-    void initMipMaps(Texture::Properties& properties);
+    void generateMipMapLevel(unsigned int level, VoxelGrid::Region region);
+    void generateMipMapsOnCPU(VoxelGrid::Region region);
+    void generateOccupancyLevel(unsigned int level);
+    void clearVoxelRegion(const VoxelGrid::Region& region);
+    bool getScissorRect(glm::ivec4& rect);
+    void initMipMaps(Texture::Properties& albedoProperties, Texture::Properties& normalProperties,
+                     std::vector<std::shared_ptr<Texture3D>>& albedoLevels, std::vector<std::shared_ptr<Texture3D>>& normalLevels);
     void initDepthPeelingBuffers(Texture::Dimensions& dimensions, Texture::Properties& properties);
     
 private:
@@ -57,9 +147,28 @@ private:
     bool regenerateMipmapQueued = true;
     bool automaticallyVoxelize = true;
     bool voxelizationQueued = true;
-    int voxelizationSparsity = 1; // Number of ticks between mipmap generation.
+    int voxelizationSparsity = 1; // Minimum number of ticks between voxelizations.
     int ticksSinceLastVoxelization = voxelizationSparsity;
     
+    DirtyRegionTracker dirtyRegion;
+    glm::mat4 gridFromWorld;
+    VoxelGrid::Region voxelRegion;  //part of the volume being voxelized by the build
+    VoxelGrid::Region mipRegion;    //part of the volume whose mips are out of date
+    unsigned int revision = 0;
+    
+    Strategy strategy = Strategy::DEPTH_PEELING;
+    bool conservative = false;
+    bool anisotropic = false;
+    
+    //the build of the back volume, slices are peeled layers of each axis (or the geometry shader pass) and then mip levels
+    bool building = false;
+    bool rebuildQueued = false;
+    unsigned int nextSlice = 0;
+    VoxelGrid::Region buildMipRegion;
+    VoxelGrid::Region staleVoxelRegion; //what the back volume misses of the front one
+    VoxelGrid::Region staleMipRegion;
+    SliceScheduler scheduler;
+    
     
     //state variables we will be modifying
     int colorMask[4];
@@ -73,16 +182,44 @@ private:
     std::shared_ptr<VoxelizationMaterial> voxMaterial = nullptr;
     std::shared_ptr<Material> textureDisplayMat = nullptr;
     std::shared_ptr<Material> depthPeelingMat = nullptr;
+    std::shared_ptr<Material> slabsMat = nullptr;
+    std::shared_ptr<VoxelizationMaterial> resolveMat = nullptr;
+    std::shared_ptr<Points> voxelPoints = nullptr;  //one per voxel, for the resolve
+    DrawList* drawList = nullptr;
     
     OrthographicCamera orthoCamera;
     ScreenQuand screenQuad;
     std::shared_ptr<FBO_3D> voxelFBO;
+    std::shared_ptr<FBO_3D> backFBO;
+    Texture::Properties albedoProperties;   //of the voxel textures and their mips
+    Texture::Properties normalProperties;
+    std::shared_ptr<FBO_3D> slabsFBO;   //what the geometry shader pass rasterizes, three slabs per voxel
     glm::mat4 voxViewProjection;
+#ifdef __APPLE__
     ComputeShader downSample;
+    std::shared_ptr<ComputeShader> anisotropicDownSample;  //only made once anisotropic mips are asked for
+#endif
+    
+    //front and back occupancy like the volumes, levels are built from the back one into the scratch one and swapped
+    std::shared_ptr<Texture3D> occupancy;
+    std::shared_ptr<Texture3D> backOccupancy;
+    std::shared_ptr<Texture3D> occupancyScratch;
+#ifdef __APPLE__
+    std::shared_ptr<ComputeShader> occupancyBuild;
+#endif
     
     
     std::vector< std::shared_ptr<Texture3D> > albedoMipMaps;
     std::vector< std::shared_ptr<Texture3D> > normalMipMaps;
+    std::vector< std::shared_ptr<Texture3D> > backAlbedoMipMaps;
+    std::vector< std::shared_ptr<Texture3D> > backNormalMipMaps;
+    
+    //read back copy of the voxel textures and their mips, only used when mips are built on the CPU
+    VoxelGrid cpuVoxels;
+    std::vector<VoxelGrid> cpuMipMaps;
+    std::vector<AnisotropicMips::Level> cpuAnisotropicMipMaps;
+    OccupancyGrid cpuOccupancy;
+    std::vector<glm::vec4> encodedNormals;
     
     std::array<std::shared_ptr<FBO_2D>, 5> depthFBOs {nullptr, nullptr, nullptr, nullptr};
 };
@@ -0,0 +1,199 @@
+//
+//  AnisotropicMips.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "AnisotropicMips.h"
+#include "MipChainBuilder.h"
+#include "Utility/Parallel.h"
+#include <assert.h>
+#include <algorithm>
+#include <iostream>
+
+const unsigned int AnisotropicMips::DIRECTIONS;
+
+void AnisotropicMips::Level::resize(unsigned int _dimensions)
+{
+    dimensions = _dimensions;
+    albedo.assign(size_t(DIRECTIONS) * dimensions * dimensions * dimensions, glm::vec4(0.0f));
+}
+
+void AnisotropicMips::filter(const VoxelGrid& base, const Level* source, Level& destination, unsigned int direction,
+                             unsigned int x, unsigned int y, unsigned int z)
+{
+    //positive directions enter a block through its lower half, negative ones through its upper half
+    unsigned int axis = direction / 2;
+    unsigned int front = direction & 1;
+    auto fetch = [&](const glm::uvec3& voxel)
+    {
+        return source != nullptr ? source->albedo[source->index(direction, voxel.x, voxel.y, voxel.z)]
+                                 : base.albedo[base.index(voxel.x, voxel.y, voxel.z)];
+    };
+
+    //same order as getDirectional() in downsize.cl
+    glm::vec4 sum(0.0f);
+    for(unsigned int column = 0; column < 4; ++column)
+    {
+        glm::uvec3 first = glm::uvec3(x, y, z) * 2u;
+        first[axis] += front;
+        first[(axis + 1) % 3] += column & 1;
+        first[(axis + 2) % 3] += column >> 1;
+        glm::uvec3 second = first;
+        second[axis] ^= 1u;
+        sum += composite(fetch(first), fetch(second));
+    }
+    destination.albedo[destination.index(direction, x, y, z)] = sum * 0.25f;
+}
+
+void AnisotropicMips::build(const VoxelGrid& base, std::vector<Level>& levels)
+{
+    build(base, levels, VoxelGrid::Region::whole(base.getDimensions()));
+}
+
+void AnisotropicMips::build(const VoxelGrid& base, std::vector<Level>& levels, VoxelGrid::Region region)
+{
+    unsigned int dimensions = base.getDimensions();
+    assert(dimensions >= 2 && (dimensions & (dimensions - 1)) == 0 && "voxel grids must be a power of two");
+
+    size_t levelCount = 0;
+    for(unsigned int side = dimensions >> 1; side > 0; side >>= 1) ++levelCount;
+    if(levels.size() != levelCount)
+    {
+        levels.resize(levelCount);
+        region = VoxelGrid::Region::whole(dimensions);
+    }
+    for(size_t level = 0; level < levelCount; ++level)
+    {
+        if(levels[level].dimensions != dimensions >> (level + 1)) levels[level].resize(dimensions >> (level + 1));
+    }
+
+    const Level* source = nullptr;
+    for(Level& level : levels)
+    {
+        region = region.downsampled();
+        Parallel::forRange(region.begin.z, region.end.z, [&](size_t begin, size_t end)
+        {
+            for(size_t z = begin; z < end; ++z)
+            for(int y = region.begin.y; y < region.end.y; ++y)
+            for(int x = region.begin.x; x < region.end.x; ++x)
+            for(unsigned int direction = 0; direction < DIRECTIONS; ++direction)
+            {
+                filter(base, source, level, direction, unsigned(x), unsigned(y), unsigned(z));
+            }
+        });
+        source = &level;
+    }
+}
+
+void AnisotropicMips::collapse(const glm::vec4* texels, unsigned int dimensions, std::vector<glm::vec4>& albedo)
+{
+    size_t rowLength = size_t(DIRECTIONS) * dimensions;
+    albedo.resize(size_t(dimensions) * dimensions * dimensions);
+    for(size_t row = 0; row < size_t(dimensions) * dimensions; ++row)
+    {
+        for(unsigned int x = 0; x < dimensions; ++x)
+        {
+            glm::vec4 sum(0.0f);
+            for(unsigned int direction = 0; direction < DIRECTIONS; ++direction)
+            {
+                sum += texels[row * rowLength + direction * dimensions + x];
+            }
+            albedo[row * dimensions + x] = sum / float(DIRECTIONS);
+        }
+    }
+}
+
+void AnisotropicMips::report()
+{
+    //memory: RGBA32F albedo and normals, the whole pyramid
+    for(unsigned int dimensions : {64u, 128u, 256u})
+    {
+        size_t isotropic = 0, anisotropic = 0;
+        for(unsigned int side = dimensions; side > 0; side >>= 1)
+        {
+            size_t voxels = size_t(side) * side * side;
+            isotropic += voxels * 2;
+            anisotropic += voxels * (side == dimensions ? 2 : DIRECTIONS + 1);
+        }
+        std::cout << "anisotropic mips " << dimensions << "^3: " << anisotropic * sizeof(glm::vec4) / (1024.0 * 1024.0)
+                  << " MB vs " << isotropic * sizeof(glm::vec4) / (1024.0 * 1024.0) << " MB isotropic" << std::endl;
+    }
+
+    //quality: a Cornell box like volume whose walls are one voxel thick, and a sphere shell
+    unsigned int dimensions = 64;
+    VoxelGrid base(dimensions);
+    int low = int(dimensions) / 8;
+    int high = int(dimensions) - low - 1;
+    glm::vec3 center(float(dimensions) * 0.5f);
+    float radius = float(dimensions) / 6.0f;
+    for(int z = 0; z < int(dimensions); ++z)
+    for(int y = 0; y < int(dimensions); ++y)
+    for(int x = 0; x < int(dimensions); ++x)
+    {
+        bool inside = x >= low && x <= high && y >= low && y <= high && z >= low;
+        bool wall = inside && (x == low || x == high || y == low || y == high || z == low);
+        bool sphere = std::abs(glm::length(glm::vec3(x, y, z) + 0.5f - center) - radius) < 0.5f;
+        if(wall || sphere)
+        {
+            base.albedo[base.index(x, y, z)] = glm::vec4(0.7f, 0.6f, 0.5f, 1.0f);
+        }
+    }
+
+    std::vector<VoxelGrid> isotropicLevels;
+    std::vector<Level> anisotropicLevels;
+    MipChainBuilder::build(base, isotropicLevels);
+    build(base, anisotropicLevels);
+
+    //the reference opacity of a voxel along a direction: every base column it covers composited front to back along
+    //the direction, averaged
+    for(size_t level = 0; level < anisotropicLevels.size(); ++level)
+    {
+        unsigned int side = anisotropicLevels[level].dimensions;
+        unsigned int footprint = dimensions / side;
+        float isotropicMax = 0.0f, anisotropicMax = 0.0f;
+        double isotropicSum = 0.0, anisotropicSum = 0.0;
+        size_t compared = 0;
+
+        for(unsigned int direction = 0; direction < DIRECTIONS; ++direction)
+        {
+            unsigned int axis = direction / 2;
+            bool negative = (direction & 1) != 0;
+            for(unsigned int z = 0; z < side; ++z)
+            for(unsigned int y = 0; y < side; ++y)
+            for(unsigned int x = 0; x < side; ++x)
+            {
+                float expected = 0.0f;
+                for(unsigned int column = 0; column < footprint * footprint; ++column)
+                {
+                    float transmittance = 1.0f;
+                    for(unsigned int step = 0; step < footprint; ++step)
+                    {
+                        glm::uvec3 voxel = glm::uvec3(x, y, z) * footprint;
+                        voxel[axis] += negative ? footprint - 1 - step : step;
+                        voxel[(axis + 1) % 3] += column % footprint;
+                        voxel[(axis + 2) % 3] += column / footprint;
+                        transmittance *= 1.0f - base.albedo[base.index(voxel.x, voxel.y, voxel.z)].w;
+                    }
+                    expected += 1.0f - transmittance;
+                }
+                expected /= float(footprint * footprint);
+
+                const VoxelGrid& isotropicLevel = isotropicLevels[level];
+                float isotropic = isotropicLevel.albedo[isotropicLevel.index(x, y, z)].w;
+                float anisotropic = anisotropicLevels[level].albedo[anisotropicLevels[level].index(direction, x, y, z)].w;
+                if(expected == 0.0f && isotropic == 0.0f && anisotropic == 0.0f) continue;
+
+                isotropicMax = std::max(isotropicMax, std::abs(isotropic - expected));
+                anisotropicMax = std::max(anisotropicMax, std::abs(anisotropic - expected));
+                isotropicSum += std::abs(isotropic - expected);
+                anisotropicSum += std::abs(anisotropic - expected);
+                ++compared;
+            }
+        }
+
+        compared = std::max(compared, size_t(1));
+        std::cout << "anisotropic mips level " << level + 1 << " (" << side << "^3) opacity error: isotropic mean "
+                  << isotropicSum / compared << " max " << isotropicMax << ", anisotropic mean " << anisotropicSum / compared
+                  << " max " << anisotropicMax << std::endl;
+    }
+}
@@ -0,0 +1,60 @@
+//
+//  AnisotropicMips.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "VoxelGrid.h"
+
+/// <summary> Albedo mips that keep, for every voxel past the base level, what a ray crossing it sees along each of the
+/// six axis directions (+x, -x, +y, -y, +z, -z) instead of one average.  Every 2x2x2 block is composited front to back
+/// along the direction, one column at a time, and the four columns averaged, so a wall one voxel thick stays opaque
+/// to the rays crossing it at every level instead of fading to 1/2, 1/4, ... of its opacity, which is what lets light
+/// leak through thin walls at coarse levels.  Colors are premultiplied by coverage, which is what voxelization and
+/// the isotropic mips (downsize.cl) already keep.
+///
+/// A level is one texture DIRECTIONS times as wide as it is tall and deep, the directions side by side along x in the
+/// order above; the cone tracer picks the three facing a cone and weighs them by how much the cone runs along each
+/// axis.  Normals stay isotropic.  downsampleAnisotropic in downsize.cl mirrors build(). </summary>
+class AnisotropicMips
+{
+public:
+    static const unsigned int DIRECTIONS = 6;
+
+    struct Level
+    {
+        unsigned int dimensions = 0;
+        std::vector<glm::vec4> albedo;
+
+        void resize(unsigned int dimensions);
+        inline size_t index(unsigned int direction, unsigned int x, unsigned int y, unsigned int z) const
+        {
+            return direction * dimensions + x + size_t(DIRECTIONS) * dimensions * (y + size_t(dimensions) * z);
+        }
+    };
+
+    /// <summary> front over back, both premultiplied. </summary>
+    static inline glm::vec4 composite(const glm::vec4& front, const glm::vec4& back){ return front + (1.0f - front.w) * back; }
+
+    /// <summary> Fills levels with every mip below base, levels[0] being half of base's dimensions, down to 1x1x1. </summary>
+    static void build(const VoxelGrid& base, std::vector<Level>& levels);
+
+    /// <summary> Only refilters the texels of every level that depend on region, given in base voxels. </summary>
+    static void build(const VoxelGrid& base, std::vector<Level>& levels, VoxelGrid::Region region);
+
+    /// <summary> Average of the six directions of a level laid out like its texture, what a sampler that doesn't know
+    /// about directions (the brick pool, comparisons) gets. </summary>
+    static void collapse(const glm::vec4* texels, unsigned int dimensions, std::vector<glm::vec4>& albedo);
+
+    /// <summary> Prints the memory the mip pyramid takes with and without directions at 64, 128 and 256 voxels per
+    /// side, and, per level of a Cornell box like volume with walls one voxel thick, how far the opacity each mode
+    /// gives a ray crossing a voxel along an axis lands from compositing the base voxels it covers. </summary>
+    static void report();
+
+private:
+    static void filter(const VoxelGrid& base, const Level* source, Level& destination, unsigned int direction,
+                       unsigned int x, unsigned int y, unsigned int z);
+};
@@ -0,0 +1,342 @@
+//
+//  BrickPool.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "BrickPool.h"
+#include "MipChainBuilder.h"
+#include "Utility/Parallel.h"
+#include "Graphic/Material/Texture/Texture3D.h"
+#include <assert.h>
+#include <cmath>
+#include <iostream>
+
+const int BrickPool::BRICK_SIZE;
+const int BrickPool::APRON;
+const int BrickPool::STORED_BRICK_SIZE;
+const int BrickPool::EMPTY_BRICK;
+
+BrickPool::BrickPool(unsigned int dimensions, unsigned int levels, unsigned int _brickCapacity):
+brickCapacity(_brickCapacity)
+{
+    assert(levels > 0 && brickCapacity > 0);
+
+    //levels smaller than a brick still take one, partially filled
+    for(unsigned int level = 0; level < levels; ++level)
+    {
+        unsigned int levelSize = std::max(1u, dimensions >> level);
+        levelDimensions.push_back(levelSize);
+        pageTableSides.push_back(std::max(1, int(levelSize + BRICK_SIZE - 1) / BRICK_SIZE));
+        pageTableOffsets.push_back(pageTableWidth);
+        pageTableWidth += pageTableSides.back();
+    }
+    pageTableHeight = pageTableSides[0];
+    pageTable.assign(size_t(pageTableWidth) * pageTableHeight * pageTableHeight, EMPTY_BRICK);
+
+    //close to a cube so no side of the atlas runs into GL_MAX_3D_TEXTURE_SIZE
+    int side = int(std::ceil(std::cbrt(double(brickCapacity))));
+    atlasBricks = glm::ivec3(side, side, (int(brickCapacity) + side * side - 1) / (side * side));
+}
+
+BrickPool::~BrickPool()
+{
+}
+
+unsigned int BrickPool::denseBrickCount(unsigned int dimensions, unsigned int levels)
+{
+    unsigned int count = 0;
+    for(unsigned int level = 0; level < levels; ++level)
+    {
+        unsigned int side = std::max(1u, ((dimensions >> level) + BRICK_SIZE - 1) / BRICK_SIZE);
+        count += side * side * side;
+    }
+    return count;
+}
+
+void BrickPool::markOccupiedBricks(const VoxelGrid& grid, unsigned int level)
+{
+    int side = pageTableSides[level];
+    int dimensions = int(levelDimensions[level]);
+
+    Parallel::forRange(0, side, [&](size_t zBegin, size_t zEnd)
+    {
+        for(int bz = int(zBegin); bz < int(zEnd); ++bz)
+        for(int by = 0; by < side; ++by)
+        for(int bx = 0; bx < side; ++bx)
+        {
+            //the apron counts, a brick next to an occupied one still filters its neighbour's texels in
+            glm::ivec3 brick(bx, by, bz);
+            glm::ivec3 begin = brick * BRICK_SIZE;
+            glm::ivec3 end = glm::min(brick * BRICK_SIZE + BRICK_SIZE + APRON, glm::ivec3(dimensions));
+
+            bool occupied = false;
+            for(int z = begin.z; z < end.z && !occupied; ++z)
+            for(int y = begin.y; y < end.y && !occupied; ++y)
+            for(int x = begin.x; x < end.x; ++x)
+            {
+                size_t index = grid.index(x, y, z);
+                if(grid.albedo[index] != glm::vec4(0.0f) || grid.normal[index] != glm::vec4(0.0f))
+                {
+                    occupied = true;
+                    break;
+                }
+            }
+            pageTable[pageIndex(level, brick)] = occupied ? 0 : EMPTY_BRICK;
+        }
+    });
+}
+
+void BrickPool::copyBricks(const VoxelGrid& grid, unsigned int level)
+{
+    int side = pageTableSides[level];
+    int last = int(levelDimensions[level]) - 1;
+
+    Parallel::forRange(0, side, [&](size_t zBegin, size_t zEnd)
+    {
+        for(int bz = int(zBegin); bz < int(zEnd); ++bz)
+        for(int by = 0; by < side; ++by)
+        for(int bx = 0; bx < side; ++bx)
+        {
+            glm::ivec3 brick(bx, by, bz);
+            int slot = pageTable[pageIndex(level, brick)];
+            if(slot == EMPTY_BRICK) continue;
+
+            glm::ivec3 origin = slotOrigin(slot);
+            glm::ivec3 first = brick * BRICK_SIZE;
+            for(int z = 0; z < STORED_BRICK_SIZE; ++z)
+            for(int y = 0; y < STORED_BRICK_SIZE; ++y)
+            for(int x = 0; x < STORED_BRICK_SIZE; ++x)
+            {
+                //only levels smaller than a brick read past their edge, and those texels are never sampled
+                glm::ivec3 voxel = glm::clamp(first + glm::ivec3(x, y, z), glm::ivec3(0), glm::ivec3(last));
+                size_t source = grid.index(voxel.x, voxel.y, voxel.z);
+                size_t destination = atlasIndex(origin + glm::ivec3(x, y, z));
+                albedoAtlas[destination] = grid.albedo[source];
+                normalAtlas[destination] = grid.normal[source];
+            }
+        }
+    });
+}
+
+bool BrickPool::build(const VoxelGrid& base, const std::vector<VoxelGrid>& mips)
+{
+    assert(base.getDimensions() == levelDimensions[0]);
+    assert(mips.size() + 1 >= levelDimensions.size());
+
+    std::vector<const VoxelGrid*> grids(1, &base);
+    for(size_t level = 1; level < levelDimensions.size(); ++level)
+    {
+        grids.push_back(&mips[level - 1]);
+    }
+
+    for(unsigned int level = 0; level < grids.size(); ++level)
+    {
+        markOccupiedBricks(*grids[level], level);
+    }
+
+    //slots are handed out serially so the same volume always lands in the same place in the atlas
+    size_t requested = 0;
+    allocatedBricks = 0;
+    for(int& entry : pageTable)
+    {
+        if(entry == EMPTY_BRICK) continue;
+        ++requested;
+        entry = allocatedBricks < brickCapacity ? int(allocatedBricks++) : EMPTY_BRICK;
+    }
+
+    //the CPU copy of the atlas only grows as far as the last layer of bricks in use
+    size_t bricksPerLayer = size_t(atlasBricks.x) * atlasBricks.y;
+    size_t layers = (allocatedBricks + bricksPerLayer - 1) / bricksPerLayer;
+    size_t texels = bricksPerLayer * layers * STORED_BRICK_SIZE * STORED_BRICK_SIZE * STORED_BRICK_SIZE;
+    albedoAtlas.resize(texels);
+    normalAtlas.resize(texels);
+
+    for(unsigned int level = 0; level < grids.size(); ++level)
+    {
+        copyBricks(*grids[level], level);
+    }
+
+    if(requested > allocatedBricks)
+    {
+        std::cerr << "brick pool is full: " << requested << " bricks occupied, room for " << brickCapacity << std::endl;
+        return false;
+    }
+    return true;
+}
+
+glm::vec4 BrickPool::fetch(const std::vector<glm::vec4>& atlas, unsigned int level, glm::ivec3 voxel) const
+{
+    glm::ivec3 brick = voxel / BRICK_SIZE;
+    int slot = pageTable[pageIndex(level, brick)];
+    if(slot == EMPTY_BRICK) return glm::vec4(0.0f);
+
+    return atlas[atlasIndex(slotOrigin(slot) + voxel - brick * BRICK_SIZE)];
+}
+
+bool BrickPool::lookup(unsigned int level, glm::ivec3 voxel, glm::vec4& albedo, glm::vec4& normal) const
+{
+    assert(level < levelDimensions.size());
+    assert(glm::all(glm::greaterThanEqual(voxel, glm::ivec3(0))) && glm::all(glm::lessThan(voxel, glm::ivec3(levelDimensions[level]))));
+
+    if(pageTable[pageIndex(level, voxel / BRICK_SIZE)] == EMPTY_BRICK)
+    {
+        albedo = normal = glm::vec4(0.0f);
+        return false;
+    }
+    albedo = fetch(albedoAtlas, level, voxel);
+    normal = fetch(normalAtlas, level, voxel);
+    return true;
+}
+
+glm::vec4 BrickPool::sampleAtlas(const std::vector<glm::vec4>& atlas, unsigned int level, glm::vec3 uvw) const
+{
+    //mirrors sampleBrickPool() in the shaders.  Keeping the position half a texel away from the borders is what clamp
+    //to edge does, after that the brick holding the first of the two texels filtered along each axis has the second
+    //one in its apron
+    float dimensions = float(levelDimensions[level]);
+    glm::vec3 voxel = glm::clamp(uvw * dimensions, 0.5f, dimensions - 0.5f);
+    glm::ivec3 brick = glm::ivec3(glm::floor((voxel - 0.5f) / float(BRICK_SIZE)));
+    int slot = pageTable[pageIndex(level, brick)];
+    if(slot == EMPTY_BRICK) return glm::vec4(0.0f);
+
+    glm::vec3 local = voxel - glm::vec3(brick * BRICK_SIZE) - 0.5f;
+    glm::ivec3 first = glm::ivec3(glm::floor(local));
+    glm::vec3 weight = local - glm::vec3(first);
+    glm::ivec3 origin = slotOrigin(slot);
+
+    glm::vec4 result(0.0f);
+    for(int i = 0; i < 8; ++i)
+    {
+        glm::ivec3 corner((i & 1), (i & 2) >> 1, (i & 4) >> 2);
+        glm::ivec3 texel = glm::clamp(first + corner, glm::ivec3(0), glm::ivec3(STORED_BRICK_SIZE - 1));
+        glm::vec3 w = glm::mix(1.0f - weight, weight, glm::vec3(corner));
+        result += atlas[atlasIndex(origin + texel)] * (w.x * w.y * w.z);
+    }
+    return result;
+}
+
+void BrickPool::sample(unsigned int level, glm::vec3 uvw, glm::vec4& albedo, glm::vec4& normal) const
+{
+    assert(level < levelDimensions.size());
+    albedo = sampleAtlas(albedoAtlas, level, uvw);
+    normal = sampleAtlas(normalAtlas, level, uvw);
+}
+
+size_t BrickPool::getUsedMemory() const
+{
+    size_t brickBytes = size_t(STORED_BRICK_SIZE) * STORED_BRICK_SIZE * STORED_BRICK_SIZE * sizeof(glm::vec4);
+    return pageTable.size() * sizeof(glm::vec4) + allocatedBricks * brickBytes * 2;
+}
+
+size_t BrickPool::getReservedMemory() const
+{
+    glm::ivec3 size = atlasBricks * STORED_BRICK_SIZE;
+    return pageTable.size() * sizeof(glm::vec4) + size_t(size.x) * size.y * size.z * sizeof(glm::vec4) * 2;
+}
+
+void BrickPool::createTextures()
+{
+    glm::ivec3 atlasSize = atlasBricks * STORED_BRICK_SIZE;
+    glm::ivec3 sizes[3] = { glm::ivec3(pageTableWidth, pageTableHeight, pageTableHeight), atlasSize, atlasSize };
+    std::shared_ptr<Texture3D>* textures[3] = { &pageTableTexture, &albedoAtlasTexture, &normalAtlasTexture };
+
+    for(int i = 0; i < 3; ++i)
+    {
+        std::shared_ptr<Texture3D> texture = std::make_shared<Texture3D>();
+        texture->SetWidth(sizes[i].x);
+        texture->SetHeight(sizes[i].y);
+        texture->SetDepth(sizes[i].z);
+        texture->SetWrap(GL_CLAMP_TO_EDGE);
+        //page table entries are fetched with texelFetch, the atlas is filtered like the dense textures were
+        texture->SetMinFilter(i == 0 ? GL_NEAREST : GL_LINEAR);
+        texture->SetMagFilter(i == 0 ? GL_NEAREST : GL_LINEAR);
+        texture->SetPixelFormat(GL_RGBA);
+        texture->SetDataType(GL_FLOAT);
+        texture->SetInternalFormat(GL_RGBA32F);
+        texture->SaveTextureState();
+        *textures[i] = texture;
+    }
+}
+
+void BrickPool::upload()
+{
+    if(pageTableTexture == nullptr)
+    {
+        createTextures();
+    }
+
+    //xyz: where the brick starts in the atlas, in texels.  w: 1 if the brick is stored
+    std::vector<glm::vec4> entries(pageTable.size(), glm::vec4(0.0f));
+    for(size_t i = 0; i < pageTable.size(); ++i)
+    {
+        if(pageTable[i] != EMPTY_BRICK)
+        {
+            entries[i] = glm::vec4(glm::vec3(slotOrigin(pageTable[i])), 1.0f);
+        }
+    }
+
+    {
+        Texture3D::Commands commands(pageTableTexture.get());
+        commands.uploadData(&entries[0]);
+    }
+
+    if(albedoAtlas.empty()) return;
+
+    glm::ivec3 atlasSize = atlasBricks * STORED_BRICK_SIZE;
+    glm::ivec3 usedSize(atlasSize.x, atlasSize.y, int(albedoAtlas.size() / (size_t(atlasSize.x) * atlasSize.y)));
+    {
+        Texture3D::Commands commands(albedoAtlasTexture.get());
+        commands.uploadRegion(&albedoAtlas[0], glm::ivec3(0), usedSize);
+    }
+    {
+        Texture3D::Commands commands(normalAtlasTexture.get());
+        commands.uploadRegion(&normalAtlas[0], glm::ivec3(0), usedSize);
+    }
+}
+
+void BrickPool::reportMemory()
+{
+    for(unsigned int dimensions : {64u, 128u, 256u})
+    {
+        VoxelGrid base(dimensions);
+        int low = int(dimensions) / 8;
+        int high = int(dimensions) - low - 1;
+        glm::vec3 center(float(dimensions) * 0.5f);
+        float radius = float(dimensions) / 6.0f;
+
+        for(int z = 0; z < int(dimensions); ++z)
+        for(int y = 0; y < int(dimensions); ++y)
+        for(int x = 0; x < int(dimensions); ++x)
+        {
+            bool inside = x >= low && x <= high && y >= low && y <= high && z >= low;
+            bool wall = inside && (x == low || x == high || y == low || y == high || z == low);
+            float distance = glm::length(glm::vec3(x, y, z) + 0.5f - center);
+            bool sphere = std::abs(distance - radius) < 0.5f;
+            if(!wall && !sphere) continue;
+
+            size_t index = base.index(x, y, z);
+            base.albedo[index] = glm::vec4(0.7f, 0.6f, 0.5f, 1.0f);
+            base.normal[index] = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
+        }
+
+        std::vector<VoxelGrid> mips;
+        MipChainBuilder::build(base, mips);
+
+        unsigned int levels = (unsigned int)mips.size() + 1;
+        BrickPool pool(dimensions, levels, denseBrickCount(dimensions, levels));
+        pool.build(base, mips);
+
+        size_t denseBytes = 0;
+        for(unsigned int level = 0; level < levels; ++level)
+        {
+            size_t side = std::max(1u, dimensions >> level);
+            denseBytes += side * side * side * sizeof(glm::vec4) * 2;
+        }
+
+        size_t occupied = base.occupiedVoxels();
+        std::cout << "brick pool " << dimensions << "^3: " << occupied << " occupied voxels, " << pool.getAllocatedBricks()
+                  << " of " << denseBrickCount(dimensions, levels) << " bricks, dense " << denseBytes / (1024.0 * 1024.0)
+                  << " MB (" << double(denseBytes) / occupied << " bytes/voxel), pool " << pool.getUsedMemory() / (1024.0 * 1024.0)
+                  << " MB (" << double(pool.getUsedMemory()) / occupied << " bytes/voxel)" << std::endl;
+    }
+}
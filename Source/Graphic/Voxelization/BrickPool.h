@@ -0,0 +1,110 @@
+//
+//  BrickPool.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "glm/glm.hpp"
+#include "VoxelGrid.h"
+
+class Texture3D;
+
+/// <summary> Sparse storage for the voxel mip pyramid.  Every level is cut in 8x8x8 bricks and only bricks that hold
+/// something are copied into a fixed capacity atlas, the rest cost one page table entry.  Each brick also stores the
+/// first layer of texels of its +x, +y and +z neighbours, so hardware trilinear filtering inside the atlas gives the
+/// same answer as filtering the dense texture (clamp to edge).  The page tables of all levels are packed side by side along x in one
+/// texture, which keeps the cone tracer at three samplers instead of two per level. </summary>
+class BrickPool
+{
+public:
+    static const int BRICK_SIZE = 8;
+    static const int APRON = 1;
+    static const int STORED_BRICK_SIZE = BRICK_SIZE + APRON;
+    static const int EMPTY_BRICK = -1;
+
+    /// <summary> levels counts the base level, dimensions is the base level's size. </summary>
+    BrickPool(unsigned int dimensions, unsigned int levels, unsigned int brickCapacity);
+    ~BrickPool();
+
+    /// <summary> Rebuilds the pool from a base grid and its mips (as filled by MipChainBuilder).  Returns false if
+    /// there were more occupied bricks than capacity, the ones that didn't fit read back as empty. </summary>
+    bool build(const VoxelGrid& base, const std::vector<VoxelGrid>& mips);
+
+    /// <summary> Fetches a single texel, returns false if it lives in an empty brick. </summary>
+    bool lookup(unsigned int level, glm::ivec3 voxel, glm::vec4& albedo, glm::vec4& normal) const;
+
+    /// <summary> Trilinear sample at uvw in [0, 1], the same math the shaders do through the atlas. </summary>
+    void sample(unsigned int level, glm::vec3 uvw, glm::vec4& albedo, glm::vec4& normal) const;
+
+    /// <summary> Sends the page table and the used part of the atlas to the GPU, textures are created on first use. </summary>
+    void upload();
+
+    inline Texture3D* getPageTableTexture() const { return pageTableTexture.get(); }
+    inline Texture3D* getAlbedoAtlasTexture() const { return albedoAtlasTexture.get(); }
+    inline Texture3D* getNormalAtlasTexture() const { return normalAtlasTexture.get(); }
+
+    inline unsigned int getLevelCount() const { return (unsigned int)levelDimensions.size(); }
+    inline unsigned int getLevelDimensions(unsigned int level) const { return levelDimensions[level]; }
+    inline unsigned int getPageTableOffset(unsigned int level) const { return pageTableOffsets[level]; }
+    inline glm::vec3 getAtlasSize() const { return glm::vec3(atlasBricks * STORED_BRICK_SIZE); }
+
+    inline size_t getAllocatedBricks() const { return allocatedBricks; }
+    inline size_t getBrickCapacity() const { return brickCapacity; }
+
+    /// <summary> Bytes the page table and the allocated bricks take, for both albedo and normal. </summary>
+    size_t getUsedMemory() const;
+
+    /// <summary> Bytes the page table and the whole atlas take on the GPU. </summary>
+    size_t getReservedMemory() const;
+
+    /// <summary> Number of bricks a fully occupied pyramid would need, the most a pool could ever hold. </summary>
+    static unsigned int denseBrickCount(unsigned int dimensions, unsigned int levels);
+
+    /// <summary> Builds a Cornell box like volume (five walls and a sphere) at 64, 128 and 256 voxels per side and prints
+    /// bytes per occupied voxel for the dense textures and for the pool. </summary>
+    static void reportMemory();
+
+private:
+    inline int pageIndex(unsigned int level, glm::ivec3 brick) const
+    {
+        return int(pageTableOffsets[level]) + brick.x + pageTableWidth * (brick.y + pageTableHeight * brick.z);
+    }
+    inline glm::ivec3 slotOrigin(int slot) const
+    {
+        return glm::ivec3(slot % atlasBricks.x, (slot / atlasBricks.x) % atlasBricks.y, slot / (atlasBricks.x * atlasBricks.y)) * STORED_BRICK_SIZE;
+    }
+    inline size_t atlasIndex(glm::ivec3 texel) const
+    {
+        glm::ivec3 size = atlasBricks * STORED_BRICK_SIZE;
+        return size_t(texel.x) + size_t(size.x) * (size_t(texel.y) + size_t(size.y) * size_t(texel.z));
+    }
+
+    void markOccupiedBricks(const VoxelGrid& grid, unsigned int level);
+    void copyBricks(const VoxelGrid& grid, unsigned int level);
+    glm::vec4 fetch(const std::vector<glm::vec4>& atlas, unsigned int level, glm::ivec3 voxel) const;
+    glm::vec4 sampleAtlas(const std::vector<glm::vec4>& atlas, unsigned int level, glm::vec3 uvw) const;
+    void createTextures();
+
+private:
+    std::vector<unsigned int> levelDimensions;
+    std::vector<int> pageTableSides;
+    std::vector<unsigned int> pageTableOffsets;
+    int pageTableWidth = 0;
+    int pageTableHeight = 0;
+
+    //slot in the atlas of every brick of every level, or EMPTY_BRICK
+    std::vector<int> pageTable;
+
+    unsigned int brickCapacity = 0;
+    size_t allocatedBricks = 0;
+    glm::ivec3 atlasBricks;
+    std::vector<glm::vec4> albedoAtlas;
+    std::vector<glm::vec4> normalAtlas;
+
+    std::shared_ptr<Texture3D> pageTableTexture;
+    std::shared_ptr<Texture3D> albedoAtlasTexture;
+    std::shared_ptr<Texture3D> normalAtlasTexture;
+};
@@ -0,0 +1,325 @@
+//
+//  CPUVoxelizer.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "CPUVoxelizer.h"
+#include "Scene/Scene.h"
+#include "Shape/Shape.h"
+#include "Shape/Mesh.h"
+#include "Utility/Simd.h"
+#include "Utility/Parallel.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+#include <algorithm>
+#include <limits>
+#include <assert.h>
+
+const float CPUVoxelizer::DIST_FACTOR = 1.1f;
+
+CPUVoxelizer::CPUVoxelizer(unsigned int _dimensions, const glm::mat4& voxViewProjection):
+dimensions(_dimensions)
+{
+    setVoxViewProjection(voxViewProjection);
+}
+
+void CPUVoxelizer::setVoxViewProjection(const glm::mat4& voxViewProjection)
+{
+    gridFromWorld = VoxelGrid::gridFromWorld(voxViewProjection, dimensions);
+    worldFromGrid = glm::inverse(gridFromWorld);
+}
+
+void CPUVoxelizer::gatherTriangles(Scene& scene)
+{
+    struct MeshRange
+    {
+        const Mesh* mesh;
+        glm::mat4 gridFromModel;
+        glm::mat3 normalMatrix;
+        glm::vec3 diffuseColor;
+        size_t firstTriangle;
+    };
+
+    std::vector<MeshRange> ranges;
+    size_t totalTriangles = 0;
+    for(Shape* shape : scene.shapes)
+    {
+        if(!shape->active) continue;
+
+        const glm::mat4& model = shape->transform.getTransformMatrix();
+        size_t numberOfProperties = shape->getMeshProperties().size();
+        size_t i = 0;
+        for(Mesh* mesh : shape->meshes)
+        {
+            MeshRange range;
+            range.mesh = mesh;
+            range.gridFromModel = gridFromWorld * model;
+            range.normalMatrix = glm::inverseTranspose(glm::mat3(model));
+            range.diffuseColor = i < numberOfProperties ? shape->getMeshProperties()[i].diffuseColor : shape->defaultVoxProperties.diffuseColor;
+            range.firstTriangle = totalTriangles;
+            ++i;
+
+            if(!mesh->enabled) continue;
+
+            ranges.push_back(range);
+            totalTriangles += mesh->getIndices().size() / 3;
+        }
+    }
+
+    triangles.resize(totalTriangles);
+
+    //transforming and binning is independent per triangle
+    Parallel::forRange(0, totalTriangles, [&](size_t begin, size_t end)
+    {
+        size_t r = std::upper_bound(ranges.begin(), ranges.end(), begin, [](size_t value, const MeshRange& range)
+                                    { return value < range.firstTriangle; }) - ranges.begin() - 1;
+
+        for(size_t t = begin; t < end; ++t)
+        {
+            while(r + 1 < ranges.size() && ranges[r + 1].firstTriangle <= t) ++r;
+
+            const MeshRange& range = ranges[r];
+            const std::vector<VertexData>& vertexData = range.mesh->getVertexData();
+            const std::vector<unsigned int>& indices = range.mesh->getIndices();
+            size_t first = (t - range.firstTriangle) * 3;
+
+            Triangle& triangle = triangles[t];
+            glm::vec3 minCorner(std::numeric_limits<float>::max());
+            glm::vec3 maxCorner(-std::numeric_limits<float>::max());
+            for(int v = 0; v < 3; ++v)
+            {
+                const VertexData& vertex = vertexData[indices[first + v]];
+                triangle.vertices[v] = glm::vec3(range.gridFromModel * glm::vec4(vertex.position, 1.0f));
+                triangle.normals[v] = range.normalMatrix * vertex.normal;
+                minCorner = glm::min(minCorner, triangle.vertices[v]);
+                maxCorner = glm::max(maxCorner, triangle.vertices[v]);
+            }
+            triangle.diffuseColor = range.diffuseColor;
+
+            glm::vec3 faceNormal = glm::cross(triangle.vertices[1] - triangle.vertices[0], triangle.vertices[2] - triangle.vertices[0]);
+
+            //min > max marks the triangle as culled, either degenerate or outside of what's being voxelized
+            triangle.minVoxel = glm::max(glm::ivec3(glm::floor(minCorner)), bounds.begin);
+            triangle.maxVoxel = glm::min(glm::ivec3(glm::floor(maxCorner)), bounds.end - 1);
+            if(glm::dot(faceNormal, faceNormal) == 0.0f)
+            {
+                triangle.minVoxel = glm::ivec3(1);
+                triangle.maxVoxel = glm::ivec3(0);
+            }
+        }
+    });
+}
+
+int CPUVoxelizer::overlapFourVoxels(const Triangle& triangle, float firstCenterX, float centerY, float centerZ)
+{
+    using namespace Simd;
+
+    const float HALF = 0.5f;
+
+    //translate the triangle so that each lane's voxel sits at the origin, only x differs between lanes
+    float4 centerX = add(set1(firstCenterX), set(0.0f, 1.0f, 2.0f, 3.0f));
+    float4 vx[3], vy[3], vz[3];
+    for(int i = 0; i < 3; ++i)
+    {
+        vx[i] = sub(set1(triangle.vertices[i].x), centerX);
+        vy[i] = set1(triangle.vertices[i].y - centerY);
+        vz[i] = set1(triangle.vertices[i].z - centerZ);
+    }
+
+    float4 separated = set1(0.0f);
+    auto testAxis = [&separated](float4 p0, float4 p1, float4 p2, float radius)
+    {
+        float4 minimum = min(p0, min(p1, p2));
+        float4 maximum = max(p0, max(p1, p2));
+        separated = maskOr(separated, maskOr(greaterThan(minimum, set1(radius)), lessThan(maximum, set1(-radius))));
+    };
+
+    //the three box normals
+    testAxis(vx[0], vx[1], vx[2], HALF);
+    testAxis(vy[0], vy[1], vy[2], HALF);
+    testAxis(vz[0], vz[1], vz[2], HALF);
+
+    //the nine cross products between box normals and triangle edges
+    glm::vec3 edges[3] = { triangle.vertices[1] - triangle.vertices[0],
+                           triangle.vertices[2] - triangle.vertices[1],
+                           triangle.vertices[0] - triangle.vertices[2] };
+    for(const glm::vec3& e : edges)
+    {
+        float4 ex = set1(e.x), ey = set1(e.y), ez = set1(e.z);
+        float4 p[3];
+
+        //x cross edge = (0, -e.z, e.y)
+        for(int i = 0; i < 3; ++i) p[i] = sub(mul(ey, vz[i]), mul(ez, vy[i]));
+        testAxis(p[0], p[1], p[2], HALF * (std::fabs(e.z) + std::fabs(e.y)));
+
+        //y cross edge = (e.z, 0, -e.x)
+        for(int i = 0; i < 3; ++i) p[i] = sub(mul(ez, vx[i]), mul(ex, vz[i]));
+        testAxis(p[0], p[1], p[2], HALF * (std::fabs(e.z) + std::fabs(e.x)));
+
+        //z cross edge = (-e.y, e.x, 0)
+        for(int i = 0; i < 3; ++i) p[i] = sub(mul(ex, vy[i]), mul(ey, vx[i]));
+        testAxis(p[0], p[1], p[2], HALF * (std::fabs(e.y) + std::fabs(e.x)));
+    }
+
+    //the triangle's plane
+    glm::vec3 n = glm::cross(edges[0], edges[1]);
+    float4 distance = madd(set1(n.x), vx[0], madd(set1(n.y), vy[0], mul(set1(n.z), vz[0])));
+    float radius = HALF * (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+    separated = maskOr(separated, greaterThan(abs(distance), set1(radius)));
+
+    return ~laneBits(separated) & 0xF;
+}
+
+void CPUVoxelizer::shadeVoxel(Scene& scene, const Triangle& triangle, int x, int y, int z)
+{
+    glm::vec3 center = glm::vec3(x, y, z) + glm::vec3(0.5f);
+
+    //barycentric coordinates of the voxel center projected on the triangle, clamped so that voxels hanging past an
+    //edge take the normal of the closest vertex instead of extrapolating
+    glm::vec3 e0 = triangle.vertices[1] - triangle.vertices[0];
+    glm::vec3 e1 = triangle.vertices[2] - triangle.vertices[0];
+    glm::vec3 e2 = center - triangle.vertices[0];
+    float d00 = glm::dot(e0, e0), d01 = glm::dot(e0, e1), d11 = glm::dot(e1, e1);
+    float d20 = glm::dot(e2, e0), d21 = glm::dot(e2, e1);
+    float denominator = d00 * d11 - d01 * d01;
+    glm::vec3 barycentric(1.0f / 3.0f);
+    if(denominator != 0.0f)
+    {
+        float v = (d11 * d20 - d01 * d21) / denominator;
+        float w = (d00 * d21 - d01 * d20) / denominator;
+        barycentric = glm::clamp(glm::vec3(1.0f - v - w, v, w), 0.0f, 1.0f);
+        barycentric /= std::max(barycentric.x + barycentric.y + barycentric.z, 1e-6f);
+    }
+
+    glm::vec3 normal = barycentric.x * triangle.normals[0] + barycentric.y * triangle.normals[1] + barycentric.z * triangle.normals[2];
+    float length = glm::length(normal);
+    normal = length > 0.0f ? normal / length : normal;
+
+    //same math as calculatePointLight() in voxelization.frag
+    glm::vec3 worldPosition = glm::vec3(worldFromGrid * glm::vec4(center, 1.0f));
+    glm::vec3 lightColor(0.0f);
+    size_t maxLights = std::min(scene.pointLights.size(), size_t(MAX_LIGHTS));
+    for(size_t i = 0; i < maxLights; ++i)
+    {
+        const PointLight& light = scene.pointLights[i];
+        glm::vec3 direction = glm::normalize(light.position - worldPosition);
+        float distanceToLight = glm::distance(light.position, worldPosition) * DIST_FACTOR;
+        float attenuation = 1.0f / (1.0f + distanceToLight * distanceToLight);
+        float diffuse = std::max(glm::dot(normal, direction), 0.0f);
+        lightColor += diffuse * attenuation * light.color;
+    }
+
+    size_t index = x + dimensions * (y + size_t(dimensions) * z);
+    albedoSum[index] += glm::vec4(triangle.diffuseColor * lightColor, 1.0f);
+    normalSum[index] += glm::vec4(normal, 0.0f);
+}
+
+void CPUVoxelizer::rasterizeSlab(Scene& scene, int zBegin, int zEnd)
+{
+    for(const Triangle& triangle : triangles)
+    {
+        glm::ivec3 minVoxel = glm::max(triangle.minVoxel, glm::ivec3(region.begin.x, region.begin.y, zBegin));
+        glm::ivec3 maxVoxel = glm::min(triangle.maxVoxel, glm::ivec3(region.end.x - 1, region.end.y - 1, zEnd - 1));
+        if(minVoxel.x > maxVoxel.x || minVoxel.y > maxVoxel.y || minVoxel.z > maxVoxel.z) continue;
+
+        for(int z = minVoxel.z; z <= maxVoxel.z; ++z)
+        for(int y = minVoxel.y; y <= maxVoxel.y; ++y)
+        for(int x = minVoxel.x; x <= maxVoxel.x; x += 4)
+        {
+            int lanes = overlapFourVoxels(triangle, float(x) + 0.5f, float(y) + 0.5f, float(z) + 0.5f);
+            for(int lane = 0; lanes != 0; ++lane, lanes >>= 1)
+            {
+                if((lanes & 1) && x + lane <= maxVoxel.x)
+                {
+                    shadeVoxel(scene, triangle, x + lane, y, z);
+                }
+            }
+        }
+    }
+}
+
+void CPUVoxelizer::voxelize(Scene& scene, VoxelGrid& grid)
+{
+    voxelize(scene, grid, VoxelGrid::Region::whole(dimensions));
+}
+
+void CPUVoxelizer::voxelize(Scene& scene, VoxelGrid& grid, const VoxelGrid::Region& _region)
+{
+    voxelize(scene, grid, std::vector<VoxelGrid::Region>(1, _region));
+}
+
+void CPUVoxelizer::voxelize(Scene& scene, VoxelGrid& grid, const std::vector<VoxelGrid::Region>& regions, glm::ivec3 toroidalOffset)
+{
+    if(grid.getDimensions() != dimensions)
+    {
+        grid.resize(dimensions);
+    }
+
+    std::vector<VoxelGrid::Region> clipped;
+    for(const VoxelGrid::Region& r : regions)
+    {
+        VoxelGrid::Region inside(glm::max(r.begin, glm::ivec3(0)), glm::min(r.end, glm::ivec3(int(dimensions))));
+        if(inside.isEmpty()) continue;
+
+        bounds = clipped.empty() ? inside : VoxelGrid::Region(glm::min(bounds.begin, inside.begin), glm::max(bounds.end, inside.end));
+        clipped.push_back(inside);
+    }
+    if(clipped.empty()) return;
+
+    size_t total = grid.size();
+    if(albedoSum.size() != total)
+    {
+        albedoSum.resize(total);
+        normalSum.resize(total);
+    }
+
+    gatherTriangles(scene);
+
+    //wrap the offset into [0, dimensions) once so the per voxel wrap is a single compare
+    int size = int(dimensions);
+    toroidalOffset = ((toroidalOffset % size) + size) % size;
+    for(const VoxelGrid::Region& r : clipped)
+    {
+        region = r;
+        voxelizeRegion(scene, grid, toroidalOffset);
+    }
+}
+
+void CPUVoxelizer::voxelizeRegion(Scene& scene, VoxelGrid& grid, glm::ivec3 toroidalOffset)
+{
+    int size = int(dimensions);
+    auto wrap = [size](int value){ return value >= size ? value - size : value; };
+
+    //every thread owns a slab of layers, so no two threads ever write the same voxel
+    Parallel::forRange(region.begin.z, region.end.z, [&](size_t zBegin, size_t zEnd)
+    {
+        for(size_t z = zBegin; z < zEnd; ++z)
+        for(int y = region.begin.y; y < region.end.y; ++y)
+        {
+            size_t rowStart = grid.index(region.begin.x, y, unsigned(z));
+            std::fill(albedoSum.begin() + rowStart, albedoSum.begin() + rowStart + region.size().x, glm::vec4(0.0f));
+            std::fill(normalSum.begin() + rowStart, normalSum.begin() + rowStart + region.size().x, glm::vec4(0.0f));
+        }
+
+        rasterizeSlab(scene, int(zBegin), int(zEnd));
+
+        for(size_t z = zBegin; z < zEnd; ++z)
+        for(int y = region.begin.y; y < region.end.y; ++y)
+        for(int x = region.begin.x; x < region.end.x; ++x)
+        {
+            size_t i = grid.index(x, y, unsigned(z));
+            size_t stored = grid.index(wrap(x + toroidalOffset.x), wrap(y + toroidalOffset.y), wrap(int(z) + toroidalOffset.z));
+            float hits = albedoSum[i].w;
+            if(hits > 0.0f)
+            {
+                grid.albedo[stored] = glm::vec4(glm::vec3(albedoSum[i]) / hits, 1.0f);
+                grid.normal[stored] = glm::vec4(glm::vec3(normalSum[i]) / hits, 1.0f);
+            }
+            else
+            {
+                grid.albedo[stored] = glm::vec4(0.0f);
+                grid.normal[stored] = glm::vec4(0.0f);
+            }
+        }
+    });
+}
@@ -0,0 +1,73 @@
+//
+//  CPUVoxelizer.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "VoxelGrid.h"
+
+class Scene;
+
+/// <summary> Reference voxelizer that runs entirely on the CPU and doesn't need a GL context.  Every triangle is tested
+/// against every voxel its bounding box touches with a separating axis test (Akenine-Moller), four voxels at a time.
+/// Unlike the depth peeling path it catches every surface, no matter how many layers deep it is, so its output can be
+/// used as ground truth for VoxelizeRT. </summary>
+class CPUVoxelizer
+{
+public:
+
+    /// <summary> voxViewProjection maps world space to the voxel volume the same way it does for the GPU path. </summary>
+    CPUVoxelizer(unsigned int dimensions, const glm::mat4& voxViewProjection);
+
+    /// <summary> Voxelizes every active shape in the scene into grid, lighting voxels like voxelization.frag does. </summary>
+    void voxelize(Scene& scene, VoxelGrid& grid);
+
+    /// <summary> Only clears and rebuilds the voxels inside region, the rest of grid is left as is. </summary>
+    void voxelize(Scene& scene, VoxelGrid& grid, const VoxelGrid::Region& region);
+
+    /// <summary> Rebuilds every region, gathering the scene's triangles once.  Regions are in voxelization space, voxel v
+    /// is stored at (v + toroidalOffset) mod dimensions so a scrolling volume never has to move its contents. </summary>
+    void voxelize(Scene& scene, VoxelGrid& grid, const std::vector<VoxelGrid::Region>& regions, glm::ivec3 toroidalOffset = glm::ivec3(0));
+
+    /// <summary> Moves the volume, takes effect on the next voxelize() call. </summary>
+    void setVoxViewProjection(const glm::mat4& voxViewProjection);
+
+    inline size_t getTriangleCount() const { return triangles.size(); }
+
+    //mirrors the lighting constants in voxelization.frag
+    static const unsigned int MAX_LIGHTS = 1;
+    static const float DIST_FACTOR;
+
+private:
+    struct Triangle
+    {
+        glm::vec3 vertices[3];      //voxel grid space
+        glm::vec3 normals[3];       //world space
+        glm::vec3 diffuseColor;
+        glm::ivec3 minVoxel;
+        glm::ivec3 maxVoxel;
+    };
+
+    void gatherTriangles(Scene& scene);
+    void rasterizeSlab(Scene& scene, int zBegin, int zEnd);
+    void voxelizeRegion(Scene& scene, VoxelGrid& grid, glm::ivec3 toroidalOffset);
+    void shadeVoxel(Scene& scene, const Triangle& triangle, int x, int y, int z);
+
+    static int overlapFourVoxels(const Triangle& triangle, float firstCenterX, float centerY, float centerZ);
+
+private:
+    unsigned int dimensions;
+    glm::mat4 gridFromWorld;
+    glm::mat4 worldFromGrid;
+
+    std::vector<Triangle> triangles;
+    VoxelGrid::Region bounds;       //everything being voxelized, triangles are clipped to it
+    VoxelGrid::Region region;       //the part being rasterized right now
+
+    //xyz hold the running sums, w the number of triangles that touched the voxel
+    std::vector<glm::vec4> albedoSum;
+    std::vector<glm::vec4> normalSum;
+};
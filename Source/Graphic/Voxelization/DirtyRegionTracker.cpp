@@ -0,0 +1,84 @@
+//
+//  DirtyRegionTracker.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "DirtyRegionTracker.h"
+#include "Scene/Scene.h"
+#include "Shape/Shape.h"
+#include <limits>
+
+void DirtyRegionTracker::addBox(const glm::vec3& minCorner, const glm::vec3& maxCorner)
+{
+    if(!dirty)
+    {
+        regionMin = minCorner;
+        regionMax = maxCorner;
+        dirty = true;
+        return;
+    }
+    regionMin = glm::min(regionMin, minCorner);
+    regionMax = glm::max(regionMax, maxCorner);
+}
+
+bool DirtyRegionTracker::update(Scene& scene)
+{
+    if(fullVolume)
+    {
+        return dirty;
+    }
+
+    if(scene.pointLightsChanged() || scene.shapes != cleanShapes)
+    {
+        invalidateAll();
+        return dirty;
+    }
+
+    for(Shape* shape : scene.shapes)
+    {
+        if(shape->getDirtyFlags() == Shape::CLEAN) continue;
+
+        glm::vec3 minCorner, maxCorner;
+        shape->getCleanWorldBounds(minCorner, maxCorner);
+        addBox(minCorner, maxCorner);
+
+        shape->getWorldBounds(minCorner, maxCorner);
+        addBox(minCorner, maxCorner);
+    }
+
+    return dirty;
+}
+
+void DirtyRegionTracker::clear(Scene& scene)
+{
+    for(Shape* shape : scene.shapes)
+    {
+        shape->clearDirtyFlags();
+    }
+    scene.clearPointLightsChanged();
+    cleanShapes = scene.shapes;
+
+    dirty = fullVolume = false;
+}
+
+VoxelGrid::Region DirtyRegionTracker::getVoxelRegion(const glm::mat4& gridFromWorld, unsigned int dimensions) const
+{
+    if(!dirty) return VoxelGrid::Region();
+    if(fullVolume) return VoxelGrid::Region::whole(dimensions);
+
+    glm::vec3 minVoxel(std::numeric_limits<float>::max());
+    glm::vec3 maxVoxel(-std::numeric_limits<float>::max());
+    for(int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner((i & 1) ? regionMax.x : regionMin.x,
+                         (i & 2) ? regionMax.y : regionMin.y,
+                         (i & 4) ? regionMax.z : regionMin.z);
+        glm::vec3 voxel = glm::vec3(gridFromWorld * glm::vec4(corner, 1.0f));
+        minVoxel = glm::min(minVoxel, voxel);
+        maxVoxel = glm::max(maxVoxel, voxel);
+    }
+
+    glm::ivec3 begin = glm::max(glm::ivec3(glm::floor(minVoxel)) - 1, glm::ivec3(0));
+    glm::ivec3 end = glm::min(glm::ivec3(glm::floor(maxVoxel)) + 2, glm::ivec3(int(dimensions)));
+    return VoxelGrid::Region(begin, end);
+}
@@ -0,0 +1,48 @@
+//
+//  DirtyRegionTracker.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "VoxelGrid.h"
+
+class Scene;
+class Shape;
+
+/// <summary> Decides whether the voxel volume is out of date and which part of it.  Moving, toggling or re-coloring a
+/// shape dirties the world space box it occupied at the last voxelization plus the one it occupies now.  Lighting is
+/// baked into the voxels, so a light change, or shapes being added or removed, dirties the whole volume. </summary>
+class DirtyRegionTracker
+{
+public:
+    /// <summary> Gathers changes since the last clear() call, returns true if anything needs voxelizing. Changes
+    /// accumulate across calls until clear() is called. </summary>
+    bool update(Scene& scene);
+
+    /// <summary> Called once the volume reflects the scene again. </summary>
+    void clear(Scene& scene);
+
+    /// <summary> Forces the next update to report the whole volume as dirty. </summary>
+    inline void invalidateAll(){ dirty = fullVolume = true; }
+
+    inline bool isDirty() const { return dirty; }
+    inline bool isFullVolume() const { return fullVolume; }
+
+    /// <summary> The dirty part of the volume in voxels.  gridFromWorld maps world space to [0, dimensions]. A one voxel
+    /// border is added because voxelization touches voxels that only share a face with a triangle. </summary>
+    VoxelGrid::Region getVoxelRegion(const glm::mat4& gridFromWorld, unsigned int dimensions) const;
+
+private:
+    void addBox(const glm::vec3& minCorner, const glm::vec3& maxCorner);
+
+private:
+    bool dirty = true;
+    bool fullVolume = true;
+    glm::vec3 regionMin = glm::vec3(0.0f);
+    glm::vec3 regionMax = glm::vec3(0.0f);
+
+    std::vector<Shape*> cleanShapes;
+};
@@ -0,0 +1,241 @@
+//
+//  MipChainBuilder.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "MipChainBuilder.h"
+#include "Utility/Simd.h"
+#include "Utility/Parallel.h"
+#include <assert.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+void MipChainBuilder::filterRow(const glm::vec4* row00, const glm::vec4* row10, const glm::vec4* row01, const glm::vec4* row11,
+                                glm::vec4* destination, unsigned int width)
+{
+    //the additions below happen in the same order as getAverage() in downsize.cl, so results match the kernel
+    //bit for bit, not just within tolerance
+    unsigned int x = 0;
+
+#if defined(__AVX__)
+    //two destination texels per iteration, the 2x2 footprint of both is four consecutive source texels per row
+    const float* rows[4] = { &row00[0].x, &row10[0].x, &row01[0].x, &row11[0].x };
+    const __m256 eighth = _mm256_set1_ps(0.125f);
+    for(; x + 2 <= width; x += 2)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for(int r = 0; r < 4; ++r)
+        {
+            __m256 first = _mm256_loadu_ps(rows[r] + x * 8);
+            __m256 second = _mm256_loadu_ps(rows[r] + x * 8 + 8);
+            __m256 even = _mm256_permute2f128_ps(first, second, 0x20);
+            __m256 odd = _mm256_permute2f128_ps(first, second, 0x31);
+            sum = r == 0 ? _mm256_add_ps(even, odd) : _mm256_add_ps(_mm256_add_ps(sum, even), odd);
+        }
+        _mm256_storeu_ps(&destination[x].x, _mm256_mul_ps(sum, eighth));
+    }
+#endif
+
+    using namespace Simd;
+    const float4 eighth4 = set1(0.125f);
+    for(; x < width; ++x)
+    {
+        unsigned int s = x * 2;
+        float4 sum = add(load(&row00[s].x), load(&row00[s + 1].x));
+        sum = add(add(sum, load(&row10[s].x)), load(&row10[s + 1].x));
+        sum = add(add(sum, load(&row01[s].x)), load(&row01[s + 1].x));
+        sum = add(add(sum, load(&row11[s].x)), load(&row11[s + 1].x));
+        store(&destination[x].x, mul(sum, eighth4));
+    }
+}
+
+void MipChainBuilder::filterLayer(const VoxelGrid& source, VoxelGrid& destination, unsigned int z)
+{
+    filterLayer(source, destination, z, VoxelGrid::Region::whole(destination.getDimensions()));
+}
+
+void MipChainBuilder::filterLayer(const VoxelGrid& source, VoxelGrid& destination, unsigned int z, const VoxelGrid::Region& region)
+{
+    unsigned int width = region.size().x;
+    unsigned int x = region.begin.x;
+
+    const std::vector<glm::vec4>* sources[2] = { &source.albedo, &source.normal };
+    std::vector<glm::vec4>* destinations[2] = { &destination.albedo, &destination.normal };
+
+    for(int grid = 0; grid < 2; ++grid)
+    {
+        const glm::vec4* texels = sources[grid]->data();
+        glm::vec4* destinationTexels = destinations[grid]->data();
+        for(unsigned int y = region.begin.y; y < unsigned(region.end.y); ++y)
+        {
+            filterRow(texels + source.index(x * 2, y * 2,     z * 2),
+                      texels + source.index(x * 2, y * 2 + 1, z * 2),
+                      texels + source.index(x * 2, y * 2,     z * 2 + 1),
+                      texels + source.index(x * 2, y * 2 + 1, z * 2 + 1),
+                      destinationTexels + destination.index(x, y, z), width);
+        }
+    }
+}
+
+void MipChainBuilder::buildSlab(const VoxelGrid& base, std::vector<VoxelGrid>& levels, unsigned int zBegin, unsigned int zEnd)
+{
+    //number of levels that still have at least one whole layer inside this slab
+    unsigned int slabLevels = 0;
+    while((2u << slabLevels) <= zEnd - zBegin) ++slabLevels;
+
+    for(unsigned int z = zBegin / 2; z < zEnd / 2; ++z)
+    {
+        filterLayer(base, levels[0], z);
+
+        //every odd layer completes a pair, filter the layer above right away while the pair is still in cache
+        unsigned int layer = z;
+        for(unsigned int level = 1; level < slabLevels && (layer & 1); ++level)
+        {
+            layer >>= 1;
+            filterLayer(levels[level - 1], levels[level], layer);
+        }
+    }
+}
+
+void MipChainBuilder::allocateLevels(const VoxelGrid& base, std::vector<VoxelGrid>& levels)
+{
+    unsigned int dimensions = base.getDimensions();
+    unsigned int levelCount = 0;
+    for(unsigned int d = dimensions >> 1; d; d >>= 1) ++levelCount;
+
+    levels.resize(levelCount);
+    for(unsigned int i = 0; i < levelCount; ++i)
+    {
+        if(levels[i].getDimensions() != (dimensions >> (i + 1)))
+        {
+            levels[i].resize(dimensions >> (i + 1));
+        }
+    }
+}
+
+void MipChainBuilder::build(const VoxelGrid& base, std::vector<VoxelGrid>& levels, VoxelGrid::Region region)
+{
+    bool wholeVolume = region.begin == glm::ivec3(0) && region.end == glm::ivec3(int(base.getDimensions()));
+    if(wholeVolume || levels.size() == 0)
+    {
+        //no previous levels to patch, or nothing to save by patching
+        build(base, levels);
+        return;
+    }
+
+    allocateLevels(base, levels);
+
+    const VoxelGrid* source = &base;
+    for(VoxelGrid& level : levels)
+    {
+        region = region.downsampled();
+        Parallel::forRange(region.begin.z, region.end.z, [&](size_t begin, size_t end)
+        {
+            for(size_t z = begin; z < end; ++z)
+            {
+                filterLayer(*source, level, unsigned(z), region);
+            }
+        });
+        source = &level;
+    }
+}
+
+void MipChainBuilder::build(const VoxelGrid& base, std::vector<VoxelGrid>& levels)
+{
+    unsigned int dimensions = base.getDimensions();
+    assert(dimensions >= 2 && (dimensions & (dimensions - 1)) == 0 && "voxel grids must be a power of two");
+
+    allocateLevels(base, levels);
+    unsigned int levelCount = unsigned(levels.size());
+
+    //slabs are a power of two thick so that every level inside them is made of whole layers
+    unsigned int slabs = 1;
+    while(slabs * 2 <= Parallel::workerCount() && slabs * 2 <= dimensions / 2) slabs *= 2;
+    unsigned int slabThickness = dimensions / slabs;
+
+    Parallel::forRange(0, slabs, [&](size_t begin, size_t end)
+    {
+        for(size_t slab = begin; slab < end; ++slab)
+        {
+            buildSlab(base, levels, unsigned(slab) * slabThickness, unsigned(slab + 1) * slabThickness);
+        }
+    });
+
+    //the top of the pyramid spans several slabs, it's tiny so finish it here
+    unsigned int slabLevels = 0;
+    while((2u << slabLevels) <= slabThickness) ++slabLevels;
+    for(unsigned int level = std::max(slabLevels, 1u); level < levelCount; ++level)
+    {
+        for(unsigned int z = 0; z < levels[level].getDimensions(); ++z)
+        {
+            filterLayer(levels[level - 1], levels[level], z);
+        }
+    }
+}
+
+void MipChainBuilder::benchmark()
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const int ITERATIONS = 5;
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+    for(unsigned int dimensions : {64u, 128u, 256u})
+    {
+        VoxelGrid base(dimensions);
+        for(size_t i = 0; i < base.size(); ++i)
+        {
+            base.albedo[i] = glm::vec4(distribution(generator), distribution(generator), distribution(generator), 1.0f);
+            base.normal[i] = glm::vec4(distribution(generator), distribution(generator), distribution(generator), 1.0f);
+        }
+
+        //level at a time, single threaded, the way the kernel walks the pyramid
+        std::vector<VoxelGrid> reference;
+        for(unsigned int d = dimensions >> 1; d; d >>= 1) reference.push_back(VoxelGrid(d));
+
+        double referenceMs = 0.0;
+        for(int i = 0; i < ITERATIONS; ++i)
+        {
+            Clock::time_point start = Clock::now();
+            const VoxelGrid* current = &base;
+            for(VoxelGrid& level : reference)
+            {
+                current->downsample(level);
+                current = &level;
+            }
+            referenceMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        //first build allocates the levels, keep that out of the timings like it is for the reference
+        std::vector<VoxelGrid> fused;
+        build(base, fused);
+        double fusedMs = 0.0;
+        for(int i = 0; i < ITERATIONS; ++i)
+        {
+            Clock::time_point start = Clock::now();
+            build(base, fused);
+            fusedMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        float maxError = 0.0f;
+        for(size_t level = 0; level < fused.size(); ++level)
+        {
+            for(size_t i = 0; i < fused[level].size(); ++i)
+            {
+                glm::vec4 albedoDelta = glm::abs(fused[level].albedo[i] - reference[level].albedo[i]);
+                glm::vec4 normalDelta = glm::abs(fused[level].normal[i] - reference[level].normal[i]);
+                maxError = std::max(maxError, std::max(std::max(albedoDelta.x, albedoDelta.y), std::max(albedoDelta.z, albedoDelta.w)));
+                maxError = std::max(maxError, std::max(std::max(normalDelta.x, normalDelta.y), std::max(normalDelta.z, normalDelta.w)));
+            }
+        }
+
+        std::cout << "mip chain " << dimensions << "^3: level at a time " << referenceMs / ITERATIONS << " ms, fused "
+                  << fusedMs / ITERATIONS << " ms on " << Parallel::workerCount() << " threads, max error " << maxError << std::endl;
+    }
+}
@@ -0,0 +1,36 @@
+//
+//  MipChainBuilder.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include "VoxelGrid.h"
+
+/// <summary> Builds the albedo/normal mip pyramid of a voxel grid on the CPU, replacing one OpenCL dispatch (and GL
+/// acquire/release) per level with a single pass.  The volume is split in z slabs, one per core, and each slab
+/// streams through its layers: as soon as two layers of a level exist the layer above them is filtered, so the
+/// data a level needs is still in cache when it's read.  Output matches getAverage() in downsize.cl. </summary>
+class MipChainBuilder
+{
+public:
+
+    /// <summary> Fills levels with every mip below base, levels[0] being half of base's dimensions, down to 1x1x1. </summary>
+    static void build(const VoxelGrid& base, std::vector<VoxelGrid>& levels);
+
+    /// <summary> Only refilters the texels of every level that depend on region, given in base voxels. </summary>
+    static void build(const VoxelGrid& base, std::vector<VoxelGrid>& levels, VoxelGrid::Region region);
+
+    /// <summary> Times build() against level at a time filtering (what the OpenCL path does) at 64, 128 and 256
+    /// voxels per side and prints the results. </summary>
+    static void benchmark();
+
+private:
+    static void allocateLevels(const VoxelGrid& base, std::vector<VoxelGrid>& levels);
+    static void filterLayer(const VoxelGrid& source, VoxelGrid& destination, unsigned int z);
+    static void filterLayer(const VoxelGrid& source, VoxelGrid& destination, unsigned int z, const VoxelGrid::Region& region);
+    static void filterRow(const glm::vec4* row00, const glm::vec4* row10, const glm::vec4* row01, const glm::vec4* row11,
+                          glm::vec4* destination, unsigned int width);
+    static void buildSlab(const VoxelGrid& base, std::vector<VoxelGrid>& levels, unsigned int zBegin, unsigned int zEnd);
+};
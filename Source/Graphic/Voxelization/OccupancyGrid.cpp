@@ -0,0 +1,141 @@
+//
+//  OccupancyGrid.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "OccupancyGrid.h"
+#include "Graphic/Material/Texture/Texture3D.h"
+#include "Utility/Parallel.h"
+#include <assert.h>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+const unsigned char OccupancyGrid::OCCUPIED;
+const unsigned char OccupancyGrid::FULL;
+
+OccupancyGrid::OccupancyGrid(unsigned int _dimensions)
+{
+    resize(_dimensions);
+}
+
+void OccupancyGrid::resize(unsigned int _dimensions)
+{
+    assert((_dimensions & (_dimensions - 1)) == 0 && "voxel grids must be a power of two");
+    dimensions = _dimensions;
+    levelCount = 0;
+    for(unsigned int side = dimensions >> 1; side > 0; side >>= 1) ++levelCount;
+    texels.assign(size_t(dimensions) * (dimensions >> 1) * (dimensions >> 1), 0);
+}
+
+void OccupancyGrid::build(const VoxelGrid& base)
+{
+    build(base, VoxelGrid::Region::whole(base.getDimensions()));
+}
+
+void OccupancyGrid::build(const VoxelGrid& base, VoxelGrid::Region region)
+{
+    if(dimensions != base.getDimensions())
+    {
+        resize(base.getDimensions());
+        region = VoxelGrid::Region::whole(dimensions);
+    }
+    if(levelCount == 0) return;
+
+    region = region.downsampled();
+    buildBits(base, region);
+    for(unsigned int level = 2; level <= levelCount; ++level)
+    {
+        region = region.downsampled();
+        buildLevel(level, region);
+    }
+}
+
+void OccupancyGrid::buildBits(const VoxelGrid& base, const VoxelGrid::Region& region)
+{
+    Parallel::forRange(region.begin.z, region.end.z, [&](size_t begin, size_t end)
+    {
+        for(size_t z = begin; z < end; ++z)
+        for(int y = region.begin.y; y < region.end.y; ++y)
+        for(int x = region.begin.x; x < region.end.x; ++x)
+        {
+            glm::ivec3 first = glm::ivec3(x, y, int(z)) * 2;
+            unsigned char bits = 0;
+            for(int bit = 0; bit < 8; ++bit)
+            {
+                glm::ivec3 voxel = first + glm::ivec3(bit & 1, (bit >> 1) & 1, bit >> 2);
+                if(base.albedo[base.index(voxel.x, voxel.y, voxel.z)].w != 0.0f)
+                {
+                    bits |= 1 << bit;
+                }
+            }
+            texels[index(1, glm::ivec3(x, y, int(z)))] = bits;
+        }
+    });
+}
+
+void OccupancyGrid::buildLevel(unsigned int level, const VoxelGrid::Region& region)
+{
+    Parallel::forRange(region.begin.z, region.end.z, [&](size_t begin, size_t end)
+    {
+        for(size_t z = begin; z < end; ++z)
+        for(int y = region.begin.y; y < region.end.y; ++y)
+        for(int x = region.begin.x; x < region.end.x; ++x)
+        {
+            glm::ivec3 first = glm::ivec3(x, y, int(z)) * 2;
+            bool occupied = false, full = true;
+            for(int child = 0; child < 8; ++child)
+            {
+                unsigned char value = texels[index(level - 1, first + glm::ivec3(child & 1, (child >> 1) & 1, child >> 2))];
+                occupied |= value != 0;
+                full &= level - 1 == 1 ? value == 0xFF : (value & FULL) != 0;
+            }
+            texels[index(level, glm::ivec3(x, y, int(z)))] = (occupied ? OCCUPIED : 0) | (full ? FULL : 0);
+        }
+    });
+}
+
+unsigned int OccupancyGrid::skip(const glm::vec3& position, const glm::vec3& direction, float stepLength) const
+{
+    glm::ivec3 voxel = glm::clamp(glm::ivec3(glm::floor(position)), glm::ivec3(0), glm::ivec3(int(dimensions) - 1));
+    if(isOccupied(voxel)) return 0;
+
+    //climb while the coarser cell is empty too
+    unsigned int level = 0;
+    while(level < levelCount && isEmpty(level + 1, voxel)) ++level;
+
+    float size = float(1 << level);
+    glm::vec3 low = glm::vec3(voxel >> int(level)) * size;
+    float distance = std::numeric_limits<float>::max();
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        if(direction[axis] > 0.0f) distance = std::min(distance, (low[axis] + size - position[axis]) / direction[axis]);
+        else if(direction[axis] < 0.0f) distance = std::min(distance, (low[axis] - position[axis]) / direction[axis]);
+    }
+
+    //a hair short of the exit, so rounding never steps over the first sample past it
+    float steps = std::ceil(std::min(distance / stepLength, 1e6f) - 1e-3f);
+    return std::max(1u, (unsigned int)std::max(steps, 0.0f));
+}
+
+std::shared_ptr<Texture3D> OccupancyGrid::createTexture(unsigned int dimensions)
+{
+    std::shared_ptr<Texture3D> texture = std::make_shared<Texture3D>();
+    texture->SetWidth(dimensions);
+    texture->SetHeight(dimensions >> 1);
+    texture->SetDepth(dimensions >> 1);
+    texture->SetWrap(GL_CLAMP_TO_EDGE);
+    texture->SetMinFilter(GL_NEAREST);
+    texture->SetMagFilter(GL_NEAREST);
+    texture->SetPixelFormat(GL_RED_INTEGER);
+    texture->SetDataType(GL_UNSIGNED_BYTE);
+    texture->SetInternalFormat(GL_R8UI);
+    texture->SaveTextureState();
+    return texture;
+}
+
+void OccupancyGrid::upload(Texture3D* texture) const
+{
+    Texture3D::Commands commands(texture);
+    commands.uploadData(&texels[0]);
+}
@@ -0,0 +1,85 @@
+//
+//  OccupancyGrid.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "glm/glm.hpp"
+#include "VoxelGrid.h"
+
+class Texture3D;
+
+/// <summary> Which voxels hold something, one bit per voxel, and a min/max pyramid over it, for ray marchers to jump
+/// over empty space instead of sampling it.  Level 1 keeps a byte per 2x2x2 voxels, one bit each (x + 2y + 4z).  Every
+/// level past it keeps a byte per cell of 2^level voxels a side: OCCUPIED if any voxel under it is (the max), FULL if
+/// all of them are (the min).  Either way a zero byte is an empty cell.  A voxel is occupied when its albedo's alpha
+/// isn't zero.
+///
+/// The levels are packed side by side along x in one byte texture (dimensions x dimensions/2 x dimensions/2), level
+/// L starting at column dimensions - 2 * (dimensions >> L), the way BrickPool packs its page tables, so a shader gets
+/// the whole pyramid from one usampler3D.  buildOccupancy in downsize.cl builds the same texels on the GPU and
+/// voxel_visualization.frag mirrors skip(). </summary>
+class OccupancyGrid
+{
+public:
+    static const unsigned char OCCUPIED = 1;
+    static const unsigned char FULL = 2;
+
+    explicit OccupancyGrid(unsigned int dimensions = 0);
+
+    void resize(unsigned int dimensions);
+    inline unsigned int getDimensions() const { return dimensions; }
+
+    /// <summary> Number of levels past the voxels themselves, the last one is a single cell. </summary>
+    inline unsigned int getLevelCount() const { return levelCount; }
+
+    /// <summary> Refills every level from the alpha of base's voxels. </summary>
+    void build(const VoxelGrid& base);
+
+    /// <summary> Only refills the cells that depend on region, given in base voxels. </summary>
+    void build(const VoxelGrid& base, VoxelGrid::Region region);
+
+    inline bool isOccupied(glm::ivec3 voxel) const
+    {
+        glm::ivec3 bit = voxel & 1;
+        return (texels[index(1, voxel >> 1)] & (1 << (bit.x + 2 * bit.y + 4 * bit.z))) != 0;
+    }
+
+    /// <summary> Whether the cell of 2^level voxels a side holding voxel is empty, level 0 being the voxel. </summary>
+    inline bool isEmpty(unsigned int level, glm::ivec3 voxel) const
+    {
+        return level == 0 ? !isOccupied(voxel) : texels[index(level, voxel >> int(level))] == 0;
+    }
+
+    /// <summary> The stepping API.  For a ray at position (in voxels) going along direction in steps of stepLength
+    /// (in voxels too), the number of whole steps that stay inside the largest empty cell holding position, at least
+    /// one; 0 when the voxel at position is occupied and should be sampled.  Steps are counted from position, so
+    /// the samples a ray takes after skipping land where its fixed steps would have. </summary>
+    unsigned int skip(const glm::vec3& position, const glm::vec3& direction, float stepLength) const;
+
+    /// <summary> A texture the packed levels fit in, see the class summary, and sending them to it. </summary>
+    static std::shared_ptr<Texture3D> createTexture(unsigned int dimensions);
+    void upload(Texture3D* texture) const;
+
+    inline size_t getBytes() const { return texels.size(); }
+
+    /// <summary> First column of a level in the packed layout. </summary>
+    static inline int levelOffset(unsigned int dimensions, unsigned int level){ return int(dimensions) - 2 * int(dimensions >> level); }
+
+private:
+    inline size_t index(unsigned int level, glm::ivec3 cell) const
+    {
+        return size_t(levelOffset(dimensions, level) + cell.x) + size_t(dimensions) * (size_t(cell.y) + size_t(dimensions >> 1) * size_t(cell.z));
+    }
+
+    void buildBits(const VoxelGrid& base, const VoxelGrid::Region& region);
+    void buildLevel(unsigned int level, const VoxelGrid::Region& region);
+
+private:
+    unsigned int dimensions = 0;
+    unsigned int levelCount = 0;
+    std::vector<unsigned char> texels;
+};
@@ -0,0 +1,114 @@
+//
+//  VoxelClipmap.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "VoxelClipmap.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <assert.h>
+
+VoxelClipmap::VoxelClipmap(unsigned int _dimensions, unsigned int count, float baseWorldSize):
+dimensions(_dimensions)
+{
+    assert(count > 0 && dimensions > 0);
+
+    cascades.resize(count);
+    float voxelSize = baseWorldSize / float(dimensions);
+    for(Cascade& cascade : cascades)
+    {
+        cascade.voxelSize = voxelSize;
+        voxelSize *= 2.0f;
+    }
+}
+
+void VoxelClipmap::recenter(const glm::vec3& position, std::vector<std::vector<VoxelGrid::Region>>& exposed)
+{
+    int size = int(dimensions);
+    exposed.assign(cascades.size(), std::vector<VoxelGrid::Region>());
+
+    for(size_t i = 0; i < cascades.size(); ++i)
+    {
+        Cascade& cascade = cascades[i];
+        glm::ivec3 origin = glm::ivec3(glm::floor(position / cascade.voxelSize)) - size / 2;
+        glm::ivec3 delta = origin - cascade.origin;
+
+        if(!cascade.placed || glm::any(glm::greaterThanEqual(glm::abs(delta), glm::ivec3(size))))
+        {
+            exposed[i].push_back(VoxelGrid::Region::whole(dimensions));
+        }
+        else
+        {
+            //one slab per axis that moved, on the side the window moved towards.  Slabs overlap on the edges when
+            //moving diagonally, voxelizing those voxels twice is cheaper than cutting the slabs apart
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                if(delta[axis] == 0) continue;
+
+                VoxelGrid::Region slab = VoxelGrid::Region::whole(dimensions);
+                if(delta[axis] > 0)
+                {
+                    slab.begin[axis] = size - delta[axis];
+                }
+                else
+                {
+                    slab.end[axis] = -delta[axis];
+                }
+                exposed[i].push_back(slab);
+            }
+        }
+
+        cascade.origin = origin;
+        cascade.placed = true;
+    }
+}
+
+glm::mat4 VoxelClipmap::getVoxViewProjection(unsigned int cascade) const
+{
+    //no camera involved, the window is axis aligned so an affine map to [-1, 1] is all it takes
+    glm::vec3 worldMin = cascades[cascade].getWorldMin();
+    float worldSize = getWorldSize(cascade);
+    glm::mat4 toUnit = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f / worldSize)) * glm::translate(glm::mat4(1.0f), -worldMin);
+    return glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f)) * toUnit;
+}
+
+void VoxelClipmap::getStorageRegions(unsigned int cascade, const VoxelGrid::Region& region, std::vector<VoxelGrid::Region>& storage) const
+{
+    storage.clear();
+    if(region.isEmpty()) return;
+
+    int size = int(dimensions);
+    glm::ivec3 offset = cascades[cascade].getToroidalOffset(dimensions);
+    glm::ivec3 begin = region.begin + offset;
+    glm::ivec3 end = region.end + offset;
+
+    //per axis the region either fits before the wrap or is cut in two by it
+    glm::ivec2 pieces[3][2];
+    int counts[3];
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        if(begin[axis] >= size)
+        {
+            pieces[axis][0] = glm::ivec2(begin[axis] - size, end[axis] - size);
+            counts[axis] = 1;
+        }
+        else if(end[axis] <= size)
+        {
+            pieces[axis][0] = glm::ivec2(begin[axis], end[axis]);
+            counts[axis] = 1;
+        }
+        else
+        {
+            pieces[axis][0] = glm::ivec2(begin[axis], size);
+            pieces[axis][1] = glm::ivec2(0, end[axis] - size);
+            counts[axis] = 2;
+        }
+    }
+
+    for(int z = 0; z < counts[2]; ++z)
+    for(int y = 0; y < counts[1]; ++y)
+    for(int x = 0; x < counts[0]; ++x)
+    {
+        storage.push_back(VoxelGrid::Region(glm::ivec3(pieces[0][x].x, pieces[1][y].x, pieces[2][z].x),
+                                            glm::ivec3(pieces[0][x].y, pieces[1][y].y, pieces[2][z].y)));
+    }
+}
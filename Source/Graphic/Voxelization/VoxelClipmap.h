@@ -0,0 +1,57 @@
+//
+//  VoxelClipmap.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "VoxelGrid.h"
+
+/// <summary> Placement of nested voxel volumes (cascades) that follow a point, usually the camera.  Every cascade has the
+/// same number of voxels per side and twice the voxel size of the one inside it.  Windows snap to whole voxels and their
+/// contents are addressed toroidally: absolute voxel a of a cascade lives at texel a mod dimensions, so when a window
+/// moves only the slabs that scrolled in have to be voxelized and nothing already stored is moved or cleared. </summary>
+class VoxelClipmap
+{
+public:
+    struct Cascade
+    {
+        float voxelSize = 0.0f;
+        glm::ivec3 origin = glm::ivec3(0);  //absolute voxel at the window's min corner
+        bool placed = false;
+
+        inline glm::vec3 getWorldMin() const { return glm::vec3(origin) * voxelSize; }
+
+        /// <summary> Where voxel (0, 0, 0) of the window is stored. </summary>
+        inline glm::ivec3 getToroidalOffset(unsigned int dimensions) const
+        {
+            int size = int(dimensions);
+            return ((origin % size) + size) % size;
+        }
+    };
+
+    /// <summary> baseWorldSize is the world space size of the innermost cascade. </summary>
+    VoxelClipmap(unsigned int dimensions, unsigned int cascades, float baseWorldSize);
+
+    /// <summary> Centers every cascade on position.  exposed receives, per cascade, the window space regions that are new
+    /// since the last call (the whole window the first time, or when it jumped farther than its own size). </summary>
+    void recenter(const glm::vec3& position, std::vector<std::vector<VoxelGrid::Region>>& exposed);
+
+    /// <summary> Maps world space to the window of a cascade as [-1, 1], the same role voxViewProjection has for the
+    /// fixed volume. </summary>
+    glm::mat4 getVoxViewProjection(unsigned int cascade) const;
+
+    /// <summary> Splits a window space region into the texel boxes it's stored in, up to eight of them. </summary>
+    void getStorageRegions(unsigned int cascade, const VoxelGrid::Region& region, std::vector<VoxelGrid::Region>& storage) const;
+
+    inline const Cascade& getCascade(unsigned int cascade) const { return cascades[cascade]; }
+    inline unsigned int getCascadeCount() const { return (unsigned int)cascades.size(); }
+    inline unsigned int getDimensions() const { return dimensions; }
+    inline float getWorldSize(unsigned int cascade) const { return cascades[cascade].voxelSize * float(dimensions); }
+
+private:
+    unsigned int dimensions;
+    std::vector<Cascade> cascades;
+};
@@ -0,0 +1,271 @@
+//
+//  VoxelFormat.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "VoxelFormat.h"
+#include "MipChainBuilder.h"
+#include "glm/gtc/packing.hpp"
+#include <iostream>
+#include <cmath>
+
+namespace
+{
+    inline glm::vec4 quantize(const glm::vec4& value, const glm::vec4& steps)
+    {
+        return glm::round(glm::clamp(value, 0.0f, 1.0f) * steps) / steps;
+    }
+
+    inline float signNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+}
+
+void VoxelFormat::setAlbedoProperties(Texture::Properties& properties) const
+{
+    switch(albedo)
+    {
+        case Albedo::RGBA32F: properties.internalFormat = GL_RGBA32F; break;
+        case Albedo::RGBA16F: properties.internalFormat = GL_RGBA16F; break;
+        case Albedo::RGBA8:   properties.internalFormat = GL_RGBA8; break;
+        case Albedo::RGB10A2: properties.internalFormat = GL_RGB10_A2; break;
+    }
+    properties.pixelFormat = GL_RGBA;
+    properties.dataFormat = GL_FLOAT;
+}
+
+void VoxelFormat::setNormalProperties(Texture::Properties& properties) const
+{
+    properties.internalFormat = normal == Normal::OCTAHEDRAL16 ? GL_RGBA16 : GL_RGBA32F;
+    properties.pixelFormat = GL_RGBA;
+    properties.dataFormat = GL_FLOAT;
+}
+
+size_t VoxelFormat::getAlbedoBytesPerVoxel() const
+{
+    switch(albedo)
+    {
+        case Albedo::RGBA32F: return 16;
+        case Albedo::RGBA16F: return 8;
+        case Albedo::RGBA8:
+        case Albedo::RGB10A2: return 4;
+    }
+    return 16;
+}
+
+size_t VoxelFormat::getNormalBytesPerVoxel() const
+{
+    return normal == Normal::OCTAHEDRAL16 ? 8 : 16;
+}
+
+const glm::vec4* VoxelFormat::encodeNormals(const VoxelGrid& grid, const VoxelGrid::Region& region, std::vector<glm::vec4>& storage) const
+{
+    if(!hasOctahedralNormals())
+    {
+        return &grid.normal[0];
+    }
+
+    if(storage.size() != grid.size())
+    {
+        storage.resize(grid.size());
+    }
+
+    for(int z = region.begin.z; z < region.end.z; ++z)
+    for(int y = region.begin.y; y < region.end.y; ++y)
+    for(int x = region.begin.x; x < region.end.x; ++x)
+    {
+        size_t i = grid.index(x, y, z);
+        storage[i] = encodeNormal(grid.normal[i]);
+    }
+    return &storage[0];
+}
+
+void VoxelFormat::decodeNormals(VoxelGrid& grid) const
+{
+    if(!hasOctahedralNormals()) return;
+
+    for(glm::vec4& texel : grid.normal)
+    {
+        texel = decodeNormal(texel);
+    }
+}
+
+glm::vec4 VoxelFormat::storeAlbedo(const glm::vec4& value) const
+{
+    switch(albedo)
+    {
+        case Albedo::RGBA32F: return value;
+        case Albedo::RGBA16F: return glm::unpackHalf4x16(glm::packHalf4x16(value));
+        case Albedo::RGBA8:   return quantize(value, glm::vec4(255.0f));
+        case Albedo::RGB10A2: return quantize(value, glm::vec4(1023.0f, 1023.0f, 1023.0f, 3.0f));
+    }
+    return value;
+}
+
+glm::vec4 VoxelFormat::storeNormal(const glm::vec4& value) const
+{
+    if(!hasOctahedralNormals()) return value;
+
+    return decodeNormal(quantize(encodeNormal(value), glm::vec4(65535.0f)));
+}
+
+glm::vec2 VoxelFormat::octahedralEncode(const glm::vec3& direction)
+{
+    //"A Survey of Efficient Representations for Independent Unit Vectors", Cigolle et al.
+    glm::vec3 n = direction / (std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z));
+    if(n.z < 0.0f)
+    {
+        return glm::vec2((1.0f - std::abs(n.y)) * signNotZero(n.x), (1.0f - std::abs(n.x)) * signNotZero(n.y));
+    }
+    return glm::vec2(n.x, n.y);
+}
+
+glm::vec3 VoxelFormat::octahedralDecode(const glm::vec2& encoded)
+{
+    glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+glm::vec4 VoxelFormat::encodeNormal(const glm::vec4& value)
+{
+    float coverage = glm::clamp(value.w, 0.0f, 1.0f);
+    float length = glm::length(glm::vec3(value));
+    if(coverage <= 0.0f || length <= 0.0f)
+    {
+        return glm::vec4(0.5f * coverage, 0.5f * coverage, 0.0f, coverage);
+    }
+
+    glm::vec2 direction = (octahedralEncode(glm::vec3(value) / length) * 0.5f + 0.5f) * coverage;
+    return glm::vec4(direction, std::min(length, 1.0f), coverage);
+}
+
+glm::vec4 VoxelFormat::decodeNormal(const glm::vec4& texel)
+{
+    if(texel.w <= 0.0f)
+    {
+        return glm::vec4(0.0f);
+    }
+
+    glm::vec2 encoded = glm::clamp(glm::vec2(texel) / texel.w * 2.0f - 1.0f, -1.0f, 1.0f);
+    return glm::vec4(octahedralDecode(encoded) * texel.z, texel.w);
+}
+
+void VoxelFormat::report()
+{
+    const VoxelFormat formats[] =
+    {
+        VoxelFormat(Albedo::RGBA32F, Normal::RGBA32F),
+        VoxelFormat(Albedo::RGBA16F, Normal::OCTAHEDRAL16),
+        VoxelFormat(Albedo::RGBA8, Normal::OCTAHEDRAL16),
+        VoxelFormat(Albedo::RGB10A2, Normal::OCTAHEDRAL16)
+    };
+    const char* names[] = { "rgba32f + rgba32f", "rgba16f + octahedral16", "rgba8 + octahedral16", "rgb10a2 + octahedral16" };
+
+    //memory: the whole pyramid.  Bandwidth: a full mip rebuild reads every level but the last and writes every level
+    //but the first, and a trilinear cone sample touches eight albedo and eight normal texels
+    for(unsigned int dimensions : {64u, 128u, 256u})
+    {
+        size_t pyramid = 0, rebuild = 0;
+        for(unsigned int side = dimensions; side > 0; side >>= 1)
+        {
+            size_t voxels = size_t(side) * side * side;
+            pyramid += voxels;
+            rebuild += side > 1 ? voxels : 0;
+            rebuild += side < dimensions ? voxels : 0;
+        }
+
+        for(size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i)
+        {
+            size_t bytes = formats[i].getBytesPerVoxel();
+            std::cout << "voxel format " << dimensions << "^3 " << names[i] << ": " << pyramid * bytes / (1024.0 * 1024.0)
+                      << " MB, mip rebuild moves " << rebuild * bytes / (1024.0 * 1024.0) << " MB, cone sample reads "
+                      << 8 * bytes << " bytes" << std::endl;
+        }
+    }
+
+    //accuracy: a lit Cornell box like volume with a sphere whose normals point every which way.  Every level is built
+    //from the stored level above it, which is what the GPU does
+    unsigned int dimensions = 64;
+    VoxelGrid base(dimensions);
+    int low = int(dimensions) / 8;
+    int high = int(dimensions) - low - 1;
+    glm::vec3 center(float(dimensions) * 0.5f);
+    float radius = float(dimensions) / 6.0f;
+    for(int z = 0; z < int(dimensions); ++z)
+    for(int y = 0; y < int(dimensions); ++y)
+    for(int x = 0; x < int(dimensions); ++x)
+    {
+        glm::vec3 position = glm::vec3(x, y, z) + 0.5f;
+        glm::vec3 offset = position - center;
+        float light = 1.0f / (1.0f + glm::dot(offset, offset) / float(dimensions * dimensions));
+        size_t index = base.index(x, y, z);
+
+        bool inside = x >= low && x <= high && y >= low && y <= high && z >= low;
+        if(std::abs(glm::length(offset) - radius) < 0.5f)
+        {
+            base.albedo[index] = glm::vec4(glm::vec3(0.87f) * light, 1.0f);
+            base.normal[index] = glm::vec4(glm::normalize(offset), 1.0f);
+        }
+        else if(inside && (x == low || x == high))
+        {
+            base.albedo[index] = glm::vec4(x == low ? glm::vec3(1.0f, 0.26f, 0.27f) * light : glm::vec3(0.27f, 1.0f, 0.26f) * light, 1.0f);
+            base.normal[index] = glm::vec4(x == low ? 1.0f : -1.0f, 0.0f, 0.0f, 1.0f);
+        }
+        else if(inside && (y == low || y == high || z == low))
+        {
+            base.albedo[index] = glm::vec4(glm::vec3(0.87f) * light, 1.0f);
+            base.normal[index] = z == low ? glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) : glm::vec4(0.0f, y == low ? 1.0f : -1.0f, 0.0f, 1.0f);
+        }
+    }
+
+    std::vector<VoxelGrid> reference;
+    MipChainBuilder::build(base, reference);
+
+    for(size_t i = 1; i < sizeof(formats) / sizeof(formats[0]); ++i)
+    {
+        const VoxelFormat& format = formats[i];
+        VoxelGrid stored = base;
+        float maxAlbedo = 0.0f, sumAlbedo = 0.0f, maxCoverage = 0.0f, maxAngle = 0.0f, maxLength = 0.0f;
+        size_t compared = 0;
+
+        for(size_t level = 0; level <= reference.size(); ++level)
+        {
+            const VoxelGrid& expected = level == 0 ? base : reference[level - 1];
+            if(level > 0)
+            {
+                VoxelGrid next;
+                stored.downsample(next);
+                stored = next;
+            }
+
+            for(size_t t = 0; t < stored.size(); ++t)
+            {
+                stored.albedo[t] = format.storeAlbedo(stored.albedo[t]);
+                stored.normal[t] = format.storeNormal(stored.normal[t]);
+                if(expected.albedo[t].w == 0.0f && stored.albedo[t].w == 0.0f) continue;
+
+                float albedoError = glm::length(glm::vec3(stored.albedo[t]) - glm::vec3(expected.albedo[t]));
+                maxAlbedo = std::max(maxAlbedo, albedoError);
+                sumAlbedo += albedoError;
+                maxCoverage = std::max(maxCoverage, std::abs(stored.albedo[t].w - expected.albedo[t].w));
+                ++compared;
+
+                glm::vec3 expectedNormal(expected.normal[t]), storedNormal(stored.normal[t]);
+                maxLength = std::max(maxLength, std::abs(glm::length(storedNormal) - glm::length(expectedNormal)));
+                if(glm::length(expectedNormal) > 1e-3f && glm::length(storedNormal) > 1e-3f)
+                {
+                    float cosine = glm::clamp(glm::dot(glm::normalize(storedNormal), glm::normalize(expectedNormal)), -1.0f, 1.0f);
+                    maxAngle = std::max(maxAngle, glm::degrees(std::acos(cosine)));
+                }
+            }
+        }
+
+        std::cout << "voxel format " << names[i] << " vs rgba32f over " << reference.size() + 1 << " levels: albedo error max "
+                  << maxAlbedo << " mean " << sumAlbedo / std::max(compared, size_t(1)) << ", coverage error max " << maxCoverage
+                  << ", normal angle max " << maxAngle << " degrees, normal length error max " << maxLength << std::endl;
+    }
+}
@@ -0,0 +1,74 @@
+//
+//  VoxelFormat.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "VoxelGrid.h"
+#include "Graphic/Material/Texture/Texture.h"
+
+/// <summary> How the albedo and normal voxel textures are stored on the GPU.  VoxelGrid always holds plain floats, the
+/// same values the RGBA32F textures hold, and textures are always uploaded and read back as GL_RGBA/GL_FLOAT, so only
+/// octahedral normals need converting on the way in and out; GL does the rest.
+///
+/// Octahedral normals are kept as ((0.5 + 0.5 * octahedral(n)) * coverage, |n|, coverage) in an RGBA16 texel.  The
+/// direction is premultiplied by coverage like color is by alpha, so a cleared texel is an empty voxel and trilinear
+/// filtering next to empty voxels stays right once decodeNormal() divides it back out.  |n| keeps the length of
+/// averaged normals, which the cone tracer's Toksvig factor reads.  encodeNormal() and decodeNormal() are mirrored in
+/// voxelization.frag, voxelConeTracing.frag and downsize.cl. </summary>
+class VoxelFormat
+{
+public:
+    enum class Albedo
+    {
+        RGBA32F,
+        RGBA16F,
+        RGBA8,
+        RGB10A2
+    };
+
+    enum class Normal
+    {
+        RGBA32F,
+        OCTAHEDRAL16
+    };
+
+    inline VoxelFormat(Albedo _albedo = Albedo::RGBA32F, Normal _normal = Normal::RGBA32F): albedo(_albedo), normal(_normal){}
+
+    /// <summary> Sets the internal format of properties, the pixel transfer format stays GL_RGBA/GL_FLOAT. </summary>
+    void setAlbedoProperties(Texture::Properties& properties) const;
+    void setNormalProperties(Texture::Properties& properties) const;
+
+    inline bool hasOctahedralNormals() const { return normal == Normal::OCTAHEDRAL16; }
+
+    size_t getAlbedoBytesPerVoxel() const;
+    size_t getNormalBytesPerVoxel() const;
+    inline size_t getBytesPerVoxel() const { return getAlbedoBytesPerVoxel() + getNormalBytesPerVoxel(); }
+
+    /// <summary> Fills storage with what the normal texture holds for region of grid, only the texels inside region are
+    /// written.  storage is what should be handed to Texture3D::Commands::uploadRegion(). </summary>
+    const glm::vec4* encodeNormals(const VoxelGrid& grid, const VoxelGrid::Region& region, std::vector<glm::vec4>& storage) const;
+
+    /// <summary> Turns normals read back from a normal texture into the values VoxelGrid works with, in place. </summary>
+    void decodeNormals(VoxelGrid& grid) const;
+
+    /// <summary> Round trips a texel through the albedo or normal storage, the values the GPU would hand back. </summary>
+    glm::vec4 storeAlbedo(const glm::vec4& value) const;
+    glm::vec4 storeNormal(const glm::vec4& value) const;
+
+    static glm::vec2 octahedralEncode(const glm::vec3& direction);
+    static glm::vec3 octahedralDecode(const glm::vec2& encoded);
+    static glm::vec4 encodeNormal(const glm::vec4& value);
+    static glm::vec4 decodeNormal(const glm::vec4& texel);
+
+    /// <summary> Prints, for every format, the bytes a voxel pyramid takes and moves at 64, 128 and 256 voxels per side
+    /// and how far a Cornell box like volume (and its mips) lands from the RGBA32F results. </summary>
+    static void report();
+
+public:
+    Albedo albedo;
+    Normal normal;
+};
@@ -0,0 +1,117 @@
+//
+//  VoxelGrid.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "VoxelGrid.h"
+#include <assert.h>
+#include <algorithm>
+#include "glm/gtc/matrix_transform.hpp"
+
+VoxelGrid::VoxelGrid(unsigned int _dimensions)
+{
+    resize(_dimensions);
+}
+
+void VoxelGrid::resize(unsigned int _dimensions)
+{
+    dimensions = _dimensions;
+    size_t total = size_t(dimensions) * dimensions * dimensions;
+    albedo.assign(total, glm::vec4(0.0f));
+    normal.assign(total, glm::vec4(0.0f));
+}
+
+void VoxelGrid::clear()
+{
+    std::fill(albedo.begin(), albedo.end(), glm::vec4(0.0f));
+    std::fill(normal.begin(), normal.end(), glm::vec4(0.0f));
+}
+
+size_t VoxelGrid::occupiedVoxels() const
+{
+    size_t occupied = 0;
+    for(const glm::vec4& texel : albedo)
+    {
+        occupied += texel.a > 0.0f ? 1 : 0;
+    }
+    return occupied;
+}
+
+void VoxelGrid::downsample(VoxelGrid& destination) const
+{
+    unsigned int half = dimensions >> 1;
+    assert(half > 0 && "can't downsample a 1x1x1 grid");
+    if(destination.getDimensions() != half)
+    {
+        destination.resize(half);
+    }
+
+    const std::vector<glm::vec4>* sources[2] = { &albedo, &normal };
+    std::vector<glm::vec4>* destinations[2] = { &destination.albedo, &destination.normal };
+
+    for(int grid = 0; grid < 2; ++grid)
+    {
+        const std::vector<glm::vec4>& source = *sources[grid];
+        std::vector<glm::vec4>& dest = *destinations[grid];
+        for(unsigned int z = 0; z < half; ++z)
+        for(unsigned int y = 0; y < half; ++y)
+        for(unsigned int x = 0; x < half; ++x)
+        {
+            //same order of additions as getAverage() so results match the kernel bit for bit
+            glm::vec4 value = source[index(x * 2,     y * 2,     z * 2)] +
+                              source[index(x * 2 + 1, y * 2,     z * 2)] +
+                              source[index(x * 2,     y * 2 + 1, z * 2)] +
+                              source[index(x * 2 + 1, y * 2 + 1, z * 2)] +
+                              source[index(x * 2,     y * 2,     z * 2 + 1)] +
+                              source[index(x * 2 + 1, y * 2,     z * 2 + 1)] +
+                              source[index(x * 2,     y * 2 + 1, z * 2 + 1)] +
+                              source[index(x * 2 + 1, y * 2 + 1, z * 2 + 1)];
+            value *= 0.125f;
+            dest[destination.index(x, y, z)] = value;
+        }
+    }
+}
+
+glm::mat4 VoxelGrid::gridFromWorld(const glm::mat4& voxViewProjection, unsigned int dimensions)
+{
+    //clip space [-1, 1] to voxel grid space [0, dimensions], exactly what the voxelization shaders do with gl_Layer
+    float halfDimensions = float(dimensions) * 0.5f;
+    glm::mat4 gridFromClip = glm::translate(glm::mat4(1.0f), glm::vec3(halfDimensions)) * glm::scale(glm::mat4(1.0f), glm::vec3(halfDimensions));
+    return gridFromClip * voxViewProjection;
+}
+
+VoxelGrid::Difference VoxelGrid::compare(const VoxelGrid& other) const
+{
+    assert(other.getDimensions() == dimensions);
+    Difference difference;
+
+    double totalAlbedoError = 0.0;
+    size_t bothOccupied = 0;
+    for(size_t i = 0; i < albedo.size(); ++i)
+    {
+        bool occupied = albedo[i].a > 0.0f;
+        bool otherOccupied = other.albedo[i].a > 0.0f;
+
+        difference.occupiedInThis += occupied ? 1 : 0;
+        difference.occupiedInOther += otherOccupied ? 1 : 0;
+
+        if(occupied != otherOccupied)
+        {
+            ++difference.occupancyMismatches;
+            continue;
+        }
+        if(!occupied) continue;
+
+        glm::vec3 albedoDelta = glm::abs(glm::vec3(albedo[i]) - glm::vec3(other.albedo[i]));
+        float albedoError = std::max(albedoDelta.x, std::max(albedoDelta.y, albedoDelta.z));
+        difference.maxAlbedoError = std::max(difference.maxAlbedoError, albedoError);
+        totalAlbedoError += albedoError;
+
+        glm::vec3 normalDelta = glm::abs(glm::vec3(normal[i]) - glm::vec3(other.normal[i]));
+        difference.maxNormalError = std::max(difference.maxNormalError, std::max(normalDelta.x, std::max(normalDelta.y, normalDelta.z)));
+        ++bothOccupied;
+    }
+
+    difference.meanAlbedoError = bothOccupied ? float(totalAlbedoError / double(bothOccupied)) : 0.0f;
+    return difference;
+}
@@ -0,0 +1,78 @@
+//
+//  VoxelGrid.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+
+/// <summary> CPU side copy of the albedo and normal voxel textures.  Texels are laid out exactly like the GL_RGBA/GL_FLOAT
+/// 3D textures VoxelizeRT renders into (x fastest, then y, then layer) so a grid can be uploaded or read back as is. </summary>
+class VoxelGrid
+{
+public:
+    struct Difference
+    {
+        size_t occupiedInThis = 0;
+        size_t occupiedInOther = 0;
+        size_t occupancyMismatches = 0;
+        float maxAlbedoError = 0.0f;
+        float meanAlbedoError = 0.0f;
+        float maxNormalError = 0.0f;
+    };
+
+    /// <summary> Box of voxels, begin inclusive and end exclusive. </summary>
+    struct Region
+    {
+        glm::ivec3 begin = glm::ivec3(0);
+        glm::ivec3 end = glm::ivec3(0);
+
+        inline Region(){}
+        inline Region(glm::ivec3 _begin, glm::ivec3 _end): begin(_begin), end(_end){}
+
+        inline bool isEmpty() const { return end.x <= begin.x || end.y <= begin.y || end.z <= begin.z; }
+        inline glm::ivec3 size() const { return glm::max(end - begin, glm::ivec3(0)); }
+
+        ///<summary> The voxels of the next mip level that read from this region. </summary>
+        inline Region downsampled() const { return Region(begin / 2, (end + 1) / 2); }
+
+        ///<summary> Smallest region holding both, an empty region adds nothing. </summary>
+        inline Region merged(const Region& other) const
+        {
+            if(isEmpty()) return other;
+            if(other.isEmpty()) return *this;
+            return Region(glm::min(begin, other.begin), glm::max(end, other.end));
+        }
+
+        static inline Region whole(unsigned int dimensions){ return Region(glm::ivec3(0), glm::ivec3(int(dimensions))); }
+    };
+
+    explicit VoxelGrid(unsigned int dimensions = 0);
+
+    void resize(unsigned int dimensions);
+    void clear();
+
+    inline unsigned int getDimensions() const { return dimensions; }
+    inline size_t size() const { return albedo.size(); }
+    inline size_t index(unsigned int x, unsigned int y, unsigned int z) const { return x + dimensions * (y + size_t(dimensions) * z); }
+
+    size_t occupiedVoxels() const;
+
+    ///<summary> Reference 2x2x2 box filter, does exactly what getAverage() in downsize.cl does. </summary>
+    void downsample(VoxelGrid& destination) const;
+
+    ///<summary> Maps world space to [0, dimensions] voxel space, given the projection voxelization renders with. </summary>
+    static glm::mat4 gridFromWorld(const glm::mat4& voxViewProjection, unsigned int dimensions);
+
+    ///<summary> Compares occupancy (alpha) and colors of two grids of the same dimensions. </summary>
+    Difference compare(const VoxelGrid& other) const;
+
+public:
+    std::vector<glm::vec4> albedo;
+    std::vector<glm::vec4> normal;
+
+private:
+    unsigned int dimensions = 0;
+};
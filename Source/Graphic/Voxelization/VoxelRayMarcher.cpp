@@ -0,0 +1,179 @@
+//
+//  VoxelRayMarcher.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "VoxelRayMarcher.h"
+#include "MipChainBuilder.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <cmath>
+
+glm::vec4 VoxelRayMarcher::fetch(const VoxelGrid& grid, glm::vec3 uvw)
+{
+    int last = int(grid.getDimensions()) - 1;
+    glm::ivec3 texel = glm::clamp(glm::ivec3(glm::floor(uvw * float(grid.getDimensions()))), glm::ivec3(0), glm::ivec3(last));
+    return grid.albedo[grid.index(texel.x, texel.y, texel.z)];
+}
+
+VoxelRayMarcher::Result VoxelRayMarcher::march(const VoxelGrid& voxels, const OccupancyGrid* occupancy, glm::vec3 start,
+                                               glm::vec3 stop, float stepSize, unsigned int maxSamples)
+{
+    Result result;
+    float dimensions = float(voxels.getDimensions());
+    glm::vec3 direction = glm::normalize(stop - start);
+    glm::vec3 step = direction * stepSize;
+    float travel = glm::distance(stop, start);
+
+    glm::vec3 position = start;
+    while(result.steps < maxSamples && travel > 0.0f)
+    {
+        unsigned int steps = occupancy != nullptr ? occupancy->skip(position * dimensions, direction, stepSize * dimensions) : 0;
+        if(steps == 0)
+        {
+            result.color += fetch(voxels, position);
+            ++result.samples;
+            steps = 1;
+        }
+        //from start rather than added up, so a ray lands on the same positions whatever it skipped
+        result.steps += steps;
+        position = start + step * float(result.steps);
+        travel -= stepSize * float(steps);
+    }
+    return result;
+}
+
+VoxelRayMarcher::Result VoxelRayMarcher::cone(const VoxelGrid& base, const std::vector<VoxelGrid>& mips, bool skipEmpty,
+                                              glm::vec3 origin, glm::vec3 direction)
+{
+    //same distances as the shader: from one voxel out to fifteen, one level per step
+    Result result;
+    unsigned int levels = (unsigned int)mips.size() + 1;
+    float dimensions = float(base.getDimensions());
+    float distanceLimit = 15.0f;
+    float step = distanceLimit / float(levels);
+    float j = 1.0f;
+    for(unsigned int lod = 0; lod < levels && j < distanceLimit; ++lod, j += step)
+    {
+        glm::vec3 uvw = (origin + direction * j) / dimensions;
+        if(glm::any(glm::lessThan(uvw, glm::vec3(0.0f))) || glm::any(glm::greaterThan(uvw, glm::vec3(1.0f)))) break;
+
+        const VoxelGrid& level = lod == 0 ? base : mips[lod - 1];
+        glm::vec4 albedo = fetch(level, uvw);
+        result.color += albedo;
+        ++result.samples;
+        ++result.steps;
+
+        //an empty albedo texel is an empty cell, whose normal is zero too
+        if(!skipEmpty || albedo.w > 0.0f)
+        {
+            ++result.samples;
+        }
+    }
+    return result;
+}
+
+void VoxelRayMarcher::benchmark()
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    for(unsigned int dimensions : {64u, 128u})
+    {
+        //five walls one voxel thick and a sphere shell, the scenes this renders are mostly air like this
+        VoxelGrid base(dimensions);
+        int low = int(dimensions) / 8;
+        int high = int(dimensions) - low - 1;
+        glm::vec3 center(float(dimensions) * 0.5f);
+        float radius = float(dimensions) / 6.0f;
+        for(int z = 0; z < int(dimensions); ++z)
+        for(int y = 0; y < int(dimensions); ++y)
+        for(int x = 0; x < int(dimensions); ++x)
+        {
+            bool inside = x >= low && x <= high && y >= low && y <= high && z >= low;
+            bool wall = inside && (x == low || x == high || y == low || y == high || z == low);
+            bool sphere = std::abs(glm::length(glm::vec3(x, y, z) + 0.5f - center) - radius) < 0.5f;
+            if(wall || sphere)
+            {
+                base.albedo[base.index(x, y, z)] = glm::vec4(0.7f, 0.6f, 0.5f, 1.0f);
+            }
+        }
+
+        std::vector<VoxelGrid> mips;
+        MipChainBuilder::build(base, mips);
+        OccupancyGrid occupancy;
+        Clock::time_point buildStart = Clock::now();
+        occupancy.build(base);
+        double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+
+        //visualization: a 128x128 image of the volume from a corner, what VoxelVisualizationRT sets up
+        const unsigned int RAYS = 128;
+        const unsigned int MAX_SAMPLES = 80;
+        float stepSize = 1.0f / float(dimensions);
+        glm::vec3 eye(2.0f, 1.5f, 2.5f);
+        glm::vec3 forward = glm::normalize(-eye);
+        glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+        glm::vec3 up = glm::cross(right, forward);
+
+        size_t rays = 0, fixedSamples = 0, skippingSamples = 0;
+        double fixedMs = 0.0, skippingMs = 0.0;
+        float maxError = 0.0f;
+        for(unsigned int py = 0; py < RAYS; ++py)
+        for(unsigned int px = 0; px < RAYS; ++px)
+        {
+            glm::vec2 film = (glm::vec2(px, py) + 0.5f) / float(RAYS) * 2.0f - 1.0f;
+            glm::vec3 direction = glm::normalize(forward + (right * film.x + up * film.y) * 0.6f);
+
+            //slab test against the [-1, 1] box the visualization draws
+            glm::vec3 inverse = 1.0f / direction;
+            glm::vec3 t0 = (glm::vec3(-1.0f) - eye) * inverse, t1 = (glm::vec3(1.0f) - eye) * inverse;
+            glm::vec3 tmin = glm::min(t0, t1), tmax = glm::max(t0, t1);
+            float tnear = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+            float tfar = std::min(std::min(tmax.x, tmax.y), tmax.z);
+            if(tnear > tfar) continue;
+
+            glm::vec3 start = 0.5f * (eye + direction * tnear + 1.0f);
+            glm::vec3 stop = 0.5f * (eye + direction * tfar + 1.0f);
+
+            Clock::time_point fixedStart = Clock::now();
+            Result fixed = march(base, nullptr, start, stop, stepSize, MAX_SAMPLES);
+            Clock::time_point skippingStart = Clock::now();
+            Result skipping = march(base, &occupancy, start, stop, stepSize, MAX_SAMPLES);
+            Clock::time_point end = Clock::now();
+
+            fixedMs += std::chrono::duration<double, std::milli>(skippingStart - fixedStart).count();
+            skippingMs += std::chrono::duration<double, std::milli>(end - skippingStart).count();
+            fixedSamples += fixed.samples;
+            skippingSamples += skipping.samples;
+            glm::vec4 delta = glm::abs(fixed.color - skipping.color);
+            maxError = std::max(maxError, std::max(std::max(delta.x, delta.y), std::max(delta.z, delta.w)));
+            ++rays;
+        }
+        rays = std::max(rays, size_t(1));
+
+        std::cout << "empty space skipping " << dimensions << "^3 visualization: " << double(fixedSamples) / rays
+                  << " samples per ray fixed, " << double(skippingSamples) / rays << " skipping, " << fixedMs
+                  << " ms vs " << skippingMs << " ms, max difference " << maxError << ", occupancy "
+                  << occupancy.getBytes() / 1024.0 << " KB built in " << buildMs << " ms" << std::endl;
+
+        //cone tracing: five cones spread over the hemisphere like the shader's sampling rays, from every voxel over the floor
+        const glm::vec3 CONES[5] = { glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.5f, 0.866025f), glm::vec3(0.823639f, 0.5f, 0.267617f),
+                                     glm::vec3(0.509037f, 0.5f, -0.7006629f), glm::vec3(-0.509037f, 0.5f, -0.7006629f) };
+        size_t cones = 0, fixedConeSamples = 0, skippingConeSamples = 0;
+        for(int z = low + 1; z < high; ++z)
+        for(int x = low + 1; x < high; ++x)
+        {
+            glm::vec3 origin = glm::vec3(x, low + 1, z) + 0.5f;
+            for(const glm::vec3& direction : CONES)
+            {
+                fixedConeSamples += cone(base, mips, false, origin, direction).samples;
+                skippingConeSamples += cone(base, mips, true, origin, direction).samples;
+                ++cones;
+            }
+        }
+        cones = std::max(cones, size_t(1));
+
+        std::cout << "empty space skipping " << dimensions << "^3 cone tracing: " << double(fixedConeSamples) / cones
+                  << " samples per cone fixed, " << double(skippingConeSamples) / cones << " skipping" << std::endl;
+    }
+}
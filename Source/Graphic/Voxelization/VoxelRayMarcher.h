@@ -0,0 +1,45 @@
+//
+//  VoxelRayMarcher.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "VoxelGrid.h"
+#include "OccupancyGrid.h"
+
+/// <summary> CPU reference for the two ray marches the shaders do through the voxels, with and without an
+/// OccupancyGrid to skip empty space, counting the texels they fetch.  Textures are sampled the way the voxel textures
+/// are set up, nearest texel, clamped to the volume. </summary>
+class VoxelRayMarcher
+{
+public:
+    struct Result
+    {
+        glm::vec4 color = glm::vec4(0.0f);
+        unsigned int samples = 0;   //voxel texels fetched
+        unsigned int steps = 0;     //fixed steps covered, sampled or skipped
+    };
+
+    /// <summary> The loop of voxel_visualization.frag: from start to stop (texture coordinates), stepSize at a time, at
+    /// most maxSamples steps, adding up every sample.  With occupancy, runs of steps that only cross empty cells
+    /// aren't sampled, which doesn't change the result. </summary>
+    static Result march(const VoxelGrid& voxels, const OccupancyGrid* occupancy, glm::vec3 start, glm::vec3 stop,
+                        float stepSize, unsigned int maxSamples);
+
+    /// <summary> collectLODColors() of voxelConeTracing.frag for one cone, origin and direction in base voxels: one
+    /// albedo and one normal fetch per level, the normal skipped when skipEmpty and the albedo says the cell is empty.
+    /// color adds up the albedo of every level. </summary>
+    static Result cone(const VoxelGrid& base, const std::vector<VoxelGrid>& mips, bool skipEmpty, glm::vec3 origin,
+                       glm::vec3 direction);
+
+    /// <summary> Marches a grid of visualization rays and the cones of every surface voxel through a Cornell box like
+    /// volume at 64 and 128 voxels per side, and prints the samples per ray and the time with and without skipping,
+    /// and how far apart the results land. </summary>
+    static void benchmark();
+
+private:
+    static glm::vec4 fetch(const VoxelGrid& grid, glm::vec3 uvw);
+};
@@ -36,4 +36,20 @@ public:
     }
     
     std::vector<Shape*> shapes;
+    
+    /// <summary> True when lights were added, removed, moved or recolored since the last clearPointLightsChanged() call. </summary>
+    inline bool pointLightsChanged() const
+    {
+        if(pointLights.size() != cleanPointLights.size()) return true;
+        for(size_t i = 0; i < pointLights.size(); ++i)
+        {
+            if(pointLights[i].position != cleanPointLights[i].position || pointLights[i].color != cleanPointLights[i].color) return true;
+        }
+        return false;
+    }
+    
+    inline void clearPointLightsChanged() { cleanPointLights = pointLights; }
+    
+private:
+    std::vector<PointLight> cleanPointLights;
 };
@@ -32,7 +32,7 @@ void CornellScene::init(unsigned int viewportWidth, unsigned int viewportHeight)
     cornell->transform.updateTransformMatrix();
 
 	// Light sphere.
-	lightSphere = ObjLoader::loadShapeFromObj("Assets\\Models\\sphere.obj");
+	lightSphere = ObjLoader::loadShapeFromObj("/Assets/Models/sphere.obj");
 	shapes.push_back(lightSphere);
 	for (unsigned int i = 0; i < lightSphere->meshes.size(); ++i) {
 		renderers.push_back((lightSphere->meshes[i]));
@@ -79,6 +79,5 @@ void CornellScene::update() {
 }
 
 CornellScene::~CornellScene() {
-	for (auto * r : renderers) delete r;
 	for (auto * s : shapes) delete s;
 }
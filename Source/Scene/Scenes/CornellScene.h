@@ -13,6 +13,5 @@ public:
 	void init(unsigned int viewportWidth, unsigned int viewportHeight) override;
 	~CornellScene();
 private:
-	std::vector<Shape*> shapes;
     Shape * lightSphere = nullptr;
 };
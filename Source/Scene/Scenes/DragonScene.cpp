@@ -30,7 +30,7 @@ void DragonScene::init(unsigned int viewportWidth, unsigned int viewportHeight)
 
 	// Dragon.
 	int dragonIndex = renderers.size();
-	Shape * dragon = ObjLoader::loadShapeFromObj("Assets\\Models\\dragon.obj");
+	Shape * dragon = ObjLoader::loadShapeFromObj("/Assets/Models/dragon.obj");
 	shapes.push_back(dragon);
 	for (unsigned int i = 0; i < dragon->meshes.size(); ++i) {
 		renderers.push_back(((dragon->meshes[i])));
@@ -59,7 +59,7 @@ void DragonScene::init(unsigned int viewportWidth, unsigned int viewportHeight)
     dragon->defaultVoxProperties = voxProps;
 
 	// Light.
-	light = ObjLoader::loadShapeFromObj("Assets\\Models\\quad.obj");
+	light = ObjLoader::loadShapeFromObj("/Assets/Models/quad.obj");
 	shapes.push_back(light);
 
 	renderers.push_back(light->meshes[0]);
@@ -99,5 +99,4 @@ void DragonScene::update() {
 
 DragonScene::~DragonScene() {
 	for (auto * s : shapes) delete s;
-	for (auto * r : renderers) delete r;
 }
@@ -13,6 +13,4 @@ public:
 	void update() override;
 	void init(unsigned int viewportWidth, unsigned int viewportHeight) override;
 	~DragonScene();
-private:
-	std::vector<Shape*> shapes;
 };
\ No newline at end of file
@@ -34,7 +34,7 @@ void MultipleObjectsScene::init(unsigned int viewportWidth, unsigned int viewpor
 
 	// Susanne.
 	int objectIndex = renderers.size();
-	Shape * object = ObjLoader::loadShapeFromObj("Assets\\Models\\susanne.obj");
+	Shape * object = ObjLoader::loadShapeFromObj("/Assets/Models/susanne.obj");
 	shapes.push_back(object);
 	for (unsigned int i = 0; i < object->meshes.size(); ++i) {
 		renderers.push_back((object->meshes[i]));
@@ -62,7 +62,7 @@ void MultipleObjectsScene::init(unsigned int viewportWidth, unsigned int viewpor
 
 	// Dragon.
 	objectIndex = renderers.size();
-	object = ObjLoader::loadShapeFromObj("Assets\\Models\\dragon.obj");
+	object = ObjLoader::loadShapeFromObj("/Assets/Models/dragon.obj");
 	shapes.push_back(object);
 	for (unsigned int i = 0; i < object->meshes.size(); ++i) {
 		renderers.push_back((object->meshes[i]));
@@ -88,7 +88,7 @@ void MultipleObjectsScene::init(unsigned int viewportWidth, unsigned int viewpor
 
 	// Bunny.
 	objectIndex = renderers.size();
-	object = ObjLoader::loadShapeFromObj("Assets\\Models\\bunny.obj");
+	object = ObjLoader::loadShapeFromObj("/Assets/Models/bunny.obj");
 	shapes.push_back(object);
 	for (unsigned int i = 0; i < object->meshes.size(); ++i) {
 		renderers.push_back(((object->meshes[i])));
@@ -112,7 +112,7 @@ void MultipleObjectsScene::init(unsigned int viewportWidth, unsigned int viewpor
 
 	// Light.
 	int lightIndex = renderers.size();
-	Shape * light = ObjLoader::loadShapeFromObj("Assets\\Models\\quad.obj");
+	Shape * light = ObjLoader::loadShapeFromObj("/Assets/Models/quad.obj");
 	shapes.push_back(light);
 	Mesh * lamp =  ((light->meshes[0]));
 	renderers.push_back(lamp);
@@ -141,6 +141,5 @@ void MultipleObjectsScene::init(unsigned int viewportWidth, unsigned int viewpor
 void MultipleObjectsScene::update() { FirstPersonScene::update(); }
 
 MultipleObjectsScene::~MultipleObjectsScene() {
-	for (auto * r : renderers) delete r;
 	for (auto * s : shapes) delete s;
 }
@@ -0,0 +1,190 @@
+//
+//  DrawList.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "DrawList.h"
+#include "Mesh.h"
+#include "Shape.h"
+#include "Scene/Scene.h"
+#include "Graphic/GLState.h"
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+const GLuint DrawList::DRAW_INDEX_LOCATION;
+
+DrawList::DrawList()
+{
+}
+
+DrawList::~DrawList()
+{
+    DrawList::Commands commands(this);
+    commands.destroyBuffers();
+}
+
+DrawList::Commands::Commands(DrawList* _list)
+{
+    list = _list;
+}
+
+void DrawList::Commands::update(Scene& scene)
+{
+    std::vector<Mesh*> meshes;
+    for(Shape* shape : scene.shapes)
+    {
+        meshes.insert(meshes.end(), shape->meshes.begin(), shape->meshes.end());
+    }
+    bool rebuilt = meshes != list->meshes;
+    if(rebuilt)
+    {
+        list->meshes.swap(meshes);
+        build();
+    }
+
+    size_t firstChanged = list->records.size(), lastChanged = 0;
+    size_t draw = 0;
+    for(Shape* shape : scene.shapes)
+    {
+        glm::mat4 model = shape->transform.getTransformMatrix();
+        for(size_t i = 0; i < shape->meshes.size(); ++i, ++draw)
+        {
+            const VoxProperties& prop = i < shape->meshProperties.size() ? shape->meshProperties[i] : shape->defaultVoxProperties;
+            UniformBlocks::Draw record = UniformBlocks::Draw();
+            getRecord(record, model, prop, shape->meshes[i]->enabled);
+
+            //a mesh's record only changes when it moves, is toggled or its VoxProperties change
+            if(rebuilt || memcmp(&record, &list->records[draw], sizeof(record)) != 0)
+            {
+                list->records[draw] = record;
+                firstChanged = std::min(firstChanged, draw);
+                lastChanged = draw;
+            }
+        }
+    }
+
+    if(firstChanged < list->records.size())
+    {
+        size_t size = (lastChanged + 1 - firstChanged) * sizeof(UniformBlocks::Draw);
+        glBindBuffer(GL_TEXTURE_BUFFER, list->tableBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, firstChanged * sizeof(UniformBlocks::Draw), size, &list->records[firstChanged]);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+}
+
+void DrawList::Commands::render()
+{
+    if(list->indexCount == 0) return;
+
+    assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    GLState::bindTexture(UniformBlocks::DRAW_TABLE_UNIT, GL_TEXTURE_BUFFER, list->tableTexture);
+    GLState::bindVertexArray(list->vao);
+    glDrawElements(GL_TRIANGLES, GLsizei(list->indexCount), list->indexType, 0);
+    glError();
+}
+
+void DrawList::Commands::build()
+{
+    std::vector<VertexData> vertices;
+    std::vector<GLuint> drawIndices;
+    std::vector<unsigned int> indices;
+    for(size_t draw = 0; draw < list->meshes.size(); ++draw)
+    {
+        const Mesh* mesh = list->meshes[draw];
+        unsigned int base = (unsigned int)vertices.size();
+        for(unsigned int index : mesh->getIndices())
+        {
+            indices.push_back(base + index);
+        }
+        vertices.insert(vertices.end(), mesh->getVertexData().begin(), mesh->getVertexData().end());
+        drawIndices.resize(vertices.size(), GLuint(draw));
+    }
+    list->indexCount = indices.size();
+
+    if(list->vao == 0)
+    {
+        glGenVertexArrays(1, &list->vao);
+        glGenBuffers(1, &list->vbo);
+        glGenBuffers(1, &list->drawIndexBuffer);
+        glGenBuffers(1, &list->ebo);
+        glGenBuffers(1, &list->tableBuffer);
+        glGenTextures(1, &list->tableTexture);
+    }
+
+    GLState::bindVertexArray(list->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, list->vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexData), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(Primitive::Commands::POSITION_LOCATION);
+    glVertexAttribPointer(Primitive::Commands::POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (GLvoid*)offsetof(VertexData, position));
+    glEnableVertexAttribArray(Primitive::Commands::NORMALS_LOCATION);
+    glVertexAttribPointer(Primitive::Commands::NORMALS_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (GLvoid*)offsetof(VertexData, normal));
+    glEnableVertexAttribArray(Primitive::Commands::TEXTURE_LOCATION);
+    glVertexAttribPointer(Primitive::Commands::TEXTURE_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), (GLvoid*)offsetof(VertexData, texCoord));
+
+    glBindBuffer(GL_ARRAY_BUFFER, list->drawIndexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, drawIndices.size() * sizeof(GLuint), drawIndices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(DRAW_INDEX_LOCATION);
+    glVertexAttribIPointer(DRAW_INDEX_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), (GLvoid*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, list->ebo);
+    list->indexType = GL_UNSIGNED_INT;
+#if __SHORT_INDICES
+    if(vertices.size() <= 65536)
+    {
+        list->indexType = GL_UNSIGNED_SHORT;
+    }
+#endif
+    if(list->indexType == GL_UNSIGNED_SHORT)
+    {
+        std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), shortIndices.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    }
+
+    //filled by the update() that built it
+    list->records.assign(list->meshes.size(), UniformBlocks::Draw());
+    glBindBuffer(GL_TEXTURE_BUFFER, list->tableBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, list->records.size() * sizeof(UniformBlocks::Draw), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    GLState::bindTexture(UniformBlocks::DRAW_TABLE_UNIT, GL_TEXTURE_BUFFER, list->tableTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, list->tableBuffer);
+    glError();
+}
+
+void DrawList::Commands::getRecord(UniformBlocks::Draw& record, const glm::mat4& model, const VoxProperties& voxProperties, bool enabled)
+{
+    record.M = enabled ? model : glm::mat4(0.0f);
+    record.diffuseColor = voxProperties.diffuseColor;
+    record.specularColor = voxProperties.specularColor;
+    record.emissivity = voxProperties.emissivity;
+    record.specularReflectivity = voxProperties.specularReflectivity;
+    record.specularDiffusion = voxProperties.specularDiffusion;
+    record.transparency = voxProperties.transparency;
+    record.refractiveIndex = voxProperties.refractiveIndex;
+    record.diffuseReflectivity = voxProperties.diffuseReflectivity;
+}
+
+void DrawList::Commands::destroyBuffers()
+{
+    if(list->vao == 0) return;
+
+    glDeleteBuffers(1, &list->vbo);
+    glDeleteBuffers(1, &list->drawIndexBuffer);
+    glDeleteBuffers(1, &list->ebo);
+    glDeleteBuffers(1, &list->tableBuffer);
+    GLState::deletedTexture(list->tableTexture);
+    glDeleteTextures(1, &list->tableTexture);
+    GLState::deletedVertexArray(list->vao);
+    glDeleteVertexArrays(1, &list->vao);
+    list->vao = 0;
+}
+
+DrawList::Commands::~Commands()
+{
+}
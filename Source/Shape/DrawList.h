@@ -0,0 +1,78 @@
+//
+//  DrawList.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include "OpenGL_Includes.h"
+#include "Graphic/Material/UniformBlocks.h"
+#include "Graphic/Material/Voxelization/VoxelizationMaterial.h"
+#include <vector>
+#include <stddef.h>
+
+class Scene;
+class Mesh;
+
+/// <summary> Every mesh of a scene merged into one vertex and one index buffer, so a pass draws all of them with a
+/// single glDrawElements whatever the number of shapes.  Indices are offset to the merged vertices and every vertex
+/// carries the index of its mesh in an extra attribute (DRAW_INDEX_LOCATION), which the vertex shaders use to fetch
+/// the mesh's model matrix and VoxProperties from a texture buffer, the draw table (Shaders/Common/drawTable.glsl).
+/// GL 4.1 has no base instance or multi draw indirect to pick the record with, hence the attribute.
+/// The buffers are built again when the scene's meshes change, records only go up when a shape moves or its
+/// VoxProperties do.  Disabled meshes get a zero model matrix, their triangles collapse to a point and draw
+/// nothing. </summary>
+class DrawList
+{
+public:
+
+    class Commands
+    {
+    public:
+        explicit Commands(DrawList* list);
+
+        /// <summary> Merges the scene's meshes if they aren't the ones merged last time and uploads the records that
+        /// changed. </summary>
+        void update(Scene& scene);
+
+        /// <summary> Every mesh, with whatever material and uniform blocks are bound. </summary>
+        void render();
+
+        void destroyBuffers();
+
+        ~Commands();
+
+    private:
+        void build();
+        void getRecord(UniformBlocks::Draw& record, const glm::mat4& model, const VoxProperties& voxProperties, bool enabled);
+
+        DrawList* list = nullptr;
+    };
+
+    static const GLuint DRAW_INDEX_LOCATION = 3;
+
+    DrawList();
+    ~DrawList();
+
+    /// <summary> Merges the meshes again on the next update(), for when a scene was swapped for another one and new
+    /// meshes may have the addresses of the old ones. </summary>
+    inline void invalidate(){ meshes.clear(); }
+
+    inline size_t getDrawCount() const { return meshes.size(); }
+
+private:
+    DrawList(DrawList& rhs);
+
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint drawIndexBuffer = 0;
+    GLuint ebo = 0;
+    GLuint tableBuffer = 0;
+    GLuint tableTexture = 0;
+    size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT; //what the element buffer holds, like Primitive::indexType
+
+    //what the buffers were built from and what the GPU copy of the table holds
+    std::vector<Mesh*> meshes;
+    std::vector<UniformBlocks::Draw> records;
+};
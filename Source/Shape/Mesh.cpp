@@ -1,12 +1,18 @@
 
 
 #include "OpenGL_Includes.h"
+
+//weld, Tipsify and overdraw sort every mesh parsed from an .obj and print its ACMR/ATVR before and after, see MeshOptimizer.h
+#define __SHAPE_OPTIMIZE_MESHES 1
 
 #include "glm/gtc/type_ptr.hpp"
 
 #include "Mesh.h"
 #include "Scene.h"
 #include "Graphic/Material/Voxelization/VoxelizationConeTracingMaterial.h"
+#include "MeshOptimizer.h"
+
+#include <iostream>
 
 
 Mesh::Mesh()
@@ -55,10 +61,39 @@ Mesh::Mesh(const tinyobj::shape_t& shape)
         vertexData[j].texCoord.y = shape.mesh.texcoords[i + 1];
     }
     
+    name = shape.name;
+    
+#if __SHAPE_OPTIMIZE_MESHES
+    optimization = MeshOptimizer::optimize(vertexData, indices);
+    printOptimization();
+#endif
+    
+    glError();
+    setupMeshRenderer();
+}
+
+Mesh::Mesh(const VertexData* vertices, size_t vertexCount, const unsigned int* _indices, size_t indexCount,
+           const MeshOptimizer::Result& _optimization)
+:program(0), optimization(_optimization)
+{
+    vertexData.assign(vertices, vertices + vertexCount);
+    indices.assign(_indices, _indices + indexCount);
+    
     glError();
     setupMeshRenderer();
 }
 
+void Mesh::printOptimization() const
+{
+    if(optimization.verticesBefore == 0) return;
+    
+    std::streamsize precision = std::cout.precision(3);
+    std::cout << " - Mesh '" << name << "': ACMR " << optimization.before.acmr << " -> " << optimization.after.acmr
+              << ", ATVR " << optimization.before.atvr << " -> " << optimization.after.atvr << ", "
+              << optimization.verticesBefore << " -> " << optimization.verticesAfter << " vertices." << std::endl;
+    std::cout.precision(precision);
+}
+
 void Mesh::setupMeshRenderer()
 {
     glError();
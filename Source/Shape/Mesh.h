@@ -4,6 +4,7 @@
 #include "Utility/External/tiny_obj/tiny_obj_loader.h"
 #include "Shape/Transform.h"
 #include "Graphic/Material/Voxelization/VoxelizationConeTracingMaterial.h"
+#include "Shape/MeshOptimizer.h"
 
 class Mesh : protected Primitive
 {
@@ -23,7 +24,23 @@ public:
     void render(Scene& scene, ShaderParameter::ShaderParamsGroup& group, Material::Commands* commands);
     virtual void render(ShaderParameter::ShaderParamsGroup& group, Material::Commands& commands);
     
+    ///<summary> Draws with whatever the bound material and uniform blocks hold, uploads nothing. </summary>
+    void render();
+    
+    inline const std::vector<VertexData>& getVertexData() const { return vertexData; }
+    inline const std::vector<unsigned int>& getIndices() const { return indices; }
+    
+    ///<summary> What MeshOptimizer did to the mesh when it was parsed, MeshCache keeps it with the mesh. </summary>
+    inline const MeshOptimizer::Result& getOptimization() const { return optimization; }
+    
+    ///<summary> Prints the mesh's ACMR/ATVR before and after MeshOptimizer, nothing for a mesh it didn't run on. </summary>
+    void printOptimization() const;
+    
     Mesh(const tinyobj::shape_t& shape);
+    
+    ///<summary> Takes vertices and indices that are already laid out for the GPU, see MeshCache. </summary>
+    Mesh(const VertexData* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+         const MeshOptimizer::Result& optimization = MeshOptimizer::Result());
     Mesh();
     ~Mesh();
     
@@ -36,10 +53,11 @@ public:
 	int program;
     
 protected:
-    void render();
     virtual void setupMeshRenderer();
     
 private:
+    MeshOptimizer::Result optimization;
+    
     Mesh(Mesh& mesh);
 private:
 	static unsigned int idCounter;
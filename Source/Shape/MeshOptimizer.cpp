@@ -0,0 +1,295 @@
+//
+//  MeshOptimizer.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "MeshOptimizer.h"
+#include "Utility/MappedFile.h"
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstring>
+
+const unsigned int MeshOptimizer::CACHE_SIZE;
+const float MeshOptimizer::OVERDRAW_THRESHOLD = 1.05f;
+
+namespace
+{
+    //a vertex is in the FIFO while fewer than CACHE_SIZE misses happened since it went in
+    class FifoCache
+    {
+    public:
+        FifoCache(size_t vertexCount):
+        stamps(vertexCount, 0)
+        {
+        }
+
+        inline bool miss(unsigned int vertex)
+        {
+            if(time - stamps[vertex] < MeshOptimizer::CACHE_SIZE) return false;
+            stamps[vertex] = time++;
+            return true;
+        }
+
+        inline void flush(){ time += MeshOptimizer::CACHE_SIZE; }
+
+    private:
+        std::vector<unsigned int> stamps;
+        unsigned int time = MeshOptimizer::CACHE_SIZE;
+    };
+}
+
+MeshOptimizer::Result MeshOptimizer::optimize(std::vector<VertexData>& vertices, std::vector<unsigned int>& indices)
+{
+    Result result;
+    result.verticesBefore = result.verticesAfter = vertices.size();
+    if(indices.empty() || indices.size() % 3 != 0) return result;
+
+    result.before = analyze(indices, vertices.size());
+
+    deduplicate(vertices, indices);
+
+    std::vector<size_t> clusters;
+    optimizeVertexCache(indices, vertices.size(), clusters);
+    optimizeOverdraw(indices, vertices, clusters, analyze(indices, vertices.size()).acmr * OVERDRAW_THRESHOLD);
+
+    optimizeVertexFetch(vertices, indices);
+
+    result.after = analyze(indices, vertices.size());
+    result.verticesAfter = vertices.size();
+    return result;
+}
+
+MeshOptimizer::Statistics MeshOptimizer::analyze(const std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    Statistics statistics;
+    if(indices.empty()) return statistics;
+
+    FifoCache cache(vertexCount);
+    std::vector<bool> used(vertexCount, false);
+    size_t misses = 0, usedCount = 0;
+    for(unsigned int index : indices)
+    {
+        misses += cache.miss(index);
+        if(!used[index])
+        {
+            used[index] = true;
+            ++usedCount;
+        }
+    }
+
+    statistics.acmr = float(misses) / float(indices.size() / 3);
+    statistics.atvr = float(misses) / float(usedCount);
+    return statistics;
+}
+
+void MeshOptimizer::deduplicate(const std::vector<VertexData>& vertices, std::vector<unsigned int>& indices)
+{
+    auto hash = [&vertices](unsigned int vertex)
+    {
+        return size_t(MappedFile::hash(reinterpret_cast<const unsigned char*>(&vertices[vertex]), sizeof(VertexData)));
+    };
+    auto equal = [&vertices](unsigned int a, unsigned int b)
+    {
+        return memcmp(&vertices[a], &vertices[b], sizeof(VertexData)) == 0;
+    };
+
+    std::unordered_map<unsigned int, unsigned int, decltype(hash), decltype(equal)> first(vertices.size(), hash, equal);
+    std::vector<unsigned int> remap(vertices.size());
+    for(unsigned int vertex = 0; vertex < vertices.size(); ++vertex)
+    {
+        remap[vertex] = first.insert(std::make_pair(vertex, vertex)).first->second;
+    }
+
+    for(unsigned int& index : indices)
+    {
+        index = remap[index];
+    }
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, std::vector<size_t>& clusters)
+{
+    size_t triangleCount = indices.size() / 3;
+
+    //triangles around every vertex, and how many of them haven't been emitted yet
+    std::vector<unsigned int> live(vertexCount, 0);
+    for(unsigned int index : indices) ++live[index];
+    std::vector<size_t> offsets(vertexCount + 1, 0);
+    for(size_t vertex = 0; vertex < vertexCount; ++vertex) offsets[vertex + 1] = offsets[vertex] + live[vertex];
+    std::vector<unsigned int> adjacency(indices.size());
+    {
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for(size_t i = 0; i < indices.size(); ++i) adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+    }
+
+    std::vector<unsigned int> stamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnds, candidates, output;
+    deadEnds.reserve(indices.size());
+    output.reserve(indices.size());
+    unsigned int time = CACHE_SIZE + 1;
+    size_t cursor = 0;
+
+    clusters.assign(1, 0);
+    long fanning = vertexCount > 0 ? 0 : -1;
+    while(fanning >= 0)
+    {
+        //emit every triangle left around the fanning vertex
+        candidates.clear();
+        for(size_t k = offsets[fanning]; k < offsets[fanning + 1]; ++k)
+        {
+            unsigned int triangle = adjacency[k];
+            if(emitted[triangle]) continue;
+
+            for(size_t corner = 0; corner < 3; ++corner)
+            {
+                unsigned int vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if(time - stamps[vertex] > CACHE_SIZE)
+                {
+                    stamps[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        //next: the candidate that's been in the cache longest but will still be there after its fan is emitted
+        fanning = -1;
+        unsigned int bestPriority = 0;
+        for(unsigned int vertex : candidates)
+        {
+            if(live[vertex] == 0) continue;
+
+            unsigned int priority = 0;
+            if(time - stamps[vertex] + 2 * live[vertex] <= CACHE_SIZE)
+            {
+                priority = time - stamps[vertex];
+            }
+            if(fanning < 0 || priority > bestPriority)
+            {
+                fanning = vertex;
+                bestPriority = priority;
+            }
+        }
+        if(fanning >= 0) continue;
+
+        //dead end: the most recent vertex with triangles left, or the first one in input order
+        while(!deadEnds.empty() && fanning < 0)
+        {
+            unsigned int vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if(live[vertex] > 0) fanning = vertex;
+        }
+        for(; fanning < 0 && cursor < vertexCount; ++cursor)
+        {
+            if(live[cursor] > 0) fanning = long(cursor);
+        }
+
+        if(fanning >= 0 && output.size() / 3 != clusters.back())
+        {
+            clusters.push_back(output.size() / 3);
+        }
+    }
+
+    indices.swap(output);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<VertexData>& vertices,
+                                     const std::vector<size_t>& hardClusters, float threshold)
+{
+    size_t triangleCount = indices.size() / 3;
+
+    //soft boundaries: start a new cluster once this one has paid off the cache misses of starting cold
+    std::vector<size_t> clusters;
+    FifoCache cache(vertices.size());
+    for(size_t c = 0; c < hardClusters.size(); ++c)
+    {
+        size_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+        size_t start = hardClusters[c], misses = 0;
+        clusters.push_back(start);
+        cache.flush();
+        for(size_t triangle = start; triangle < end; ++triangle)
+        {
+            for(size_t corner = 0; corner < 3; ++corner)
+            {
+                misses += cache.miss(indices[triangle * 3 + corner]);
+            }
+            if(triangle + 1 < end && float(misses) <= threshold * float(triangle + 1 - start))
+            {
+                start = triangle + 1;
+                misses = 0;
+                clusters.push_back(start);
+                cache.flush();
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    //area weighted centroid and normal of every cluster and of the whole mesh
+    size_t clusterCount = clusters.size() - 1;
+    std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f)), normals(clusterCount, glm::vec3(0.0f));
+    std::vector<float> areas(clusterCount, 0.0f);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for(size_t c = 0; c < clusterCount; ++c)
+    {
+        for(size_t triangle = clusters[c]; triangle < clusters[c + 1]; ++triangle)
+        {
+            const glm::vec3& a = vertices[indices[triangle * 3 + 0]].position;
+            const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[triangle * 3 + 2]].position;
+            glm::vec3 normal = glm::cross(b - a, d - a);
+            float area = glm::length(normal) * 0.5f;
+            centroids[c] += (a + b + d) * (area / 3.0f);
+            normals[c] += normal;
+            areas[c] += area;
+        }
+        meshCentroid += centroids[c];
+        meshArea += areas[c];
+    }
+    if(meshArea > 0.0f) meshCentroid /= meshArea;
+
+    std::vector<float> facing(clusterCount, 0.0f);
+    for(size_t c = 0; c < clusterCount; ++c)
+    {
+        float length = glm::length(normals[c]);
+        if(areas[c] > 0.0f && length > 0.0f)
+        {
+            facing[c] = glm::dot(centroids[c] / areas[c] - meshCentroid, normals[c] / length);
+        }
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&facing](size_t a, size_t b){ return facing[a] > facing[b]; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indices.size());
+    for(size_t c : order)
+    {
+        sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+    indices.swap(sorted);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<VertexData>& vertices, std::vector<unsigned int>& indices)
+{
+    const unsigned int UNUSED = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> remap(vertices.size(), UNUSED);
+    std::vector<VertexData> ordered;
+    ordered.reserve(vertices.size());
+    for(unsigned int& index : indices)
+    {
+        if(remap[index] == UNUSED)
+        {
+            remap[index] = (unsigned int)ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
@@ -0,0 +1,63 @@
+//
+//  MeshOptimizer.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+#include "VertexData.h"
+
+/// <summary> Reorders a triangle list at load time so the GPU transforms, shades and fetches less of it.  optimize()
+/// welds vertices that are identical in every attribute (tinyobj only welds within a face group), orders triangles
+/// with Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw") for
+/// a FIFO post transform cache of CACHE_SIZE entries, cuts that order into clusters and sorts them so the ones facing
+/// away from the mesh's center, which tend to hide the rest, draw first, then renumbers vertices in the order they're
+/// first used so fetches walk the vertex buffer forward.  The result draws the same triangles. </summary>
+class MeshOptimizer
+{
+public:
+    static const unsigned int CACHE_SIZE = 16;
+
+    /// <summary> ACMR is transformed vertices per triangle (0.5 at best, 3 at worst), ATVR transformed vertices per
+    /// vertex (1 at best), both on a FIFO cache of CACHE_SIZE entries. </summary>
+    struct Statistics
+    {
+        float acmr = 0.0f;
+        float atvr = 0.0f;
+    };
+
+    struct Result
+    {
+        Statistics before;
+        Statistics after;
+        size_t verticesBefore = 0;
+        size_t verticesAfter = 0;
+    };
+
+    /// <summary> Runs every step below in order, leaves lists that aren't made of triangles alone. </summary>
+    static Result optimize(std::vector<VertexData>& vertices, std::vector<unsigned int>& indices);
+
+    static Statistics analyze(const std::vector<unsigned int>& indices, size_t vertexCount);
+
+    /// <summary> Points indices at the first of every group of bitwise identical vertices, leaving the others unused
+    /// until optimizeVertexFetch() drops them. </summary>
+    static void deduplicate(const std::vector<VertexData>& vertices, std::vector<unsigned int>& indices);
+
+    /// <summary> Tipsify.  clusters gets the first triangle of every run that started at a dead end, where the cache
+    /// holds nothing of what came before, those are free to move. </summary>
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, std::vector<size_t>& clusters);
+
+    /// <summary> Splits the clusters further wherever their ACMR so far is at most threshold, then sorts them by how
+    /// far out they face, outermost first. </summary>
+    static void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<VertexData>& vertices,
+                                 const std::vector<size_t>& clusters, float threshold);
+
+    /// <summary> Renumbers vertices in order of first use and drops the unused ones. </summary>
+    static void optimizeVertexFetch(std::vector<VertexData>& vertices, std::vector<unsigned int>& indices);
+
+private:
+    //the overdraw clusters may cost this much more ACMR than Tipsify's order
+    static const float OVERDRAW_THRESHOLD;
+};
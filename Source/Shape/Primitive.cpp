@@ -7,13 +7,14 @@
 //
 
 #include "Primitive.h"
+#include "Graphic/GLState.h"
 
 
 Primitive::Commands::Commands(Primitive* _primitive)
 {
     primitive = _primitive;
     initBuffers();
-    glBindVertexArray(primitive->vao);
+    GLState::bindVertexArray(primitive->vao);
 }
 
 void Primitive::Commands::uploadGPUVertexData()
@@ -39,8 +40,19 @@ void Primitive::Commands::uploadGPUIndexData()
 {
     if(primitive->indices.size() != 0)
     {
+        GLenum usage = primitive->staticMesh ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, primitive->ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, primitive->indices.size() * sizeof(unsigned int), primitive->indices.data(), primitive->staticMesh ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+#if __SHORT_INDICES
+        if(primitive->vertexData.size() <= 65536)
+        {
+            std::vector<GLushort> shortIndices(primitive->indices.begin(), primitive->indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), shortIndices.data(), usage);
+            primitive->indexType = GL_UNSIGNED_SHORT;
+            return;
+        }
+#endif
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, primitive->indices.size() * sizeof(unsigned int), primitive->indices.data(), usage);
+        primitive->indexType = GL_UNSIGNED_INT;
     }
 
 }
@@ -55,7 +67,7 @@ void Primitive::Commands::uploadGPURenderingData()
 void Primitive::Commands::render()
 {
     assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
-    glDrawElements(GL_TRIANGLES, primitive->indices.size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, primitive->indices.size(), primitive->indexType, 0);
     glError();
 }
 
@@ -73,12 +85,13 @@ void Primitive::Commands::destroyBuffers()
 {
     glDeleteBuffers(1, &primitive->vbo);
     glDeleteBuffers(1, &primitive->ebo);
+    GLState::deletedVertexArray(primitive->vao);
     glDeleteVertexArrays(1, &primitive->vao);
 }
 
 void Primitive::Commands::end()
 {
-    glBindVertexArray(0);
+    //the vertex array stays bound, the next Commands only switches it if it's a different one
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
@@ -12,6 +12,8 @@
 #include <vector>
 #include "VertexData.h"
 
+#define __SHORT_INDICES 1 /* Uploads 16 bit indices for primitives (and DrawList's merged meshes) with at most 65536 vertices, the CPU copy stays 32 bit. */
+
 //Primitive family of classes holds data and makes use of the Primitive::Commands family of classes
 //to render it's data
 class Primitive
@@ -52,6 +54,7 @@ protected:
     bool staticMesh = true;
     unsigned int vao;
     unsigned int vbo, ebo; // Vertex Buffer Object, Vertex Array Object, Element Buffer Object.
+    GLenum indexType = GL_UNSIGNED_INT; // What the element buffer holds, set when the indices are uploaded.
     std::vector<VertexData> vertexData;
     std::vector<unsigned int> indices;
 
@@ -54,5 +54,5 @@ Primitive::Commands(_quad)
 
 void ScreenQuand::Commands::render()
 {
-    glDrawElements(GL_TRIANGLE_STRIP, quad->indices.size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLE_STRIP, quad->indices.size(), quad->indexType, 0);
 }
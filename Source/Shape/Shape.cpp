@@ -9,6 +9,8 @@
 #include "Shape.h"
 #include "Mesh.h"
 #include "Graphic/Material/MaterialStore.h"
+#include <algorithm>
+#include <limits>
 
 Shape::Shape()
 {
@@ -19,6 +21,14 @@ Shape::Shape(std::vector<tinyobj::shape_t>& shapes)
     loadMesh(shapes);
 }
 
+Shape::Shape(const std::vector<Mesh*>& _meshes, const glm::vec3& _localBoundsMin, const glm::vec3& _localBoundsMax):
+meshes(_meshes),
+localBoundsValid(true),
+localBoundsMin(_localBoundsMin),
+localBoundsMax(_localBoundsMax)
+{
+}
+
 void Shape::loadMesh(std::vector<tinyobj::shape_t> &shapes)
 {
     for (const tinyobj::shape_t & shape : shapes)
@@ -42,6 +52,77 @@ void Shape::render(Scene& scene, ShaderParameter::ShaderParamsGroup& group, Mate
     }
 }
 
+unsigned int Shape::getDirtyFlags()
+{
+    unsigned int flags = dirtyFlags;
+    
+    if(active != cleanActive || transform.getTransformMatrix() != cleanTransform)
+    {
+        flags |= TRANSFORM_DIRTY;
+    }
+    
+    if(defaultVoxProperties != cleanVoxProperties || meshProperties.size() != cleanMeshProperties.size() ||
+       !std::equal(meshProperties.begin(), meshProperties.end(), cleanMeshProperties.begin()))
+    {
+        flags |= VOX_PROPERTIES_DIRTY;
+    }
+    
+    return flags;
+}
+
+void Shape::clearDirtyFlags()
+{
+    dirtyFlags = CLEAN;
+    cleanActive = active;
+    cleanTransform = transform.getTransformMatrix();
+    cleanVoxProperties = defaultVoxProperties;
+    cleanMeshProperties = meshProperties;
+    getWorldBounds(cleanBoundsMin, cleanBoundsMax);
+}
+
+void Shape::computeLocalBounds()
+{
+    localBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+    localBoundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for(Mesh* mesh : meshes)
+    {
+        for(const VertexData& vertex : mesh->getVertexData())
+        {
+            localBoundsMin = glm::min(localBoundsMin, vertex.position);
+            localBoundsMax = glm::max(localBoundsMax, vertex.position);
+        }
+    }
+    localBoundsValid = true;
+}
+
+void Shape::getWorldBounds(glm::vec3& minCorner, glm::vec3& maxCorner)
+{
+    if(!localBoundsValid)
+    {
+        computeLocalBounds();
+    }
+    
+    minCorner = glm::vec3(std::numeric_limits<float>::max());
+    maxCorner = glm::vec3(-std::numeric_limits<float>::max());
+    if(localBoundsMin.x > localBoundsMax.x)
+    {
+        //no vertices, return an empty box
+        minCorner = maxCorner = glm::vec3(0.0f);
+        return;
+    }
+    
+    const glm::mat4& model = transform.getTransformMatrix();
+    for(int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner((i & 1) ? localBoundsMax.x : localBoundsMin.x,
+                         (i & 2) ? localBoundsMax.y : localBoundsMin.y,
+                         (i & 4) ? localBoundsMax.z : localBoundsMin.z);
+        glm::vec3 worldCorner = glm::vec3(model * glm::vec4(corner, 1.0f));
+        minCorner = glm::min(minCorner, worldCorner);
+        maxCorner = glm::max(maxCorner, worldCorner);
+    }
+}
+
 Shape::~Shape()
 {
     for(Mesh* mesh: meshes)
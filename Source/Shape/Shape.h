@@ -35,8 +35,32 @@ public:
     
     void setVoxProperites(VoxelizationMaterial::VoxProperties &voxProperties);
     
+    enum DirtyFlags
+    {
+        CLEAN = 0,
+        TRANSFORM_DIRTY = 1 << 0,       //also set when the shape is activated or deactivated
+        VOX_PROPERTIES_DIRTY = 1 << 1
+    };
+    
+    /// <summary> Returns what changed since the last clearDirtyFlags() call.  Transform and properties are public and
+    /// scenes modify them directly, so changes are found by comparing against a snapshot instead of through setters. </summary>
+    unsigned int getDirtyFlags();
+    inline void markDirty(unsigned int flags){ dirtyFlags |= flags; }
+    
+    /// <summary> Snapshots the current state, called once the voxel volume reflects this shape. </summary>
+    void clearDirtyFlags();
+    
+    /// <summary> World space bounds with the current transform. </summary>
+    void getWorldBounds(glm::vec3& minCorner, glm::vec3& maxCorner);
+    
+    /// <summary> World space bounds at the time of the last clearDirtyFlags() call, where the shape was last voxelized. </summary>
+    inline void getCleanWorldBounds(glm::vec3& minCorner, glm::vec3& maxCorner) const { minCorner = cleanBoundsMin; maxCorner = cleanBoundsMax; }
+    
     Shape();
     Shape(std::vector<tinyobj::shape_t>& shapes);
+    
+    /// <summary> Takes meshes that were already built and the bounds of their vertices, see MeshCache. </summary>
+    Shape(const std::vector<Mesh*>& meshes, const glm::vec3& localBoundsMin, const glm::vec3& localBoundsMax);
     virtual ~Shape();
     
 public:
@@ -46,8 +70,20 @@ public:
     
 protected:
     void loadMesh(std::vector<tinyobj::shape_t>& shapes );
+    void computeLocalBounds();
     
 protected:
+    unsigned int dirtyFlags = TRANSFORM_DIRTY | VOX_PROPERTIES_DIRTY;
+    glm::mat4 cleanTransform;
+    bool cleanActive = false;
+    VoxProperties cleanVoxProperties;
+    std::vector<VoxProperties> cleanMeshProperties;
+    glm::vec3 cleanBoundsMin = glm::vec3(0.0f);
+    glm::vec3 cleanBoundsMax = glm::vec3(0.0f);
+    
+    bool localBoundsValid = false;
+    glm::vec3 localBoundsMin;
+    glm::vec3 localBoundsMax;
 
     
     
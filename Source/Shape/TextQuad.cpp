@@ -11,6 +11,9 @@
 #include "Material.h"
 #include "MaterialStore.h"
 #include "FBO_2D.h"
+#include "Time/Profiler.h"
+#include <cstdlib>
+#include <iostream>
 
 
 TextQuad::TextQuad(glm::vec2 & _dimensions):
@@ -43,19 +46,34 @@ void TextQuad::loadTextures()
     int result = FT_Init_FreeType(&ft);
     assert(result == 0 && "FreeType Library failed to initialize");
     
+    //VCT_FONT wins, otherwise the first font found of the ones that ship with the OS
+    const char* fonts[] =
+    {
+        std::getenv("VCT_FONT"),
 #ifdef __APPLE__
-    
-    // this font comes with MacOS X
-    result = FT_New_Face(ft, "/Library/Fonts/Devanagari Sangam MN.ttc", 0, &face);
-    
+        // this font comes with MacOS X
+        "/Library/Fonts/Devanagari Sangam MN.ttc",
 #else
-    //other platforms not supported
-    #error "If you would like text to render on screen, you'll need to specify a .ttc file on your computer where the font comes from"
-
+        "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/TTF/DejaVuSans.ttf",
+        "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
 #endif
+    };
     
+    result = -1;
+    for(const char* font : fonts)
+    {
+        if(font != nullptr && (result = FT_New_Face(ft, font, 0, &face)) == 0) break;
+    }
     
-    assert(result == 0 && "FreeType font not found");
+    if(result != 0)
+    {
+        //build machines don't always have fonts, text just doesn't show up there
+        std::cerr << "TextQuad: no font found, set VCT_FONT to a .ttf/.ttc file to see text on screen." << std::endl;
+        FT_Done_FreeType(ft);
+        return;
+    }
     FT_Set_Pixel_Sizes(face, 0, 48);
     
     for(GLubyte c = 0; c < 128; c++)
@@ -139,6 +157,9 @@ void TextQuad::setupMeshRenderer()
 
 void TextQuad::print(std::string& text, glm::vec2 position)
 {
+    if(characters.empty()) return;
+    
+    Profiler::Scope profile("text");
     FBO::Commands fboCommands(FBO_2D::getDefault().get());
     
     fboCommands.enableDepthTest(false);
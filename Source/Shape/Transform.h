@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <ostream>
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
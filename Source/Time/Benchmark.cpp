@@ -0,0 +1,304 @@
+//
+//  Benchmark.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "Benchmark.h"
+#include "Application.h"
+#include "Profiler.h"
+#include "FrameRate.h"
+#include "Scene/Scene.h"
+#include "Graphic/Camera/CameraPath.h"
+#include "glm/gtc/constants.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    const char* SCENES[] = { "cornell", "glass", "dragon", "multiple" };
+}
+
+Benchmark::Benchmark(const Settings& _settings):
+settings(_settings)
+{
+}
+
+const char* Benchmark::getModeName(Graphics::RenderingMode mode)
+{
+    using GRM = Graphics::RenderingMode;
+    switch(mode)
+    {
+        case GRM::VOXELIZATION_VISUALIZATION:       return "voxel-visualization";
+        case GRM::VOXEL_CONE_TRACING:               return "cone-tracing";
+        case GRM::VOXEL_CONE_TRACING_HALF_RESOLUTION:    return "cone-tracing-half";
+        case GRM::VOXEL_CONE_TRACING_QUARTER_RESOLUTION: return "cone-tracing-quarter";
+        case GRM::ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_0: return "depth-layer-0";
+        case GRM::ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_1: return "depth-layer-1";
+        case GRM::ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_2: return "depth-layer-2";
+        case GRM::ORTHOGRAPHIC_DEPTH_BUFFER_LAYER_3: return "depth-layer-3";
+        default:                                    return "unknown";
+    }
+}
+
+double Benchmark::percentile(const std::vector<double>& sortedTimes, double fraction)
+{
+    if(sortedTimes.empty()) return 0.0;
+
+    size_t rank = size_t(std::ceil(fraction * double(sortedTimes.size())));
+    return sortedTimes[std::min(std::max(rank, size_t(1)), sortedTimes.size()) - 1];
+}
+
+int Benchmark::run(Application& application)
+{
+    std::vector<Result> results;
+    for(const char* name : SCENES)
+    {
+        if(!settings.scene.empty() && settings.scene != name) continue;
+
+        delete application.scene;
+        application.scene = Application::createScene(name);
+        application.scene->init(settings.width, settings.height);
+
+        Camera* camera = application.scene->renderingCamera;
+        CameraPath path;
+        if(!path.load(std::string("/Assets/CameraPaths/") + name + ".path"))
+        {
+            std::cout << "Benchmark: no camera path for " << name << ", swaying around the start position." << std::endl;
+            path = CameraPath::sway(camera->position, camera->forward, 4.0f, glm::radians(20.0f));
+        }
+
+        for(int mode = 0; mode < int(Graphics::RenderingMode::RENDER_MODE_TOTAL); ++mode)
+        {
+            Result result = measure(application, name, Graphics::RenderingMode(mode), path);
+            std::cout << "Benchmark: " << std::left << std::setw(10) << result.scene << std::setw(22) << result.mode << std::right
+                      << std::fixed << std::setprecision(3) << "min " << result.min << "  avg " << result.average
+                      << "  p95 " << result.p95 << "  p99 " << result.p99 << " ms" << std::endl;
+            results.push_back(result);
+        }
+    }
+
+    if(results.empty())
+    {
+        std::cerr << "Benchmark: no scene called '" << settings.scene << "'." << std::endl;
+        return -1;
+    }
+
+    writeCSV(settings.report + ".csv", results);
+    writePassesCSV(settings.report + "-passes.csv", results);
+    writeJSON(settings.report + ".json", results);
+
+    if(settings.baseline.empty()) return 0;
+
+    std::vector<Result> baseline;
+    if(!readCSV(settings.baseline, baseline))
+    {
+        std::cerr << "Benchmark: could not read the baseline " << settings.baseline << std::endl;
+        return -1;
+    }
+    unsigned int regressions = compare(results, baseline, settings.threshold);
+    std::cout << "Benchmark: " << regressions << " regression(s) against " << settings.baseline << std::endl;
+    return int(regressions);
+}
+
+Benchmark::Result Benchmark::measure(Application& application, const std::string& scene, Graphics::RenderingMode mode, const CameraPath& path)
+{
+    Scene& renderingScene = *application.scene;
+    application.graphics.queueVoxelization();
+
+    std::vector<double> times;
+    times.reserve(settings.frames);
+    float duration = path.getDuration();
+
+    for(unsigned int frame = 0; frame < settings.warmupFrames + settings.frames; ++frame)
+    {
+        if(frame == settings.warmupFrames)
+        {
+            Profiler::flush();
+            Profiler::clear();
+        }
+
+        Profiler::beginFrame();
+        FrameRate::deltaTime = settings.deltaTime;
+        FrameRate::time = frame * settings.deltaTime;
+        FrameRate::framesPerSecond = 1.0 / settings.deltaTime;
+        {
+            Profiler::Scope profile("update");
+            renderingScene.update();
+            path.apply(duration > 0.0f ? fmodf(float(FrameRate::time), duration) : 0.0f, *renderingScene.renderingCamera);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        application.graphics.render(renderingScene, settings.width, settings.height, mode);
+        glFinish();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        FrameRate::frameCount++;
+        glError();
+        Profiler::endFrame();
+
+        if(frame >= settings.warmupFrames)
+        {
+            times.push_back(milliseconds);
+        }
+    }
+    Profiler::flush();
+
+    Result result;
+    result.scene = scene;
+    result.mode = getModeName(mode);
+    result.frames = (unsigned int)times.size();
+
+    std::sort(times.begin(), times.end());
+    double sum = 0.0;
+    for(double time : times) sum += time;
+    result.min = times.empty() ? 0.0 : times.front();
+    result.average = times.empty() ? 0.0 : sum / double(times.size());
+    result.p95 = percentile(times, 0.95);
+    result.p99 = percentile(times, 0.99);
+
+    unsigned int collected = std::max(Profiler::getCollectedFrames(), 1u);
+    for(const Profiler::Average& average : Profiler::getAverages())
+    {
+        result.passes.push_back({ average.name, average.depth, average.cpuTotal / collected, average.gpuTotal / collected });
+    }
+    return result;
+}
+
+bool Benchmark::writeCSV(const std::string& path, const std::vector<Result>& results)
+{
+    std::ofstream file(path);
+    file << "scene,mode,frames,min_ms,avg_ms,p95_ms,p99_ms" << std::endl;
+    file << std::fixed << std::setprecision(4);
+    for(const Result& result : results)
+    {
+        file << result.scene << "," << result.mode << "," << result.frames << "," << result.min << "," << result.average << ","
+             << result.p95 << "," << result.p99 << std::endl;
+    }
+
+    if(!file)
+    {
+        std::cerr << "Benchmark: could not write " << path << std::endl;
+        return false;
+    }
+    std::cout << "Benchmark: wrote " << path << std::endl;
+    return true;
+}
+
+bool Benchmark::writePassesCSV(const std::string& path, const std::vector<Result>& results)
+{
+    std::ofstream file(path);
+    file << "scene,mode,pass,depth,cpu_ms,gpu_ms" << std::endl;
+    file << std::fixed << std::setprecision(4);
+    for(const Result& result : results)
+    {
+        for(const Pass& pass : result.passes)
+        {
+            file << result.scene << "," << result.mode << "," << pass.name << "," << pass.depth << "," << pass.cpu << "," << pass.gpu << std::endl;
+        }
+    }
+
+    if(!file)
+    {
+        std::cerr << "Benchmark: could not write " << path << std::endl;
+        return false;
+    }
+    std::cout << "Benchmark: wrote " << path << std::endl;
+    return true;
+}
+
+bool Benchmark::writeJSON(const std::string& path, const std::vector<Result>& results)
+{
+    std::ofstream file(path);
+    file << std::fixed << std::setprecision(4);
+    file << "{\"results\":[";
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        file << (i == 0 ? "\n" : ",\n") << "{\"scene\":\"" << result.scene << "\",\"mode\":\"" << result.mode << "\",\"frames\":" << result.frames
+             << ",\"min_ms\":" << result.min << ",\"avg_ms\":" << result.average << ",\"p95_ms\":" << result.p95
+             << ",\"p99_ms\":" << result.p99 << ",\"passes\":[";
+        for(size_t p = 0; p < result.passes.size(); ++p)
+        {
+            const Pass& pass = result.passes[p];
+            file << (p == 0 ? "" : ",") << "{\"name\":\"" << pass.name << "\",\"depth\":" << pass.depth << ",\"cpu_ms\":" << pass.cpu
+                 << ",\"gpu_ms\":" << pass.gpu << "}";
+        }
+        file << "]}";
+    }
+    file << "\n]}" << std::endl;
+
+    if(!file)
+    {
+        std::cerr << "Benchmark: could not write " << path << std::endl;
+        return false;
+    }
+    std::cout << "Benchmark: wrote " << path << std::endl;
+    return true;
+}
+
+bool Benchmark::readCSV(const std::string& path, std::vector<Result>& results)
+{
+    std::ifstream file(path);
+    if(!file) return false;
+
+    results.clear();
+    std::string line;
+    std::getline(file, line); //header
+    while(std::getline(file, line))
+    {
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while(std::getline(stream, field, ','))
+        {
+            fields.push_back(field);
+        }
+        if(fields.size() < 7) continue;
+
+        Result result;
+        result.scene = fields[0];
+        result.mode = fields[1];
+        result.frames = (unsigned int)std::strtoul(fields[2].c_str(), nullptr, 10);
+        result.min = std::strtod(fields[3].c_str(), nullptr);
+        result.average = std::strtod(fields[4].c_str(), nullptr);
+        result.p95 = std::strtod(fields[5].c_str(), nullptr);
+        result.p99 = std::strtod(fields[6].c_str(), nullptr);
+        results.push_back(result);
+    }
+    return true;
+}
+
+unsigned int Benchmark::compare(const std::vector<Result>& results, const std::vector<Result>& baseline, double threshold)
+{
+    unsigned int regressions = 0;
+    for(const Result& result : results)
+    {
+        auto previous = std::find_if(baseline.begin(), baseline.end(), [&result](const Result& candidate)
+        {
+            return candidate.scene == result.scene && candidate.mode == result.mode;
+        });
+        if(previous == baseline.end())
+        {
+            std::cout << "Benchmark: " << result.scene << " " << result.mode << " isn't in the baseline." << std::endl;
+            continue;
+        }
+
+        //the 95th percentile catches hitches the average smooths over
+        bool slowerAverage = result.average > previous->average * (1.0 + threshold);
+        bool slowerP95 = result.p95 > previous->p95 * (1.0 + threshold);
+        if(slowerAverage || slowerP95)
+        {
+            std::cout << "Benchmark: REGRESSION " << result.scene << " " << result.mode << std::fixed << std::setprecision(3)
+                      << ": avg " << previous->average << " -> " << result.average << " ms, p95 " << previous->p95 << " -> "
+                      << result.p95 << " ms" << std::endl;
+            ++regressions;
+        }
+    }
+    return regressions;
+}
@@ -0,0 +1,84 @@
+//
+//  Benchmark.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Graphic/Graphics.h"
+
+class Application;
+class CameraPath;
+
+/// <summary> Plays a fixed camera path through every ScenePack scene in every rendering mode and reports frame times
+/// (min, average, 95th and 99th percentile) and the profiler's per-pass times as CSV and JSON.  Frames are timed
+/// around Graphics::render() and a glFinish(), with a fixed time step so every run animates the same way.  Given the
+/// CSV of an earlier run, rows whose average or 95th percentile got slower than the threshold allows count as
+/// regressions.  Runs in a headless Application.
+///
+/// Assets/Benchmarks/llvmpipe-cornell-320x240.csv is a baseline for --scene=cornell --size=320x240 --warmup=10
+/// --frames=30 on Mesa llvmpipe with one core.  Runs that small are noisy, compare against it with --threshold=0.5.
+/// </summary>
+class Benchmark
+{
+public:
+    struct Settings
+    {
+        std::string scene;                  // only this scene, empty runs all of them
+        unsigned int warmupFrames = 30;     // rendered but not timed, the first ones voxelize from scratch
+        unsigned int frames = 120;
+        unsigned int width = 1024;
+        unsigned int height = 768;
+        double deltaTime = 1.0 / 60.0;
+        std::string report = "benchmark";   // writes report.csv, report-passes.csv and report.json
+        std::string baseline;               // report.csv of an earlier run, empty skips the check
+        double threshold = 0.1;             // slowdown allowed against the baseline, 0.1 is 10%
+    };
+
+    struct Pass
+    {
+        std::string name;
+        unsigned int depth;
+        double cpu;
+        double gpu;
+    };
+
+    struct Result
+    {
+        std::string scene;
+        std::string mode;
+        unsigned int frames = 0;
+        double min = 0.0;
+        double average = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        std::vector<Pass> passes;
+    };
+
+    Benchmark(const Settings& settings);
+
+    /// <summary> Runs every scene and mode, writes the reports and returns how many rows regressed against the
+    /// baseline, or -1 when no scene matched or the baseline couldn't be read. </summary>
+    int run(Application& application);
+
+    static const char* getModeName(Graphics::RenderingMode mode);
+
+    /// <summary> Nearest rank percentile, fraction in (0, 1], times have to be sorted. </summary>
+    static double percentile(const std::vector<double>& sortedTimes, double fraction);
+
+    static bool writeCSV(const std::string& path, const std::vector<Result>& results);
+    static bool writePassesCSV(const std::string& path, const std::vector<Result>& results);
+    static bool writeJSON(const std::string& path, const std::vector<Result>& results);
+    static bool readCSV(const std::string& path, std::vector<Result>& results);
+
+    /// <summary> Prints every row that regressed and returns how many did. </summary>
+    static unsigned int compare(const std::vector<Result>& results, const std::vector<Result>& baseline, double threshold);
+
+private:
+    Result measure(Application& application, const std::string& scene, Graphics::RenderingMode mode, const CameraPath& path);
+
+private:
+    Settings settings;
+};
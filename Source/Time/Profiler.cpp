@@ -0,0 +1,277 @@
+//
+//  Profiler.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "Profiler.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <assert.h>
+
+const unsigned int Profiler::QUERY_FRAMES;
+const unsigned int Profiler::MAX_SCOPES;
+const double Profiler::SMOOTHING = 0.05;
+
+bool Profiler::enabled = true;
+bool Profiler::tracing = false;
+bool Profiler::inFrame = false;
+unsigned int Profiler::frameIndex = 0;
+unsigned int Profiler::depth = 0;
+unsigned int Profiler::droppedFrames = 0;
+unsigned int Profiler::collectedFrames = 0;
+Profiler::Frame Profiler::frames[Profiler::QUERY_FRAMES];
+std::vector<Profiler::Sample> Profiler::lastFrame;
+std::vector<Profiler::Average> Profiler::averages;
+std::vector<Profiler::Sample> Profiler::trace;
+std::chrono::steady_clock::time_point Profiler::epoch = std::chrono::steady_clock::now();
+
+Profiler::Scope::Scope(const char* name)
+{
+    sample = Profiler::open(name);
+}
+
+Profiler::Scope::~Scope()
+{
+    Profiler::close(sample);
+}
+
+double Profiler::now()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+int Profiler::open(const char* name)
+{
+    if(!inFrame) return -1;
+
+    Frame& frame = frames[frameIndex % QUERY_FRAMES];
+    if(frame.samples.size() >= MAX_SCOPES) return -1;
+
+    Sample sample;
+    sample.name = name;
+    sample.depth = depth++;
+    sample.cpuBegin = sample.cpuEnd = now() - frame.start;
+    sample.gpuBegin = sample.gpuEnd = -1.0;
+
+    int index = int(frame.samples.size());
+    frame.samples.push_back(sample);
+    glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+    return index;
+}
+
+void Profiler::close(int index)
+{
+    if(index < 0 || !inFrame) return;
+
+    Frame& frame = frames[frameIndex % QUERY_FRAMES];
+    frame.samples[index].cpuEnd = now() - frame.start;
+    glQueryCounter(frame.queries[index * 2 + 1], GL_TIMESTAMP);
+    --depth;
+}
+
+void Profiler::beginFrame()
+{
+    assert(!inFrame && "Profiler::endFrame() wasn't called for the last frame");
+    if(!enabled) return;
+
+    Frame& frame = frames[frameIndex % QUERY_FRAMES];
+    if(frame.pending)
+    {
+        collect(frame);
+    }
+    if(!frame.queriesCreated)
+    {
+        glGenQueries(MAX_SCOPES * 2, frame.queries);
+        frame.queriesCreated = true;
+    }
+
+    frame.samples.clear();
+    frame.start = now();
+    inFrame = true;
+    depth = 0;
+    open("frame");
+}
+
+void Profiler::endFrame()
+{
+    if(!inFrame) return;
+
+    close(0);
+    frames[frameIndex % QUERY_FRAMES].pending = true;
+    inFrame = false;
+    ++frameIndex;
+}
+
+void Profiler::flush()
+{
+    glFinish();
+    for(unsigned int i = 0; i < QUERY_FRAMES; ++i)
+    {
+        Frame& frame = frames[(frameIndex + i) % QUERY_FRAMES];
+        if(frame.pending)
+        {
+            collect(frame);
+        }
+    }
+}
+
+void Profiler::collect(Frame& frame)
+{
+    frame.pending = false;
+
+    //the frame's own end is the last timestamp it wrote, once that one is in so are the others
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+    {
+        ++droppedFrames;
+        return;
+    }
+
+    GLuint64 origin = 0;
+    glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &origin);
+    for(size_t i = 0; i < frame.samples.size(); ++i)
+    {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        frame.samples[i].gpuBegin = double(begin - origin) * 1e-6;
+        frame.samples[i].gpuEnd = double(end - origin) * 1e-6;
+    }
+
+    lastFrame = frame.samples;
+    accumulate(lastFrame);
+    ++collectedFrames;
+
+    if(tracing)
+    {
+        for(Sample sample : frame.samples)
+        {
+            sample.cpuBegin += frame.start;
+            sample.cpuEnd += frame.start;
+            sample.gpuBegin += frame.start;
+            sample.gpuEnd += frame.start;
+            trace.push_back(sample);
+        }
+    }
+}
+
+void Profiler::accumulate(const std::vector<Sample>& samples)
+{
+    //a pass that ran several times this frame counts once, with the times added up
+    static std::vector<Average> totals;
+    totals.clear();
+    for(const Sample& sample : samples)
+    {
+        Average* total = nullptr;
+        for(Average& candidate : totals)
+        {
+            if(candidate.name == sample.name) { total = &candidate; break; }
+        }
+        if(total == nullptr)
+        {
+            totals.push_back({ sample.name, sample.depth, 0.0, 0.0, 0.0, 0.0 });
+            total = &totals.back();
+        }
+        total->cpu += sample.cpuEnd - sample.cpuBegin;
+        total->gpu += sample.gpuEnd - sample.gpuBegin;
+        total->cpuTotal = total->cpu;
+        total->gpuTotal = total->gpu;
+    }
+
+    //passes that didn't run this frame count as zero, so the averages stay per frame.  New names go right after
+    //the name that came before them this frame, which keeps children under their parents
+    size_t insertAt = 0;
+    std::vector<bool> seen(averages.size(), false);
+    for(const Average& total : totals)
+    {
+        size_t i = 0;
+        while(i < averages.size() && averages[i].name != total.name) ++i;
+
+        if(i == averages.size())
+        {
+            i = std::min(insertAt, averages.size());
+            averages.insert(averages.begin() + i, total);
+            seen.insert(seen.begin() + i, true);
+        }
+        else
+        {
+            averages[i].cpu += (total.cpu - averages[i].cpu) * SMOOTHING;
+            averages[i].gpu += (total.gpu - averages[i].gpu) * SMOOTHING;
+            averages[i].cpuTotal += total.cpu;
+            averages[i].gpuTotal += total.gpu;
+            seen[i] = true;
+        }
+        insertAt = i + 1;
+    }
+
+    for(size_t i = 0; i < averages.size(); ++i)
+    {
+        if(seen[i]) continue;
+        averages[i].cpu -= averages[i].cpu * SMOOTHING;
+        averages[i].gpu -= averages[i].gpu * SMOOTHING;
+    }
+}
+
+void Profiler::getSummary(std::vector<std::string>& lines)
+{
+    lines.clear();
+    char buf[128];
+    for(const Average& average : averages)
+    {
+        std::snprintf(buf, sizeof(buf), "%*s%s  cpu %.2f ms  gpu %.2f ms", int(average.depth * 2), "", average.name.c_str(),
+                      average.cpu, average.gpu);
+        lines.push_back(buf);
+    }
+}
+
+void Profiler::startTrace()
+{
+    trace.clear();
+    tracing = true;
+}
+
+void Profiler::stopTrace()
+{
+    tracing = false;
+}
+
+bool Profiler::writeTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    char buf[256];
+    for(const Sample& sample : trace)
+    {
+        //trace timestamps are in microseconds
+        std::snprintf(buf, sizeof(buf), ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                      sample.name, sample.cpuBegin * 1000.0, (sample.cpuEnd - sample.cpuBegin) * 1000.0);
+        file << buf;
+        std::snprintf(buf, sizeof(buf), ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f}",
+                      sample.name, sample.gpuBegin * 1000.0, (sample.gpuEnd - sample.gpuBegin) * 1000.0);
+        file << buf;
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    if(!file)
+    {
+        std::cerr << "Profiler: could not write " << path << std::endl;
+        return false;
+    }
+    std::cout << "Profiler: wrote " << trace.size() << " samples to " << path << std::endl;
+    return true;
+}
+
+void Profiler::clear()
+{
+    lastFrame.clear();
+    averages.clear();
+    trace.clear();
+    droppedFrames = 0;
+    collectedFrames = 0;
+}
@@ -0,0 +1,120 @@
+//
+//  Profiler.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include "OpenGL_Includes.h"
+#include <string>
+#include <vector>
+#include <chrono>
+
+/// <summary> Times the passes of a frame on the CPU and, with GL_TIMESTAMP queries, on the GPU.  Queries go into a
+/// ring QUERY_FRAMES frames deep and a frame is read back only once the ring comes around to it again, so asking for
+/// results never waits on the GPU; a frame whose queries still aren't done by then is dropped instead.  Scopes nest,
+/// a pass that runs several times in a frame adds up under its name.  Work handed to OpenCL only shows up in the CPU
+/// time of the scope that waits for it. </summary>
+class Profiler
+{
+public:
+    static const unsigned int QUERY_FRAMES = 4;
+    static const unsigned int MAX_SCOPES = 64;
+
+    /// <summary> Times everything between its construction and destruction. </summary>
+    class Scope
+    {
+    public:
+        Scope(const char* name);
+        ~Scope();
+
+    private:
+        Scope(const Scope& rhs);
+        int sample;
+    };
+
+    /// <summary> One scope of a frame, times are in milliseconds from the start of the frame. gpuBegin and gpuEnd
+    /// are -1 when the GPU time isn't known. </summary>
+    struct Sample
+    {
+        const char* name;
+        unsigned int depth;
+        double cpuBegin, cpuEnd;
+        double gpuBegin, gpuEnd;
+    };
+
+    /// <summary> Rolling average of a name over the frames read back so far, and the plain sums since clear(). </summary>
+    struct Average
+    {
+        std::string name;
+        unsigned int depth;
+        double cpu;
+        double gpu;
+        double cpuTotal;
+        double gpuTotal;
+    };
+
+    static void beginFrame();
+    static void endFrame();
+
+    /// <summary> Waits for the GPU and reads back every frame still in the ring, for the end of a run. </summary>
+    static void flush();
+
+    static inline void setEnabled(bool value){ enabled = value; }
+    static inline bool isEnabled(){ return enabled; }
+
+    /// <summary> The latest frame whose GPU times are in, QUERY_FRAMES - 1 frames behind the one being drawn. </summary>
+    static inline const std::vector<Sample>& getLastFrame(){ return lastFrame; }
+    static inline const std::vector<Average>& getAverages(){ return averages; }
+    static inline unsigned int getDroppedFrames(){ return droppedFrames; }
+
+    /// <summary> Frames read back since clear(), what the totals of getAverages() divide by for a mean. </summary>
+    static inline unsigned int getCollectedFrames(){ return collectedFrames; }
+
+    /// <summary> Averages as "name  cpu x ms  gpu y ms" lines, indented by depth. </summary>
+    static void getSummary(std::vector<std::string>& lines);
+
+    /// <summary> Keeps every sample read back from now on, for writeTrace().  Everything stays in memory until
+    /// clear(). </summary>
+    static void startTrace();
+    static void stopTrace();
+    static inline bool isTracing(){ return tracing; }
+
+    /// <summary> Writes what was traced as a Chrome trace (chrome://tracing, Perfetto), CPU and GPU on their own
+    /// rows.  GPU rows are lined up with the CPU start of their frame, the clocks aren't otherwise related. </summary>
+    static bool writeTrace(const std::string& path);
+
+    /// <summary> Forgets averages, totals and the trace.  Frames still in the ring are read back as usual. </summary>
+    static void clear();
+
+private:
+    struct Frame
+    {
+        std::vector<Sample> samples;
+        GLuint queries[MAX_SCOPES * 2];
+        bool queriesCreated = false;
+        bool pending = false;
+        double start = 0.0;
+    };
+
+    static int open(const char* name);
+    static void close(int sample);
+    static double now();
+    static void collect(Frame& frame);
+    static void accumulate(const std::vector<Sample>& samples);
+
+    static const double SMOOTHING;
+
+    static bool enabled;
+    static bool tracing;
+    static bool inFrame;
+    static unsigned int frameIndex;
+    static unsigned int depth;
+    static unsigned int droppedFrames;
+    static unsigned int collectedFrames;
+    static Frame frames[QUERY_FRAMES];
+    static std::vector<Sample> lastFrame;
+    static std::vector<Average> averages;
+    static std::vector<Sample> trace;
+    static std::chrono::steady_clock::time_point epoch;
+};
@@ -0,0 +1,114 @@
+//
+//  SliceScheduler.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "SliceScheduler.h"
+#include <algorithm>
+#include <assert.h>
+
+const unsigned int SliceScheduler::MAX_PENDING;
+const double SliceScheduler::SMOOTHING = 0.25;
+
+SliceScheduler::SliceScheduler(unsigned int kinds):
+estimates(kinds, 0.0),
+measured(kinds, false)
+{
+}
+
+SliceScheduler::~SliceScheduler()
+{
+    if(!queriesCreated) return;
+
+    for(const Pending& slice : pending)
+    {
+        freeQueries.push_back(slice.queries[0]);
+        freeQueries.push_back(slice.queries[1]);
+    }
+    glDeleteQueries(GLsizei(freeQueries.size()), &freeQueries[0]);
+}
+
+void SliceScheduler::beginFrame()
+{
+    if(!queriesCreated)
+    {
+        freeQueries.resize(MAX_PENDING * 2);
+        glGenQueries(GLsizei(freeQueries.size()), &freeQueries[0]);
+        queriesCreated = true;
+    }
+
+    //slices finish in the order they were sent, the first one still running means the rest are too
+    size_t done = 0;
+    for(; done < pending.size(); ++done)
+    {
+        Pending& slice = pending[done];
+        GLint available = 0;
+        glGetQueryObjectiv(slice.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available) break;
+
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(slice.queries[0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(slice.queries[1], GL_QUERY_RESULT, &end);
+        record(slice.kind, std::max(slice.cpu, double(end - begin) * 1e-6));
+
+        freeQueries.push_back(slice.queries[0]);
+        freeQueries.push_back(slice.queries[1]);
+    }
+    pending.erase(pending.begin(), pending.begin() + done);
+
+    spent = 0.0;
+    slicesThisFrame = 0;
+}
+
+bool SliceScheduler::fits(unsigned int kind) const
+{
+    assert(kind < estimates.size());
+    return budget <= 0.0 || slicesThisFrame == 0 || spent + estimates[kind] <= budget;
+}
+
+void SliceScheduler::beginSlice(unsigned int kind)
+{
+    assert(kind < estimates.size());
+    currentKind = kind;
+    currentStart = std::chrono::steady_clock::now();
+
+    //out of queries the slice is timed on the CPU only
+    currentQueries[0] = currentQueries[1] = 0;
+    if(freeQueries.size() >= 2)
+    {
+        currentQueries[1] = freeQueries.back();
+        freeQueries.pop_back();
+        currentQueries[0] = freeQueries.back();
+        freeQueries.pop_back();
+        glQueryCounter(currentQueries[0], GL_TIMESTAMP);
+    }
+}
+
+void SliceScheduler::endSlice()
+{
+    double cpu = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - currentStart).count();
+    if(currentQueries[0] != 0)
+    {
+        glQueryCounter(currentQueries[1], GL_TIMESTAMP);
+        pending.push_back({ currentKind, cpu, { currentQueries[0], currentQueries[1] } });
+    }
+    else
+    {
+        record(currentKind, cpu);
+    }
+
+    //until the GPU time comes back the estimate is the best guess of what this slice cost
+    spent += std::max(estimates[currentKind], cpu);
+    ++slicesThisFrame;
+}
+
+void SliceScheduler::record(unsigned int kind, double milliseconds)
+{
+    if(!measured[kind])
+    {
+        estimates[kind] = milliseconds;
+        measured[kind] = true;
+        return;
+    }
+    estimates[kind] += (milliseconds - estimates[kind]) * SMOOTHING;
+}
@@ -0,0 +1,66 @@
+//
+//  SliceScheduler.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include "OpenGL_Includes.h"
+#include <vector>
+#include <chrono>
+
+/// <summary> Spreads work cut into slices over frames under a time budget.  A frame runs slices while the estimated
+/// cost of the next one still fits in what's left of the budget, and always runs at least one so the work moves
+/// forward however small the budget is.  Estimates are running averages per kind of slice of the larger of the CPU
+/// time and the GPU time, the GPU time read back from GL_TIMESTAMP queries once the GPU got to them, never waiting
+/// for it.  Work handed to OpenCL shows up in the CPU time, ComputeShader::run waits for it. </summary>
+class SliceScheduler
+{
+public:
+    static const unsigned int MAX_PENDING = 32;
+
+    SliceScheduler(unsigned int kinds);
+    ~SliceScheduler();
+
+    /// <summary> Milliseconds a frame may spend on slices, 0 runs everything the frame asks for. </summary>
+    inline void setBudget(double milliseconds){ budget = milliseconds; }
+    inline double getBudget() const { return budget; }
+
+    /// <summary> Reads back the slices the GPU finished and starts a new frame's budget. </summary>
+    void beginFrame();
+
+    /// <summary> Whether a slice of this kind still fits in this frame. </summary>
+    bool fits(unsigned int kind) const;
+
+    /// <summary> Times everything between the two calls as one slice of the kind. </summary>
+    void beginSlice(unsigned int kind);
+    void endSlice();
+
+    inline double getEstimate(unsigned int kind) const { return estimates[kind]; }
+
+private:
+    struct Pending
+    {
+        unsigned int kind;
+        double cpu;
+        GLuint queries[2];
+    };
+
+    void record(unsigned int kind, double milliseconds);
+
+    static const double SMOOTHING;
+
+    double budget = 0.0;
+    double spent = 0.0;
+    unsigned int slicesThisFrame = 0;
+    std::vector<double> estimates;
+    std::vector<bool> measured;
+
+    unsigned int currentKind = 0;
+    GLuint currentQueries[2] = {0, 0};
+    std::chrono::steady_clock::time_point currentStart;
+
+    std::vector<Pending> pending;
+    std::vector<GLuint> freeQueries;
+    bool queriesCreated = false;
+};
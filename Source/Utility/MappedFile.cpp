@@ -0,0 +1,102 @@
+//
+//  MappedFile.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "MappedFile.h"
+#include <fstream>
+#include <sys/stat.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#if !defined(_WIN32)
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0) return false;
+
+    struct stat info;
+    if(fstat(descriptor, &info) != 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+
+    size = size_t(info.st_size);
+    if(size > 0)
+    {
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(address == MAP_FAILED)
+        {
+            ::close(descriptor);
+            size = 0;
+            return false;
+        }
+        data = static_cast<const unsigned char*>(address);
+        mapped = true;
+    }
+    //the mapping keeps the file alive on its own
+    ::close(descriptor);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file) return false;
+
+    buffer.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    if(!file) return false;
+
+    data = buffer.empty() ? nullptr : buffer.data();
+    size = buffer.size();
+#endif
+
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#if !defined(_WIN32)
+    if(mapped)
+    {
+        munmap(const_cast<unsigned char*>(data), size);
+    }
+#endif
+    buffer.clear();
+    data = nullptr;
+    size = 0;
+    opened = false;
+    mapped = false;
+}
+
+bool MappedFile::getInfo(const std::string& path, uint64_t& size, int64_t& modificationTime)
+{
+    struct stat info;
+    if(stat(path.c_str(), &info) != 0) return false;
+
+    size = uint64_t(info.st_size);
+    modificationTime = int64_t(info.st_mtime);
+    return true;
+}
+
+uint64_t MappedFile::hash(const unsigned char* data, size_t size)
+{
+    uint64_t value = 14695981039346656037ull;
+    for(size_t i = 0; i < size; ++i)
+    {
+        value ^= data[i];
+        value *= 1099511628211ull;
+    }
+    return value;
+}
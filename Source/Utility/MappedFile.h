@@ -0,0 +1,43 @@
+//
+//  MappedFile.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/// <summary> A whole file mapped read only, unmapped when this goes away.  Where there's no mmap the file is read into
+/// memory instead, callers can't tell the difference. </summary>
+class MappedFile
+{
+public:
+    MappedFile(){}
+    ~MappedFile();
+
+    /// <summary> Maps the file, false if it can't be opened.  An empty file maps fine with a null getData(). </summary>
+    bool open(const std::string& path);
+    void close();
+
+    inline const unsigned char* getData() const { return data; }
+    inline size_t getSize() const { return size; }
+    inline bool isOpen() const { return opened; }
+
+    /// <summary> Size and last modification time in seconds without opening the file, false if it doesn't exist. </summary>
+    static bool getInfo(const std::string& path, uint64_t& size, int64_t& modificationTime);
+
+    /// <summary> FNV-1a, 64 bits. </summary>
+    static uint64_t hash(const unsigned char* data, size_t size);
+
+private:
+    MappedFile(const MappedFile& rhs);
+    MappedFile& operator=(const MappedFile& rhs);
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+    bool mapped = false;
+    std::vector<unsigned char> buffer;
+};
@@ -0,0 +1,207 @@
+//
+//  MeshCache.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "Shape/Shape.h"
+#include "Shape/Mesh.h"
+#include "Shape/VertexData.h"
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <limits>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<VertexData>::value, "vertices go to the cache and back as raw bytes");
+
+const uint32_t MeshCache::VERSION;
+const uint64_t MeshCache::ALIGNMENT;
+const char MeshCache::MAGIC[4] = { 'V', 'C', 'T', 'M' };
+
+namespace
+{
+    uint64_t align(uint64_t offset, uint64_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+}
+
+Shape* MeshCache::load(const std::string& sourcePath)
+{
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if(!MappedFile::getInfo(sourcePath, sourceSize, sourceTime)) return nullptr;
+
+    std::string cachePath = getCachePath(sourcePath);
+    MappedFile cache;
+    if(!cache.open(cachePath) || cache.getSize() < sizeof(Header)) return nullptr;
+
+    Header header;
+    memcpy(&header, cache.getData(), sizeof(Header));
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.vertexSize != sizeof(VertexData) ||
+       header.sourceSize != sourceSize)
+    {
+        return nullptr;
+    }
+
+    if(header.sourceModificationTime != sourceTime)
+    {
+        MappedFile source;
+        if(!source.open(sourcePath) || MappedFile::hash(source.getData(), source.getSize()) != header.sourceHash)
+        {
+            return nullptr;
+        }
+
+        //same contents, only touched: remember the new time so the next start doesn't hash again
+        std::fstream file(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offsetof(Header, sourceModificationTime));
+        file.write(reinterpret_cast<const char*>(&sourceTime), sizeof(sourceTime));
+    }
+
+    uint64_t tableEnd = sizeof(Header) + uint64_t(header.meshCount) * sizeof(MeshEntry);
+    if(tableEnd > cache.getSize()) return nullptr;
+
+    std::vector<MeshEntry> entries(header.meshCount);
+    if(header.meshCount > 0)
+    {
+        memcpy(&entries[0], cache.getData() + sizeof(Header), entries.size() * sizeof(MeshEntry));
+    }
+    for(const MeshEntry& entry : entries)
+    {
+        //counts are checked against what's left of the file before they're multiplied, so they can't wrap around
+        uint64_t vertexRoom = entry.vertexOffset <= cache.getSize() ? (cache.getSize() - entry.vertexOffset) / sizeof(VertexData) : 0;
+        uint64_t indexRoom = entry.indexOffset <= cache.getSize() ? (cache.getSize() - entry.indexOffset) / sizeof(unsigned int) : 0;
+        if(entry.vertexCount > vertexRoom || entry.indexCount > indexRoom || entry.vertexOffset % ALIGNMENT != 0 ||
+           entry.indexOffset % ALIGNMENT != 0)
+        {
+            std::cerr << "MeshCache: " << cachePath << " is damaged, parsing the model instead." << std::endl;
+            return nullptr;
+        }
+    }
+
+    std::vector<Mesh*> meshes;
+    meshes.reserve(entries.size());
+    for(const MeshEntry& entry : entries)
+    {
+        const VertexData* vertices = reinterpret_cast<const VertexData*>(cache.getData() + entry.vertexOffset);
+        const unsigned int* indices = reinterpret_cast<const unsigned int*>(cache.getData() + entry.indexOffset);
+        MeshOptimizer::Result optimization;
+        optimization.verticesBefore = size_t(entry.verticesBefore);
+        optimization.verticesAfter = size_t(entry.verticesAfter);
+        optimization.before.acmr = entry.acmrBefore;
+        optimization.after.acmr = entry.acmrAfter;
+        optimization.before.atvr = entry.atvrBefore;
+        optimization.after.atvr = entry.atvrAfter;
+        
+        Mesh* mesh = new Mesh(vertices, size_t(entry.vertexCount), indices, size_t(entry.indexCount), optimization);
+        mesh->name.assign(entry.name, strnlen(entry.name, sizeof(entry.name)));
+        mesh->printOptimization();
+        meshes.push_back(mesh);
+    }
+
+    glm::vec3 boundsMin(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    glm::vec3 boundsMax(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    return new Shape(meshes, boundsMin, boundsMax);
+}
+
+bool MeshCache::write(const std::string& sourcePath, const Shape& shape)
+{
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.vertexSize = sizeof(VertexData);
+    header.meshCount = (uint32_t)shape.meshes.size();
+
+    {
+        MappedFile source;
+        if(!MappedFile::getInfo(sourcePath, header.sourceSize, header.sourceModificationTime) || !source.open(sourcePath))
+        {
+            return false;
+        }
+        header.sourceHash = MappedFile::hash(source.getData(), source.getSize());
+    }
+
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    std::vector<MeshEntry> entries(shape.meshes.size());
+    uint64_t offset = align(sizeof(Header) + entries.size() * sizeof(MeshEntry), ALIGNMENT);
+    for(size_t i = 0; i < shape.meshes.size(); ++i)
+    {
+        const Mesh* mesh = shape.meshes[i];
+        for(const VertexData& vertex : mesh->getVertexData())
+        {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+
+        entries[i].vertexOffset = offset;
+        entries[i].vertexCount = mesh->getVertexData().size();
+        offset = align(offset + entries[i].vertexCount * sizeof(VertexData), ALIGNMENT);
+        entries[i].indexOffset = offset;
+        entries[i].indexCount = mesh->getIndices().size();
+        offset = align(offset + entries[i].indexCount * sizeof(unsigned int), ALIGNMENT);
+
+        const MeshOptimizer::Result& optimization = mesh->getOptimization();
+        entries[i].verticesBefore = optimization.verticesBefore;
+        entries[i].verticesAfter = optimization.verticesAfter;
+        entries[i].acmrBefore = optimization.before.acmr;
+        entries[i].acmrAfter = optimization.after.acmr;
+        entries[i].atvrBefore = optimization.before.atvr;
+        entries[i].atvrAfter = optimization.after.atvr;
+        memset(entries[i].name, 0, sizeof(entries[i].name));
+        mesh->name.copy(entries[i].name, sizeof(entries[i].name) - 1);
+    }
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        header.boundsMin[axis] = boundsMin[axis];
+        header.boundsMax[axis] = boundsMax[axis];
+    }
+
+    //written aside and renamed over the old one, a crash halfway never leaves a cache that looks valid
+    std::string cachePath = getCachePath(sourcePath);
+    std::string temporaryPath = cachePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        static const char padding[ALIGNMENT] = {};
+        auto pad = [&file](uint64_t to)
+        {
+            uint64_t position = uint64_t(file.tellp());
+            file.write(padding, std::streamsize(to - position));
+        };
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        if(!entries.empty())
+        {
+            file.write(reinterpret_cast<const char*>(&entries[0]), entries.size() * sizeof(MeshEntry));
+        }
+        for(size_t i = 0; i < shape.meshes.size(); ++i)
+        {
+            const Mesh* mesh = shape.meshes[i];
+            pad(entries[i].vertexOffset);
+            file.write(reinterpret_cast<const char*>(mesh->getVertexData().data()), mesh->getVertexData().size() * sizeof(VertexData));
+            pad(entries[i].indexOffset);
+            file.write(reinterpret_cast<const char*>(mesh->getIndices().data()), mesh->getIndices().size() * sizeof(unsigned int));
+        }
+
+        if(!file)
+        {
+            std::cerr << "MeshCache: could not write " << cachePath << std::endl;
+            file.close();
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+
+    if(std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::cerr << "MeshCache: could not write " << cachePath << std::endl;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+//
+//  MeshCache.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+class Shape;
+
+/// <summary> Binary copy of a parsed model, written next to it as model.obj.meshcache so the next start maps it instead
+/// of parsing text.  The file is a header, a table with one entry per mesh and the meshes' VertexData and indices
+/// exactly as they go to the GPU, every blob 16 byte aligned.  A cache counts while the model's size and modification
+/// time are the ones it was written from; when the time differs, the model's contents are hashed and a matching hash
+/// keeps the cache too (and stamps the new time into it), so a checkout touching every file doesn't throw it away.
+/// Caches from another VERSION or another VertexData layout are ignored. </summary>
+class MeshCache
+{
+public:
+    //2: meshes are stored after MeshOptimizer
+    //3: entries keep the mesh's name and what MeshOptimizer did to it, so a cached load prints the same statistics
+    static const uint32_t VERSION = 3;
+
+    static inline std::string getCachePath(const std::string& sourcePath){ return sourcePath + ".meshcache"; }
+
+    /// <summary> The model's meshes from its cache, nullptr when there's no cache or it's out of date. </summary>
+    static Shape* load(const std::string& sourcePath);
+
+    /// <summary> Writes the cache of a model parsed from sourcePath, false if the model or the cache can't be
+    /// accessed. </summary>
+    static bool write(const std::string& sourcePath, const Shape& shape);
+
+private:
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t vertexSize;
+        uint32_t meshCount;
+        uint64_t sourceSize;
+        int64_t sourceModificationTime;
+        uint64_t sourceHash;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct MeshEntry
+    {
+        uint64_t vertexOffset;
+        uint64_t vertexCount;
+        uint64_t indexOffset;
+        uint64_t indexCount;
+        uint64_t verticesBefore;
+        uint64_t verticesAfter;
+        float acmrBefore;
+        float acmrAfter;
+        float atvrBefore;
+        float atvrAfter;
+        char name[64];  //truncated, always terminated
+    };
+
+    static const uint64_t ALIGNMENT = 16;
+    static const char MAGIC[4];
+};
@@ -1,11 +1,16 @@
 
 
 #define __UTILITY_LOG_LOADING_TIME true
+
+//keep a binary copy of every parsed model next to it and map that instead of parsing the text again, see MeshCache.h
+#define __UTILITY_MESH_CACHE 1
+
+//parse models on every core with ObjParser instead of tinyobjloader's single threaded LoadObj, see ObjParser.h
+#define __UTILITY_PARALLEL_OBJ_PARSER 1
 
 #if __UTILITY_LOG_LOADING_TIME
 
 #include <iostream>
-#include <iomanip>
 #include "OpenGL_Includes.h"
 
 #include "Time/FrameRate.h"
@@ -22,6 +27,8 @@
 #include "External/tiny_obj/tiny_obj_loader.h"
 #include "Shape/VertexData.h"
 #include "Shape/Mesh.h"
+#include "Utility/MeshCache.h"
+#include "Utility/ObjParser.h"
 
 Shape * ObjLoader::loadShapeFromObj(const std::string &path)
 {
@@ -30,9 +37,23 @@ Shape * ObjLoader::loadShapeFromObj(const std::string &path)
 #if __UTILITY_LOG_LOADING_TIME
     double logTimestamp = glfwGetTime();
     double took;
+    std::streamsize precision = std::cout.precision(4);
     std::cout << "Loading obj '" << assetPath << "'..." << std::endl;
 #endif
     
+#if __UTILITY_MESH_CACHE
+    Shape * cached = MeshCache::load(assetPath);
+    if(cached != nullptr)
+    {
+#if __UTILITY_LOG_LOADING_TIME
+        took = glfwGetTime() - logTimestamp;
+        std::cout << " - Loading '" << assetPath << "' from its mesh cache took " << took << " seconds." << std::endl;
+        std::cout.precision(precision);
+#endif
+        return cached;
+    }
+#endif
+    
     
     RawObjData rawObjData;
 	
@@ -41,15 +62,27 @@ Shape * ObjLoader::loadShapeFromObj(const std::string &path)
 
 #if __UTILITY_LOG_LOADING_TIME
     took = glfwGetTime() - logTimestamp;
-    std::cout << std::setprecision(4) << " - Parsing '" << assetPath << "' took " << took << " seconds (by tinyobjloader)." << std::endl;
+#if __UTILITY_PARALLEL_OBJ_PARSER
+    std::cout << " - Parsing '" << assetPath << "' took " << took << " seconds (by ObjParser)." << std::endl;
+#else
+    std::cout << " - Parsing '" << assetPath << "' took " << took << " seconds (by tinyobjloader)." << std::endl;
+#endif
     logTimestamp = glfwGetTime();
 #endif
     
     Shape * result = new Shape(rawObjData.shapes);
+    
+#if __UTILITY_MESH_CACHE
+    if(!result->meshes.empty())
+    {
+        MeshCache::write(assetPath, *result);
+    }
+#endif
 
 #if __UTILITY_LOG_LOADING_TIME
 	took = glfwGetTime() - logTimestamp;
-	std::cout << std::setprecision(4) << " - Loading '" << assetPath << "' took " << took << " seconds." << std::endl;
+	std::cout << " - Loading '" << assetPath << "' took " << took << " seconds." << std::endl;
+	std::cout.precision(precision);
 #endif
 	return result;
 }
@@ -60,7 +93,11 @@ void ObjLoader::loadRawObjData(const std::string &path, ObjLoader::RawObjData &r
 
     
     std::string err;
+#if __UTILITY_PARALLEL_OBJ_PARSER
+    if (!ObjParser::load(rawObjData.shapes, rawObjData.materials, err, assetPath) || rawObjData.shapes.size() == 0) {
+#else
     if (!tinyobj::LoadObj(rawObjData.shapes, rawObjData.materials, err, assetPath.c_str()) || rawObjData.shapes.size() == 0) {
+#endif
 #if __UTILITY_LOG_LOADING_TIME
         std::cerr << "Failed to load object with path '" << assetPath << "'. Error message:" << std::endl << err << std::endl;
 #endif
@@ -6,7 +6,7 @@
 class ObjLoader : public AssetStore{
 public:
 	/// <summary> Loads an .obj-file into a Shape object. </summary>
-	static Shape * loadShapeFromObj(const std::string &path = "Assets\\Models\\teapot.obj");
+	static Shape * loadShapeFromObj(const std::string &path = "/Assets/Models/teapot.obj");
 
     
     struct RawObjData
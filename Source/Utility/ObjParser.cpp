@@ -0,0 +1,605 @@
+//
+//  ObjParser.cpp
+//  voxel-cone-tracing-mac
+//
+
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "glm/glm.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <cmath>
+#include <assert.h>
+
+const size_t ObjParser::MIN_CHUNK_SIZE;
+
+namespace
+{
+    inline bool isSpace(char c){ return c == ' ' || c == '\t'; }
+    inline bool isDigit(char c){ return (unsigned int)(c - '0') < 10u; }
+
+    //the character at token + offset, or the terminator tinyobj would have seen past the end of the line
+    inline char peek(const char* token, const char* end, size_t offset)
+    {
+        return token + offset < end ? token[offset] : '\0';
+    }
+
+    inline void skipSpaces(const char*& token, const char* end)
+    {
+        while(token < end && isSpace(*token)) ++token;
+    }
+
+    inline const char* findAny(const char* token, const char* end, const char* characters)
+    {
+        while(token < end && strchr(characters, *token) == nullptr) ++token;
+        return token;
+    }
+
+    //first word after the keyword, what tinyobj's sscanf("%s") reads
+    std::string parseName(const char* token, const char* end)
+    {
+        skipSpaces(token, end);
+        return std::string(token, findAny(token, end, " \t\r"));
+    }
+
+    //parses what tinyobj's tryParseDouble parses, 0 where it fails, but without a pow() per digit: up to 19 digits
+    //go into an integer that's scaled once by an exact power of ten, so the only rounding is the one to double.
+    //Exponents past the table fall back to pow(), they don't show up in models.
+    float parseFloat(const char*& token, const char* end)
+    {
+        static const double POWERS[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14,
+                                         1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        skipSpaces(token, end);
+        const char* s = token;
+        token = findAny(token, end, " \t\r");
+
+        bool negative = false;
+        if(s < token && (*s == '+' || *s == '-'))
+        {
+            negative = *s == '-';
+            ++s;
+        }
+
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool parsed = false;
+        for(; s < token && isDigit(*s); ++s, parsed = true)
+        {
+            if(digits < 19)
+            {
+                mantissa = mantissa * 10 + uint64_t(*s - '0');
+                digits += mantissa != 0;
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+        if(s < token && *s == '.')
+        {
+            for(++s; s < token && isDigit(*s); ++s, parsed = true)
+            {
+                if(digits < 19)
+                {
+                    mantissa = mantissa * 10 + uint64_t(*s - '0');
+                    digits += mantissa != 0;
+                    --exponent;
+                }
+            }
+        }
+        if(!parsed) return 0.0f;
+
+        if(s < token && (*s == 'e' || *s == 'E'))
+        {
+            ++s;
+            bool negativeExponent = false;
+            if(s < token && (*s == '+' || *s == '-'))
+            {
+                negativeExponent = *s == '-';
+                ++s;
+            }
+            if(s >= token || !isDigit(*s)) return 0.0f;
+
+            int value = 0;
+            for(; s < token && isDigit(*s); ++s)
+            {
+                value = std::min(value * 10 + (*s - '0'), 100000);
+            }
+            exponent += negativeExponent ? -value : value;
+        }
+
+        double result = double(mantissa);
+        if(exponent >= 0)
+        {
+            result = exponent <= 22 ? result * POWERS[exponent] : result * std::pow(10.0, double(exponent));
+        }
+        else
+        {
+            result = exponent >= -22 ? result / POWERS[-exponent] : result * std::pow(10.0, double(exponent));
+        }
+        return float(negative ? -result : result);
+    }
+
+    //atoi() of an index, then past it like tinyobj's strcspn("/ \t\r")
+    int parseIndex(const char*& token, const char* end)
+    {
+        bool negative = false;
+        if(token < end && (*token == '+' || *token == '-'))
+        {
+            negative = *token == '-';
+            ++token;
+        }
+        int value = 0;
+        for(; token < end && isDigit(*token); ++token)
+        {
+            value = value * 10 + (*token - '0');
+        }
+        token = findAny(token, end, "/ \t\r");
+        return negative ? -value : value;
+    }
+}
+
+void ObjParser::parseChunk(const char* begin, const char* end, Chunk& chunk)
+{
+    //a line is about 30 bytes, a guess that saves most of the regrowing
+    size_t lines = size_t(end - begin) / 32;
+    chunk.v.reserve(lines * 3);
+    chunk.corners.reserve(lines * 3);
+    chunk.faceEnds.reserve(lines);
+
+    const char* line = begin;
+    while(line < end)
+    {
+        //lines end in \n, \r\n or a lone \r like safeGetline reads them, \r\n just adds an empty line
+        const char* lineEnd = line;
+        while(lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r') ++lineEnd;
+        parseLine(line, lineEnd, chunk);
+        line = lineEnd + 1;
+    }
+}
+
+void ObjParser::parseLine(const char* token, const char* end, Chunk& chunk)
+{
+    skipSpaces(token, end);
+    if(token >= end || token[0] == '#') return;
+
+    char first = token[0], second = peek(token, end, 1), third = peek(token, end, 2);
+    if(first == 'v' && isSpace(second))
+    {
+        token += 2;
+        float x = parseFloat(token, end), y = parseFloat(token, end), z = parseFloat(token, end);
+        chunk.v.insert(chunk.v.end(), { x, y, z });
+        return;
+    }
+    if(first == 'v' && second == 'n' && isSpace(third))
+    {
+        token += 3;
+        float x = parseFloat(token, end), y = parseFloat(token, end), z = parseFloat(token, end);
+        chunk.vn.insert(chunk.vn.end(), { x, y, z });
+        return;
+    }
+    if(first == 'v' && second == 't' && isSpace(third))
+    {
+        token += 3;
+        float x = parseFloat(token, end), y = parseFloat(token, end);
+        chunk.vt.insert(chunk.vt.end(), { x, y });
+        return;
+    }
+
+    if(first == 'f' && isSpace(second))
+    {
+        //relative indices count back from the vertices this chunk has seen so far, load() adds the ones before it
+        int counts[3] = { int(chunk.v.size() / 3), int(chunk.vt.size() / 2), int(chunk.vn.size() / 3) };
+        auto resolve = [&counts](int index, unsigned int slot, Corner& corner)
+        {
+            if(index > 0) return index - 1;
+            if(index == 0) return 0;
+            corner.relative |= 1 << slot;
+            return counts[slot] + index;
+        };
+
+        size_t firstCorner = chunk.corners.size();
+        token += 2;
+        skipSpaces(token, end);
+        while(token < end && *token != '\r')
+        {
+            //i, i/j, i//k or i/j/k
+            Corner corner;
+            corner.v = resolve(parseIndex(token, end), 0, corner);
+            if(peek(token, end, 0) == '/')
+            {
+                ++token;
+                if(peek(token, end, 0) == '/')
+                {
+                    ++token;
+                    corner.vn = resolve(parseIndex(token, end), 2, corner);
+                }
+                else
+                {
+                    corner.vt = resolve(parseIndex(token, end), 1, corner);
+                    if(peek(token, end, 0) == '/')
+                    {
+                        ++token;
+                        corner.vn = resolve(parseIndex(token, end), 2, corner);
+                    }
+                }
+            }
+            chunk.corners.push_back(corner);
+            while(token < end && (isSpace(*token) || *token == '\r')) ++token;
+        }
+
+        //points and lines make no triangles (tinyobj reads past the end of them), they're left out
+        if(chunk.corners.size() - firstCorner < 3)
+        {
+            chunk.corners.resize(firstCorner);
+            return;
+        }
+        chunk.faceEnds.push_back(chunk.corners.size());
+        return;
+    }
+
+    Command command;
+    command.face = chunk.faceEnds.size();
+    size_t length = size_t(end - token);
+    if(length > 6 && strncmp(token, "usemtl", 6) == 0 && isSpace(token[6]))
+    {
+        command.kind = Command::USE_MATERIAL;
+        command.name = parseName(token + 7, end);
+    }
+    else if(length > 6 && strncmp(token, "mtllib", 6) == 0 && isSpace(token[6]))
+    {
+        command.kind = Command::MATERIAL_LIBRARY;
+        command.name = parseName(token + 7, end);
+    }
+    else if(first == 'g' && isSpace(second))
+    {
+        command.kind = Command::GROUP;
+        command.name = parseName(token + 2, end);
+    }
+    else if(first == 'o' && isSpace(second))
+    {
+        command.kind = Command::OBJECT;
+        command.name = parseName(token + 2, end);
+    }
+    else
+    {
+        return;
+    }
+    chunk.commands.push_back(command);
+}
+
+bool ObjParser::load(std::vector<tinyobj::shape_t>& shapes, std::vector<tinyobj::material_t>& materials, std::string& err,
+                     const std::string& path, const std::string& mtlBasePath, unsigned int flags)
+{
+    shapes.clear();
+
+    MappedFile file;
+    if(!file.open(path))
+    {
+        err = "Cannot open file [" + path + "]\n";
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(file.getData());
+    size_t size = file.getSize();
+
+    //one chunk per worker, cut after the first line end past an even split
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(Parallel::workerCount(), size / MIN_CHUNK_SIZE));
+    std::vector<const char*> bounds(chunkCount + 1, data);
+    bounds[chunkCount] = data + size;
+    for(size_t i = 1; i < chunkCount; ++i)
+    {
+        const char* cut = std::max(bounds[i - 1], data + size / chunkCount * i);
+        const char* lineEnd = static_cast<const char*>(memchr(cut, '\n', size_t(data + size - cut)));
+        bounds[i] = lineEnd != nullptr ? lineEnd + 1 : data + size;
+    }
+
+    std::vector<Chunk> chunks(chunkCount);
+    Parallel::forRange(0, chunkCount, [&bounds, &chunks](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; ++i)
+        {
+            parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+        }
+    });
+
+    //the chunks' vertices back to back, the offsets are how many came before each chunk
+    std::vector<float> v, vn, vt;
+    std::vector<int> offsets(chunkCount * 3);
+    {
+        size_t sizes[3] = { 0, 0, 0 };
+        for(size_t i = 0; i < chunkCount; ++i)
+        {
+            offsets[i * 3 + 0] = int(sizes[0] / 3);
+            offsets[i * 3 + 1] = int(sizes[1] / 2);
+            offsets[i * 3 + 2] = int(sizes[2] / 3);
+            sizes[0] += chunks[i].v.size();
+            sizes[1] += chunks[i].vt.size();
+            sizes[2] += chunks[i].vn.size();
+        }
+        v.reserve(sizes[0]);
+        vt.reserve(sizes[1]);
+        vn.reserve(sizes[2]);
+        for(Chunk& chunk : chunks)
+        {
+            v.insert(v.end(), chunk.v.begin(), chunk.v.end());
+            vt.insert(vt.end(), chunk.vt.begin(), chunk.vt.end());
+            vn.insert(vn.end(), chunk.vn.begin(), chunk.vn.end());
+            std::vector<float>().swap(chunk.v);
+            std::vector<float>().swap(chunk.vt);
+            std::vector<float>().swap(chunk.vn);
+        }
+    }
+
+    //replays the file the way tinyobj::LoadObj walks it: usemtl flushes the faces so far into the current shape,
+    //g and o flush them and start a new shape, which is only kept when that last flush had faces
+    std::map<std::string, int> materialMap;
+    tinyobj::MaterialFileReader readMaterials(mtlBasePath);
+    tinyobj::shape_t shape;
+    FaceGroup group;
+    std::string name;
+    int material = -1;
+    auto flush = [&]()
+    {
+        bool exported = exportGroup(shape, group, v, vn, vt, material, name, flags, err);
+        group.corners.clear();
+        group.faceEnds.clear();
+        return exported;
+    };
+
+    for(size_t c = 0; c < chunkCount; ++c)
+    {
+        const Chunk& chunk = chunks[c];
+        const int* offset = &offsets[c * 3];
+        size_t command = 0;
+        for(size_t face = 0; face <= chunk.faceEnds.size(); ++face)
+        {
+            for(; command < chunk.commands.size() && chunk.commands[command].face == face; ++command)
+            {
+                const Command& current = chunk.commands[command];
+                switch(current.kind)
+                {
+                    case Command::USE_MATERIAL:
+                    {
+                        std::map<std::string, int>::const_iterator found = materialMap.find(current.name);
+                        int newMaterial = found != materialMap.end() ? found->second : -1;
+                        if(newMaterial != material)
+                        {
+                            flush();
+                            material = newMaterial;
+                        }
+                        break;
+                    }
+                    case Command::MATERIAL_LIBRARY:
+                    {
+                        std::string materialErr;
+                        bool read = readMaterials(current.name, materials, materialMap, materialErr);
+                        err += materialErr;
+                        if(!read) return false;
+                        break;
+                    }
+                    case Command::GROUP:
+                    case Command::OBJECT:
+                        if(flush())
+                        {
+                            shapes.push_back(shape);
+                        }
+                        shape = tinyobj::shape_t();
+                        name = current.name;
+                        break;
+                }
+            }
+            if(face == chunk.faceEnds.size()) break;
+
+            size_t begin = face == 0 ? 0 : chunk.faceEnds[face - 1];
+            for(size_t i = begin; i < chunk.faceEnds[face]; ++i)
+            {
+                Corner corner = chunk.corners[i];
+                if(corner.relative & 1) corner.v += offset[0];
+                if(corner.relative & 2) corner.vt += offset[1];
+                if(corner.relative & 4) corner.vn += offset[2];
+                corner.relative = 0;
+                group.corners.push_back(corner);
+            }
+            group.faceEnds.push_back(group.corners.size());
+        }
+    }
+
+    if(flush())
+    {
+        shapes.push_back(shape);
+    }
+    return true;
+}
+
+bool ObjParser::exportGroup(tinyobj::shape_t& shape, const FaceGroup& group, const std::vector<float>& v,
+                            const std::vector<float>& vn, const std::vector<float>& vt, int material,
+                            const std::string& name, unsigned int flags, std::string& err)
+{
+    if(group.faceEnds.empty()) return false;
+
+    struct CornerHash
+    {
+        size_t operator()(const Corner& corner) const
+        {
+            return size_t(corner.v) * 73856093u ^ size_t(corner.vt) * 19349663u ^ size_t(corner.vn) * 83492791u;
+        }
+    };
+    struct CornerEqual
+    {
+        bool operator()(const Corner& a, const Corner& b) const
+        {
+            return a.v == b.v && a.vt == b.vt && a.vn == b.vn;
+        }
+    };
+
+    //corners with the same three indices share a vertex, but only within the group like tinyobj's vertex cache
+    tinyobj::mesh_t& mesh = shape.mesh;
+    std::unordered_map<Corner, unsigned int, CornerHash, CornerEqual> welded;
+    welded.reserve(group.corners.size());
+    auto weld = [&](const Corner& corner)
+    {
+        std::pair<std::unordered_map<Corner, unsigned int, CornerHash, CornerEqual>::iterator, bool> inserted =
+            welded.insert(std::make_pair(corner, 0u));
+        if(!inserted.second) return inserted.first->second;
+
+        assert(corner.v >= 0 && v.size() > size_t(corner.v) * 3 + 2);
+        mesh.positions.insert(mesh.positions.end(), &v[size_t(corner.v) * 3], &v[size_t(corner.v) * 3] + 3);
+        if(corner.vn >= 0 && size_t(corner.vn) * 3 + 2 < vn.size())
+        {
+            mesh.normals.insert(mesh.normals.end(), &vn[size_t(corner.vn) * 3], &vn[size_t(corner.vn) * 3] + 3);
+        }
+        if(corner.vt >= 0 && size_t(corner.vt) * 2 + 1 < vt.size())
+        {
+            mesh.texcoords.insert(mesh.texcoords.end(), &vt[size_t(corner.vt) * 2], &vt[size_t(corner.vt) * 2] + 2);
+        }
+        inserted.first->second = (unsigned int)(mesh.positions.size() / 3 - 1);
+        return inserted.first->second;
+    };
+
+    bool triangulate = (flags & tinyobj::triangulation) != 0;
+    size_t begin = 0;
+    for(size_t end : group.faceEnds)
+    {
+        const Corner* face = &group.corners[begin];
+        size_t corners = end - begin;
+        begin = end;
+
+        if(triangulate)
+        {
+            //polygons become fans around their first corner
+            for(size_t k = 2; k < corners; ++k)
+            {
+                unsigned int v0 = weld(face[0]);
+                unsigned int v1 = weld(face[k - 1]);
+                unsigned int v2 = weld(face[k]);
+                mesh.indices.insert(mesh.indices.end(), { v0, v1, v2 });
+                mesh.num_vertices.push_back(3);
+                mesh.material_ids.push_back(material);
+            }
+        }
+        else
+        {
+            for(size_t k = 0; k < corners; ++k)
+            {
+                mesh.indices.push_back(weld(face[k]));
+            }
+            mesh.num_vertices.push_back((unsigned char)corners);
+            mesh.material_ids.push_back(material);
+        }
+    }
+
+    if((flags & tinyobj::calculate_normals) != 0 && mesh.normals.empty())
+    {
+        if(mesh.indices.size() % 3 == 0)
+        {
+            mesh.normals.resize(mesh.positions.size());
+            for(size_t i = 0; i < mesh.indices.size(); i += 3)
+            {
+                const float* a = &mesh.positions[mesh.indices[i] * 3];
+                const float* b = &mesh.positions[mesh.indices[i + 1] * 3];
+                const float* c = &mesh.positions[mesh.indices[i + 2] * 3];
+                glm::vec3 normal = glm::normalize(glm::cross(glm::vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]),
+                                                             glm::vec3(c[0] - a[0], c[1] - a[1], c[2] - a[2])));
+                for(size_t k = 0; k < 3; ++k)
+                {
+                    memcpy(&mesh.normals[mesh.indices[i + k] * 3], &normal[0], sizeof(float) * 3);
+                }
+            }
+        }
+        else
+        {
+            std::stringstream message;
+            message << "WARN: The shape " << name << " does not have a topology of triangles, therfore the normals "
+                       "calculation could not be performed. Select the tinyobj::triangulation flag for this object."
+                    << std::endl;
+            err += message.str();
+        }
+    }
+
+    shape.name = name;
+    return true;
+}
+
+void ObjParser::benchmark()
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const int ITERATIONS = 10;
+    const char* MODELS[] = { "bunny.obj", "cornell.obj", "cube.obj", "quad.obj", "quadn.obj", "sphere.obj", "susanne.obj",
+                             "teapot.obj" };
+
+    auto megabytesPerSecond = [](double bytes, double milliseconds)
+    {
+        return milliseconds > 0.0 ? bytes / (1024.0 * 1024.0) / (milliseconds / 1000.0) : 0.0;
+    };
+
+    double totalBytes = 0.0, totalReferenceMs = 0.0, totalParallelMs = 0.0;
+    for(const char* model : MODELS)
+    {
+        std::string path = resourceRoot + "/Assets/Models/" + model;
+        uint64_t size = 0;
+        int64_t modificationTime = 0;
+        if(!MappedFile::getInfo(path, size, modificationTime))
+        {
+            std::cerr << "obj parser: can't find " << path << std::endl;
+            continue;
+        }
+
+        std::vector<tinyobj::shape_t> reference, parsed;
+        std::vector<tinyobj::material_t> materials;
+        std::string err;
+
+        double referenceMs = 0.0;
+        for(int i = 0; i < ITERATIONS; ++i)
+        {
+            materials.clear();
+            Clock::time_point start = Clock::now();
+            tinyobj::LoadObj(reference, materials, err, path.c_str());
+            referenceMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        double parallelMs = 0.0;
+        for(int i = 0; i < ITERATIONS; ++i)
+        {
+            materials.clear();
+            Clock::time_point start = Clock::now();
+            load(parsed, materials, err, path);
+            parallelMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        //topology has to match exactly, the floats only as close as the two float parsers round
+        bool match = reference.size() == parsed.size();
+        float maxError = 0.0f;
+        for(size_t s = 0; match && s < reference.size(); ++s)
+        {
+            const tinyobj::mesh_t& a = reference[s].mesh;
+            const tinyobj::mesh_t& b = parsed[s].mesh;
+            match = reference[s].name == parsed[s].name && a.indices == b.indices && a.num_vertices == b.num_vertices &&
+                    a.material_ids == b.material_ids && a.positions.size() == b.positions.size() &&
+                    a.normals.size() == b.normals.size() && a.texcoords.size() == b.texcoords.size();
+            for(size_t i = 0; match && i < a.positions.size(); ++i) maxError = std::max(maxError, std::abs(a.positions[i] - b.positions[i]));
+            for(size_t i = 0; match && i < a.normals.size(); ++i) maxError = std::max(maxError, std::abs(a.normals[i] - b.normals[i]));
+            for(size_t i = 0; match && i < a.texcoords.size(); ++i) maxError = std::max(maxError, std::abs(a.texcoords[i] - b.texcoords[i]));
+        }
+
+        totalBytes += double(size) * ITERATIONS;
+        totalReferenceMs += referenceMs;
+        totalParallelMs += parallelMs;
+        std::cout << "obj " << model << " (" << size / 1024 << " KB): tinyobjloader " << std::fixed << std::setprecision(1)
+                  << megabytesPerSecond(double(size) * ITERATIONS, referenceMs) << " MB/s, parallel "
+                  << megabytesPerSecond(double(size) * ITERATIONS, parallelMs) << " MB/s, "
+                  << (match ? "same shapes" : "SHAPES DIFFER") << std::defaultfloat << ", max error " << maxError << std::endl;
+    }
+
+    std::cout << "obj all models: tinyobjloader " << std::fixed << std::setprecision(1)
+              << megabytesPerSecond(totalBytes, totalReferenceMs) << " MB/s, parallel "
+              << megabytesPerSecond(totalBytes, totalParallelMs) << " MB/s on " << Parallel::workerCount() << " threads"
+              << std::defaultfloat << std::endl;
+}
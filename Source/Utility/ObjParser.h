@@ -0,0 +1,68 @@
+//
+//  ObjParser.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "External/tiny_obj/tiny_obj_loader.h"
+#include "Utility/AssetStore.h"
+
+/// <summary> Drop in for tinyobj::LoadObj that maps the file and parses it on every core.  The file is cut into one
+/// chunk per worker at line ends, each worker parses its chunk's v, vn, vt and f lines into flat arrays with a float
+/// parser that skips pow() and ldexp(), and the calling thread stitches the chunks back together in file order: it
+/// offsets relative (negative) indices by the chunk's first vertex, replays g, o, usemtl and mtllib where they appeared
+/// and builds the shapes with tinyobj's grouping, per group vertex welding and fan triangulation, so Shape::loadMesh
+/// can't tell which parser ran.  't' lines (subdivision tags) are skipped, none of the assets have them. </summary>
+class ObjParser : public AssetStore
+{
+public:
+    /// <summary> Same arguments and results as tinyobj::LoadObj, false when the file can't be opened. </summary>
+    static bool load(std::vector<tinyobj::shape_t>& shapes, std::vector<tinyobj::material_t>& materials, std::string& err,
+                     const std::string& path, const std::string& mtlBasePath = "", unsigned int flags = tinyobj::triangulation);
+
+    /// <summary> Parses every model in Assets/Models with both parsers, prints each one's throughput in MB/s and
+    /// whether the shapes match. </summary>
+    static void benchmark();
+
+private:
+    //a face corner, indices are zero based like tinyobj's, -1 is missing
+    struct Corner
+    {
+        int v = -1, vt = -1, vn = -1;
+        //bit per index that counts back from the end of its chunk and needs the chunk's offset added
+        unsigned char relative = 0;
+    };
+
+    struct Command
+    {
+        enum Kind { GROUP, OBJECT, USE_MATERIAL, MATERIAL_LIBRARY };
+        Kind kind;
+        size_t face;        // how many of the chunk's faces come before it
+        std::string name;
+    };
+
+    struct Chunk
+    {
+        std::vector<float> v, vn, vt;
+        std::vector<Corner> corners;
+        std::vector<size_t> faceEnds;
+        std::vector<Command> commands;
+    };
+
+    struct FaceGroup
+    {
+        std::vector<Corner> corners;
+        std::vector<size_t> faceEnds;
+    };
+
+    static const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+    static void parseChunk(const char* begin, const char* end, Chunk& chunk);
+    static void parseLine(const char* token, const char* end, Chunk& chunk);
+    static bool exportGroup(tinyobj::shape_t& shape, const FaceGroup& group, const std::vector<float>& v,
+                            const std::vector<float>& vn, const std::vector<float>& vt, int material,
+                            const std::string& name, unsigned int flags, std::string& err);
+};
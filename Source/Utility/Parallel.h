@@ -0,0 +1,50 @@
+//
+//  Parallel.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+//splits index ranges across the cores of the machine.  The calling thread always takes the first chunk so
+//small workloads don't pay for a thread they don't need.
+class Parallel
+{
+public:
+    static inline unsigned int workerCount()
+    {
+        unsigned int count = std::thread::hardware_concurrency();
+        return count == 0 ? 1 : count;
+    }
+
+    ///<summary> Calls function(chunkBegin, chunkEnd) over [begin, end) split in at most workerCount() chunks. </summary>
+    template<typename Function>
+    static void forRange(size_t begin, size_t end, Function function, unsigned int maxWorkers = 0)
+    {
+        if(end <= begin) return;
+
+        size_t workers = maxWorkers == 0 ? workerCount() : std::min(maxWorkers, workerCount());
+        workers = std::min(workers, end - begin);
+        size_t chunk = (end - begin + workers - 1) / workers;
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers);
+        for(size_t i = 1; i < workers; ++i)
+        {
+            size_t chunkBegin = begin + i * chunk;
+            size_t chunkEnd = std::min(end, chunkBegin + chunk);
+            if(chunkBegin >= chunkEnd) break;
+            threads.emplace_back(function, chunkBegin, chunkEnd);
+        }
+
+        function(begin, std::min(end, begin + chunk));
+
+        for(std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+};
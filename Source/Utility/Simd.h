@@ -0,0 +1,104 @@
+//
+//  Simd.h
+//  voxel-cone-tracing-mac
+//
+
+#pragma once
+
+//thin four wide float wrapper, CPU side voxel code is written once against it and compiles down to SSE on intel
+//macs, NEON on arm, and plain scalar code everywhere else.
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define __SIMD_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define __SIMD_NEON 1
+#endif
+
+#include <cmath>
+
+namespace Simd
+{
+#if __SIMD_SSE
+
+    typedef __m128 float4;
+
+    inline float4 set1(float value){ return _mm_set1_ps(value); }
+    inline float4 set(float x, float y, float z, float w){ return _mm_setr_ps(x, y, z, w); }
+    inline float4 load(const float* data){ return _mm_loadu_ps(data); }
+    inline void   store(float* data, float4 value){ _mm_storeu_ps(data, value); }
+    inline float4 add(float4 a, float4 b){ return _mm_add_ps(a, b); }
+    inline float4 sub(float4 a, float4 b){ return _mm_sub_ps(a, b); }
+    inline float4 mul(float4 a, float4 b){ return _mm_mul_ps(a, b); }
+    inline float4 min(float4 a, float4 b){ return _mm_min_ps(a, b); }
+    inline float4 max(float4 a, float4 b){ return _mm_max_ps(a, b); }
+    inline float4 abs(float4 a){ return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+    //comparisons return a lane mask, all bits set where the comparison holds
+    inline float4 greaterThan(float4 a, float4 b){ return _mm_cmpgt_ps(a, b); }
+    inline float4 lessThan(float4 a, float4 b){ return _mm_cmplt_ps(a, b); }
+    inline float4 maskOr(float4 a, float4 b){ return _mm_or_ps(a, b); }
+    inline float4 maskAnd(float4 a, float4 b){ return _mm_and_ps(a, b); }
+
+    //one bit per lane, lane 0 in bit 0
+    inline int    laneBits(float4 mask){ return _mm_movemask_ps(mask); }
+
+#elif __SIMD_NEON
+
+    typedef float32x4_t float4;
+
+    inline float4 set1(float value){ return vdupq_n_f32(value); }
+    inline float4 set(float x, float y, float z, float w){ float data[4] = {x, y, z, w}; return vld1q_f32(data); }
+    inline float4 load(const float* data){ return vld1q_f32(data); }
+    inline void   store(float* data, float4 value){ vst1q_f32(data, value); }
+    inline float4 add(float4 a, float4 b){ return vaddq_f32(a, b); }
+    inline float4 sub(float4 a, float4 b){ return vsubq_f32(a, b); }
+    inline float4 mul(float4 a, float4 b){ return vmulq_f32(a, b); }
+    inline float4 min(float4 a, float4 b){ return vminq_f32(a, b); }
+    inline float4 max(float4 a, float4 b){ return vmaxq_f32(a, b); }
+    inline float4 abs(float4 a){ return vabsq_f32(a); }
+
+    inline float4 greaterThan(float4 a, float4 b){ return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+    inline float4 lessThan(float4 a, float4 b){ return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+    inline float4 maskOr(float4 a, float4 b){ return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+    inline float4 maskAnd(float4 a, float4 b){ return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+
+    inline int    laneBits(float4 mask)
+    {
+        uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+        return int(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) |
+                   (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+    }
+
+#else
+
+    struct float4 { float v[4]; };
+
+    inline float4 set1(float value){ float4 r = {{value, value, value, value}}; return r; }
+    inline float4 set(float x, float y, float z, float w){ float4 r = {{x, y, z, w}}; return r; }
+    inline float4 load(const float* data){ float4 r = {{data[0], data[1], data[2], data[3]}}; return r; }
+    inline void   store(float* data, float4 value){ for(int i = 0; i < 4; ++i) data[i] = value.v[i]; }
+
+#define __SIMD_SCALAR_OP(name, expression) \
+    inline float4 name(float4 a, float4 b){ float4 r; for(int i = 0; i < 4; ++i){ float x = a.v[i], y = b.v[i]; r.v[i] = (expression); } return r; }
+
+    __SIMD_SCALAR_OP(add, x + y)
+    __SIMD_SCALAR_OP(sub, x - y)
+    __SIMD_SCALAR_OP(mul, x * y)
+    __SIMD_SCALAR_OP(min, x < y ? x : y)
+    __SIMD_SCALAR_OP(max, x > y ? x : y)
+    __SIMD_SCALAR_OP(greaterThan, x > y ? -1.0f : 0.0f)
+    __SIMD_SCALAR_OP(lessThan, x < y ? -1.0f : 0.0f)
+    __SIMD_SCALAR_OP(maskOr, (x != 0.0f || y != 0.0f) ? -1.0f : 0.0f)
+    __SIMD_SCALAR_OP(maskAnd, (x != 0.0f && y != 0.0f) ? -1.0f : 0.0f)
+
+#undef __SIMD_SCALAR_OP
+
+    inline float4 abs(float4 a){ float4 r; for(int i = 0; i < 4; ++i) r.v[i] = std::fabs(a.v[i]); return r; }
+    inline int    laneBits(float4 mask){ int bits = 0; for(int i = 0; i < 4; ++i) bits |= (mask.v[i] != 0.0f) << i; return bits; }
+
+#endif
+
+    inline float4 madd(float4 a, float4 b, float4 c){ return add(mul(a, b), c); }
+}
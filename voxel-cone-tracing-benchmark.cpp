@@ -0,0 +1,13 @@
+#include "Source/Application.h"
+// Runs the benchmark suite headless, see Source/Time/Benchmark.h. Takes the same arguments as the app.
+int main(int argc, const char * argv[])
+{
+	Application& app = Application::getInstance();
+	app.parseArguments(argc, argv);
+	app.headless.enabled = true;
+	app.headless.benchmark = true;
+	app.init();
+	app.run();
+	return app.exitCode;
+}
+
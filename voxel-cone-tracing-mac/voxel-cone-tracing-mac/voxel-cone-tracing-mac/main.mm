@@ -14,10 +14,11 @@ int main(int argc, const char * argv[]) {
     
     printf("%s\n", argv[0]);
     Application &app = Application::getInstance();
+    app.parseArguments(argc, argv);
     app.init();
     
     app.run();
-    return 0;
+    return app.exitCode;
     
     
 }
@@ -1,8 +1,9 @@
-#include "Source\Application.h"
-int main()
+#include "Source/Application.h"
+int main(int argc, const char * argv[])
 {
+	Application::getInstance().parseArguments(argc, argv);
 	Application::getInstance().init();
 	Application::getInstance().run();
-	return 0;
+	return Application::getInstance().exitCode;
 }
 